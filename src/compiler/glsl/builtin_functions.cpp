@@ -83,6 +83,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #define M_PIf   ((float) M_PI)
 #define M_PI_2f ((float) M_PI_2)
@@ -861,7 +862,9 @@ namespace {
  * function module.
  *
  * It generates IR for every built-in function signature, and organizes them
- * into functions.
+ * into functions.  Apart from the compiler intrinsics, which the built-ins
+ * call into, functions are only generated the first time they are looked
+ * up.
  */
 class builtin_builder {
 public:
@@ -872,23 +875,42 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *get_function(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in that has been looked up so
+    * far, regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature()
+    * to filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /**
+    * What create_builtins() does with each function it comes across:
+    * nothing but recording its name in \c builtin_names, generating it only
+    * if its name is \c filter, or generating everything.
+    */
+   enum {
+      BUILD_ALL,
+      BUILD_NAMES,
+      BUILD_FILTERED,
+   } build_mode;
+   const char *filter;
+
+   /** Names of all built-in functions, generated or not. */
+   struct set *builtin_names;
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
 
+   bool want_function(const char *name);
+
    /**
     * IR builder helpers:
     *
@@ -1256,7 +1278,7 @@ enum image_function_flags {
  *  @{
  */
 builtin_builder::builtin_builder()
-   : shader(NULL)
+   : shader(NULL), build_mode(BUILD_ALL), filter(NULL), builtin_names(NULL)
 {
    mem_ctx = NULL;
 }
@@ -1279,7 +1301,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1303,14 +1325,57 @@ builtin_builder::initialize()
    mem_ctx = ralloc_context(NULL);
    create_shader();
    create_intrinsics();
+
+   /* Only collect the names of the built-ins for now; get_function()
+    * generates them on demand.
+    */
+   builtin_names = _mesa_set_create(mem_ctx, _mesa_hash_string,
+                                    _mesa_key_string_equal);
+   build_mode = BUILD_NAMES;
    create_builtins();
 }
 
+/**
+ * Look up a built-in function, generating it first if this is the first
+ * time it has been asked for.
+ */
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL || !_mesa_set_search(builtin_names, name))
+      return f;
+
+   build_mode = BUILD_FILTERED;
+   filter = name;
+   create_builtins();
+   build_mode = BUILD_NAMES;
+   filter = NULL;
+
+   return shader->symbols->get_function(name);
+}
+
+bool
+builtin_builder::want_function(const char *name)
+{
+   switch (build_mode) {
+   case BUILD_NAMES:
+      _mesa_set_add(builtin_names, name);
+      return false;
+   case BUILD_FILTERED:
+      return strcmp(name, filter) == 0;
+   default:
+      return true;
+   }
+}
+
 void
 builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   builtin_names = NULL;
+   build_mode = BUILD_ALL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1335,6 +1400,14 @@ builtin_builder::create_shader()
  * Create ir_function and ir_function_signature objects for each
  * intrinsic.
  */
+/* Skip generating the signatures of functions we don't want right now; the
+ * arguments are only evaluated if the call is made.
+ */
+#define add_function(NAME, ...) do {               \
+   if (want_function(NAME))                        \
+      add_function(NAME, __VA_ARGS__);             \
+} while (0)
+
 void
 builtin_builder::create_intrinsics()
 {
@@ -4540,6 +4613,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -4610,6 +4685,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!want_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -7702,7 +7780,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -7716,6 +7794,17 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    return ret;
 }
 
+ir_function *
+_mesa_glsl_find_builtin_function_by_name(const char *name)
+{
+   ir_function *f;
+   mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   mtx_unlock(&builtins_lock);
+
+   return f;
+}
+
 gl_shader *
 _mesa_glsl_get_builtin_function_shader()
 {
@@ -48,6 +48,13 @@ extern bool
 _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state,
                                 const char *name);
 
+extern ir_function *
+_mesa_glsl_find_builtin_function_by_name(const char *name);
+
+/**
+ * Built-in functions are generated lazily, so the shader's symbol table
+ * must not be searched directly; use the functions above instead.
+ */
 extern gl_shader *
 _mesa_glsl_get_builtin_function_shader(void);
 
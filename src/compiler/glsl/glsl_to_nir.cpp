@@ -207,6 +207,8 @@ glsl_to_nir(struct gl_context *ctx,
 
    nir_shader *shader = nir_shader_create(NULL, stage, options,
                                           &sh->Program->info);
+   if (options->use_instr_arena)
+      nir_shader_use_instr_arena(shader);
 
    nir_visitor v1(ctx, shader);
    nir_function_visitor v2(&v1);
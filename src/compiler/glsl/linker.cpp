@@ -4505,6 +4505,30 @@ linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
       }
 }
 
+struct link_stage_opt_state {
+   struct gl_context *ctx;
+   struct gl_shader_program *prog;
+};
+
+static void
+link_stage_optimisation(void *data, unsigned stage)
+{
+   struct link_stage_opt_state *state = (struct link_stage_opt_state *) data;
+   struct gl_context *ctx = state->ctx;
+   exec_list *ir = state->prog->_LinkedShaders[stage]->ir;
+
+   /* Call opts before lowering const arrays to uniforms so we can const
+    * propagate any elements accessed directly.
+    */
+   linker_optimisation_loop(ctx, ir, stage);
+
+   /* Call opts after lowering const arrays to copy propagate things. */
+   if (ctx->Const.GLSLLowerConstArrays &&
+       lower_const_arrays_to_uniforms(ir, stage,
+                                      ctx->Const.Program[stage].MaxUniformComponents))
+      linker_optimisation_loop(ctx, ir, stage);
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -4841,17 +4865,15 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
          }
       }
 
-      /* Call opts before lowering const arrays to uniforms so we can const
-       * propagate any elements accessed directly.
-       */
-      linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      /* Call opts after lowering const arrays to copy propagate things. */
-      if (ctx->Const.GLSLLowerConstArrays &&
-          lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir, i,
-                                         ctx->Const.Program[i].MaxUniformComponents))
-         linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
+   }
 
+   /* The optimization loops only touch the IR of their own stage, so the
+    * stages can be processed concurrently.
+    */
+   {
+      struct link_stage_opt_state state = { ctx, prog };
+      link_util_run_per_stage(prog->data->linked_stages,
+                              link_stage_optimisation, &state);
    }
 
    /* Validation for special cases where we allow sampler array indexing
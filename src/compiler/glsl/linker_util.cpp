@@ -26,6 +26,9 @@
 #include "linker_util.h"
 #include "util/bitscan.h"
 #include "util/set.h"
+#include "util/debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include "ir_uniform.h" /* for gl_uniform_storage */
 
 /* Utility methods shared between the GLSL IR and the NIR */
@@ -287,3 +290,80 @@ link_util_calculate_subroutine_compat(struct gl_shader_program *prog)
       }
    }
 }
+
+struct link_stage_job {
+   link_util_stage_func func;
+   void *data;
+   unsigned stage;
+   struct util_queue_fence fence;
+};
+
+static struct util_queue link_queue;
+static once_flag link_queue_once = ONCE_FLAG_INIT;
+
+static void
+link_queue_init(void)
+{
+   util_cpu_detect();
+
+   /* The calling thread always takes one stage itself. */
+   unsigned num_threads =
+      MIN2(util_cpu_caps.nr_cpus, MESA_SHADER_STAGES) - 1;
+   num_threads = MIN2(num_threads,
+                      env_var_as_unsigned("MESA_GLSL_LINK_THREADS",
+                                          num_threads));
+   if (num_threads == 0)
+      return;
+
+   /* A failed init leaves the queue uninitialized and we fall back to
+    * processing the stages serially.
+    */
+   util_queue_init(&link_queue, "glsl_link", MESA_SHADER_STAGES,
+                   num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+static void
+link_stage_execute(void *job, int thread_index)
+{
+   struct link_stage_job *j = (struct link_stage_job *) job;
+
+   j->func(j->data, j->stage);
+}
+
+void
+link_util_run_per_stage(unsigned stage_mask, link_util_stage_func func,
+                        void *data)
+{
+   if (util_bitcount(stage_mask) > 1)
+      call_once(&link_queue_once, link_queue_init);
+
+   if (!util_queue_is_initialized(&link_queue)) {
+      while (stage_mask)
+         func(data, u_bit_scan(&stage_mask));
+      return;
+   }
+
+   struct link_stage_job jobs[MESA_SHADER_STAGES];
+   unsigned first = u_bit_scan(&stage_mask);
+   unsigned queued = stage_mask;
+
+   while (stage_mask) {
+      const int i = u_bit_scan(&stage_mask);
+
+      jobs[i].func = func;
+      jobs[i].data = data;
+      jobs[i].stage = i;
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&link_queue, &jobs[i], &jobs[i].fence,
+                         link_stage_execute, NULL, 0);
+   }
+
+   func(data, first);
+
+   while (queued) {
+      const int i = u_bit_scan(&queued);
+
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
@@ -81,6 +81,21 @@ link_util_check_uniform_resources(struct gl_context *ctx,
 void
 link_util_calculate_subroutine_compat(struct gl_shader_program *prog);
 
+typedef void (*link_util_stage_func)(void *data, unsigned stage);
+
+/**
+ * Call \p func once for every stage set in \p stage_mask.
+ *
+ * The calls may run concurrently on a shared worker pool, so \p func must
+ * only touch state private to the stage it is given.  The lowest stage is
+ * always processed on the calling thread, and all calls have returned by
+ * the time this function returns.  Setting MESA_GLSL_LINK_THREADS=0 forces
+ * the stages to be processed one after another.
+ */
+void
+link_util_run_per_stage(unsigned stage_mask, link_util_stage_func func,
+                        void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -70,6 +70,24 @@ nir_shader_create(void *mem_ctx,
    return shader;
 }
 
+/**
+ * Start allocating instructions of the shader from a linear arena.
+ *
+ * Instructions that already exist are left alone; nir_sweep() moves them
+ * into the arena along with everything else.
+ */
+void
+nir_shader_use_instr_arena(nir_shader *shader)
+{
+   if (shader->instr_arena)
+      return;
+
+   /* The arena gets its own ralloc context so that it stays together when
+    * nir_shader_replace() adopts the children of a shader.
+    */
+   shader->instr_arena = linear_alloc_parent(ralloc_context(shader), 0);
+}
+
 static nir_register *
 reg_create(void *mem_ctx, struct exec_list *list)
 {
@@ -239,18 +257,20 @@ void nir_dest_copy(nir_dest *dest, const nir_dest *src, nir_instr *instr)
    dest->reg.base_offset = src->reg.base_offset;
    dest->reg.reg = src->reg.reg;
    if (src->reg.indirect) {
-      dest->reg.indirect = ralloc(instr, nir_src);
-      nir_src_copy(dest->reg.indirect, src->reg.indirect, instr);
+      void *mem_ctx = nir_instr_mem_ctx(instr);
+      dest->reg.indirect = ralloc(mem_ctx, nir_src);
+      nir_src_copy(dest->reg.indirect, src->reg.indirect, mem_ctx);
    } else {
       dest->reg.indirect = NULL;
    }
 }
 
+/* Copies an ALU source into instr, which owns any indirect source. */
 void
 nir_alu_src_copy(nir_alu_src *dest, const nir_alu_src *src,
                  nir_alu_instr *instr)
 {
-   nir_src_copy(&dest->src, &src->src, &instr->instr);
+   nir_src_copy(&dest->src, &src->src, nir_instr_mem_ctx(&instr->instr));
    dest->abs = src->abs;
    dest->negate = src->negate;
    for (unsigned i = 0; i < NIR_MAX_VEC_COMPONENTS; i++)
@@ -398,9 +418,34 @@ instr_init(nir_instr *instr, nir_instr_type type)
 {
    instr->type = type;
    instr->block = NULL;
+   instr->arena = false;
    exec_node_init(&instr->node);
 }
 
+/* Allocates a zeroed instruction, from the shader's arena if there is one.
+ * Arena instructions are preceded by a pointer to the arena so that
+ * nir_instr_mem_ctx() can find it without a shader.
+ */
+static void *
+instr_zalloc(nir_shader *shader, size_t size, nir_instr_type type)
+{
+   nir_instr *instr;
+
+   if (shader->instr_arena) {
+      void **ptr = linear_zalloc_child(shader->instr_arena,
+                                       sizeof(void *) + size);
+      ptr[0] = shader->instr_arena;
+      instr = (nir_instr *)&ptr[1];
+      instr_init(instr, type);
+      instr->arena = true;
+   } else {
+      instr = rzalloc_size(shader, size);
+      instr_init(instr, type);
+   }
+
+   return instr;
+}
+
 static void
 dest_init(nir_dest *dest)
 {
@@ -433,10 +478,10 @@ nir_alu_instr_create(nir_shader *shader, nir_op op)
    unsigned num_srcs = nir_op_infos[op].num_inputs;
    /* TODO: don't use rzalloc */
    nir_alu_instr *instr =
-      rzalloc_size(shader,
-                   sizeof(nir_alu_instr) + num_srcs * sizeof(nir_alu_src));
+      instr_zalloc(shader,
+                   sizeof(nir_alu_instr) + num_srcs * sizeof(nir_alu_src),
+                   nir_instr_type_alu);
 
-   instr_init(&instr->instr, nir_instr_type_alu);
    instr->op = op;
    alu_dest_init(&instr->dest);
    for (unsigned i = 0; i < num_srcs; i++)
@@ -449,9 +494,7 @@ nir_deref_instr *
 nir_deref_instr_create(nir_shader *shader, nir_deref_type deref_type)
 {
    nir_deref_instr *instr =
-      rzalloc_size(shader, sizeof(nir_deref_instr));
-
-   instr_init(&instr->instr, nir_instr_type_deref);
+      instr_zalloc(shader, sizeof(nir_deref_instr), nir_instr_type_deref);
 
    instr->deref_type = deref_type;
    if (deref_type != nir_deref_type_var)
@@ -469,8 +512,8 @@ nir_deref_instr_create(nir_shader *shader, nir_deref_type deref_type)
 nir_jump_instr *
 nir_jump_instr_create(nir_shader *shader, nir_jump_type type)
 {
-   nir_jump_instr *instr = ralloc(shader, nir_jump_instr);
-   instr_init(&instr->instr, nir_instr_type_jump);
+   nir_jump_instr *instr =
+      instr_zalloc(shader, sizeof(nir_jump_instr), nir_instr_type_jump);
    instr->type = type;
    return instr;
 }
@@ -480,8 +523,8 @@ nir_load_const_instr_create(nir_shader *shader, unsigned num_components,
                             unsigned bit_size)
 {
    nir_load_const_instr *instr =
-      rzalloc_size(shader, sizeof(*instr) + num_components * sizeof(*instr->value));
-   instr_init(&instr->instr, nir_instr_type_load_const);
+      instr_zalloc(shader, sizeof(*instr) + num_components * sizeof(*instr->value),
+                   nir_instr_type_load_const);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
 
@@ -494,10 +537,10 @@ nir_intrinsic_instr_create(nir_shader *shader, nir_intrinsic_op op)
    unsigned num_srcs = nir_intrinsic_infos[op].num_srcs;
    /* TODO: don't use rzalloc */
    nir_intrinsic_instr *instr =
-      rzalloc_size(shader,
-                  sizeof(nir_intrinsic_instr) + num_srcs * sizeof(nir_src));
+      instr_zalloc(shader,
+                   sizeof(nir_intrinsic_instr) + num_srcs * sizeof(nir_src),
+                   nir_instr_type_intrinsic);
 
-   instr_init(&instr->instr, nir_instr_type_intrinsic);
    instr->intrinsic = op;
 
    if (nir_intrinsic_infos[op].has_dest)
@@ -514,10 +557,10 @@ nir_call_instr_create(nir_shader *shader, nir_function *callee)
 {
    const unsigned num_params = callee->num_params;
    nir_call_instr *instr =
-      rzalloc_size(shader, sizeof(*instr) +
-                   num_params * sizeof(instr->params[0]));
+      instr_zalloc(shader, sizeof(*instr) +
+                   num_params * sizeof(instr->params[0]),
+                   nir_instr_type_call);
 
-   instr_init(&instr->instr, nir_instr_type_call);
    instr->callee = callee;
    instr->num_params = num_params;
    for (unsigned i = 0; i < num_params; i++)
@@ -629,8 +672,9 @@ nir_ssa_undef_instr_create(nir_shader *shader,
                            unsigned num_components,
                            unsigned bit_size)
 {
-   nir_ssa_undef_instr *instr = ralloc(shader, nir_ssa_undef_instr);
-   instr_init(&instr->instr, nir_instr_type_ssa_undef);
+   nir_ssa_undef_instr *instr =
+      instr_zalloc(shader, sizeof(nir_ssa_undef_instr),
+                   nir_instr_type_ssa_undef);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
 
@@ -914,6 +958,32 @@ void nir_instr_remove_v(nir_instr *instr)
    }
 }
 
+/**
+ * Frees an instruction that is no longer part of the shader.
+ *
+ * Instructions allocated from the shader's arena stay around until the
+ * next nir_sweep().
+ */
+void
+nir_instr_free(nir_instr *instr)
+{
+   if (!instr->arena)
+      ralloc_free(instr);
+}
+
+/**
+ * Returns a ralloc context for allocations that have to live at least as
+ * long as the instruction.
+ */
+void *
+nir_instr_mem_ctx(nir_instr *instr)
+{
+   if (instr->arena)
+      return ralloc_parent_of_linear_parent(((void **)instr)[-1]);
+
+   return instr;
+}
+
 /*@}*/
 
 void
@@ -1446,7 +1516,7 @@ nir_ssa_def_init(nir_instr *instr, nir_ssa_def *def,
                  unsigned num_components,
                  unsigned bit_size, const char *name)
 {
-   def->name = ralloc_strdup(instr, name);
+   def->name = name ? ralloc_strdup(nir_instr_mem_ctx(instr), name) : NULL;
    def->parent_instr = instr;
    list_inithead(&def->uses);
    list_inithead(&def->if_uses);
@@ -661,6 +661,13 @@ typedef struct nir_instr {
     */
    uint8_t pass_flags;
 
+   /** True if the instruction was allocated from nir_shader::instr_arena.
+    *
+    * Such instructions are not ralloc contexts; use nir_instr_mem_ctx() to
+    * allocate memory that has to live as long as the instruction.
+    */
+   bool arena;
+
    /** generic instruction index. */
    unsigned index;
 } nir_instr;
@@ -2918,6 +2925,21 @@ typedef struct nir_shader_compiler_options {
     */
    bool intel_vec4;
 
+   /**
+    * Allocate the instructions of shaders created by glsl_to_nir and
+    * spirv_to_nir from a per-shader linear arena instead of one ralloc
+    * allocation per instruction.  Dead instructions are released in bulk by
+    * nir_sweep(), which clones the shader into a fresh arena.
+    *
+    * With the arena, nir_sweep() and nir_lower_locals_to_regs() replace the
+    * shader's contents: every pointer into the shader (functions, impls,
+    * blocks, instructions, variables, registers) taken before the call is
+    * invalid afterwards.  Passes must free dead instructions with
+    * nir_instr_free() and must not use instructions as ralloc contexts; see
+    * nir_instr_mem_ctx().
+    */
+   bool use_instr_arena;
+
    unsigned max_unroll_iterations;
 
    nir_lower_int64_options lower_int64_options;
@@ -2971,6 +2993,19 @@ typedef struct nir_shader {
     */
    void *constant_data;
    unsigned constant_data_size;
+
+   /** Linear allocator parent that new ALU, deref, intrinsic, load_const,
+    * ssa_undef, jump and call instructions are allocated from, or NULL if
+    * every instruction is a separate ralloc allocation.
+    *
+    * See nir_shader_use_instr_arena().
+    */
+   void *instr_arena;
+
+   /** Bumped whenever a pass invalidates metadata of one of the shader's
+    * functions.  Only ever compared for equality; see nir_opt_loop.
+    */
+   unsigned change_counter;
 } nir_shader;
 
 #define nir_foreach_function(func, shader) \
@@ -3004,6 +3039,9 @@ nir_shader *nir_shader_create(void *mem_ctx,
                               const nir_shader_compiler_options *options,
                               shader_info *si);
 
+void nir_shader_use_instr_arena(nir_shader *shader);
+void nir_shader_release_instr_arena(nir_shader *shader);
+
 nir_register *nir_local_reg_create(nir_function_impl *impl);
 
 void nir_reg_remove(nir_register *reg);
@@ -3302,6 +3340,8 @@ nir_instr_insert_after_cf_list(struct exec_list *list, nir_instr *after)
 }
 
 void nir_instr_remove_v(nir_instr *instr);
+void nir_instr_free(nir_instr *instr);
+void *nir_instr_mem_ctx(nir_instr *instr);
 
 static inline nir_cursor
 nir_instr_remove(nir_instr *instr)
@@ -3556,6 +3596,72 @@ static inline bool should_print_nir(void) { return false; }
 
 #define NIR_SKIP(name) should_skip_nir(#name)
 
+#define NIR_OPT_LOOP_MAX_PASSES 32
+
+/**
+ * Bookkeeping for a "do { ... } while (progress)" optimization loop.
+ *
+ * Running a pass again on a shader that has not changed since it last ran
+ * without progress cannot make progress either.  Passes wrapped in
+ * NIR_LOOP_PASS remember the point at which they last came up empty and are
+ * skipped until some other pass changes the shader, which usually saves the
+ * whole final iteration of the loop and most of the one before it.
+ *
+ * The shader counts as changed when a wrapped pass reports progress.  Code
+ * run between wrapped passes is detected by its nir_metadata_preserve() calls
+ * that don't preserve all metadata, so passes run inside the loop without the
+ * wrapper must invalidate metadata when they modify the shader (which they
+ * have to do anyway).
+ */
+typedef struct nir_opt_loop {
+   nir_shader *shader;
+
+   /* Loop-local generation, advanced whenever the shader changes */
+   unsigned generation;
+   unsigned last_change_counter;
+
+   unsigned num_passes;
+   struct {
+      const char *file;
+      unsigned line;
+      bool clean;
+      unsigned clean_generation;
+   } passes[NIR_OPT_LOOP_MAX_PASSES];
+
+   /* Index of the pass currently running, or -1 */
+   int current;
+
+   unsigned num_run;
+   unsigned num_skipped;
+} nir_opt_loop;
+
+void nir_opt_loop_init(nir_opt_loop *loop, nir_shader *shader);
+bool nir_opt_loop_begin_pass(nir_opt_loop *loop,
+                             const char *file, unsigned line);
+void nir_opt_loop_end_pass(nir_opt_loop *loop, bool progress);
+
+/** NIR_PASS() for use inside a loop driven by a nir_opt_loop. */
+#define NIR_LOOP_PASS(progress, loop, nir, pass, ...) do {           \
+   if (nir_opt_loop_begin_pass(loop, __FILE__, __LINE__)) {          \
+      bool _loop_progress = false;                                   \
+      NIR_PASS(_loop_progress, nir, pass, ##__VA_ARGS__);            \
+      nir_opt_loop_end_pass(loop, _loop_progress);                   \
+      if (_loop_progress)                                            \
+         progress = true;                                            \
+   }                                                                 \
+} while (0)
+
+/** NIR_PASS_V() for use inside a loop driven by a nir_opt_loop.
+ *
+ * The pass must still return whether it made progress; it just doesn't
+ * keep the loop going.
+ */
+#define NIR_LOOP_PASS_V(loop, nir, pass, ...) do {                   \
+   bool _ignored_progress = false;                                   \
+   NIR_LOOP_PASS(_ignored_progress, loop, nir, pass, ##__VA_ARGS__); \
+   (void) _ignored_progress;                                         \
+} while (0)
+
 /** An instruction filtering callback
  *
  * Returns true if the instruction should be processed and false otherwise.
@@ -3663,6 +3769,9 @@ bool nir_lower_array_deref_of_vec(nir_shader *shader, nir_variable_mode modes,
 
 bool nir_lower_indirect_derefs(nir_shader *shader, nir_variable_mode modes);
 
+/* Invalidates every pointer into the shader if it has an instruction arena;
+ * see nir_shader_release_instr_arena().
+ */
 bool nir_lower_locals_to_regs(nir_shader *shader);
 
 void nir_lower_io_to_temporaries(nir_shader *shader,
@@ -4297,6 +4406,7 @@ void nir_schedule(nir_shader *shader, int threshold);
 
 void nir_strip(nir_shader *shader);
 
+/* Invalidates every pointer into the shader if it has an instruction arena. */
 void nir_sweep(nir_shader *shader);
 
 void nir_remap_dual_slot_attributes(nir_shader *shader,
@@ -258,8 +258,9 @@ __clone_dst(clone_state *state, nir_instr *ninstr,
    } else {
       ndst->reg.reg = remap_reg(state, dst->reg.reg);
       if (dst->reg.indirect) {
-         ndst->reg.indirect = ralloc(ninstr, nir_src);
-         __clone_src(state, ninstr, ndst->reg.indirect, dst->reg.indirect);
+         void *mem_ctx = nir_instr_mem_ctx(ninstr);
+         ndst->reg.indirect = ralloc(mem_ctx, nir_src);
+         __clone_src(state, mem_ctx, ndst->reg.indirect, dst->reg.indirect);
       }
       ndst->reg.base_offset = dst->reg.base_offset;
    }
@@ -298,7 +299,8 @@ clone_alu(clone_state *state, const nir_alu_instr *alu)
    nalu->dest.write_mask = alu->dest.write_mask;
 
    for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
-      __clone_src(state, &nalu->instr, &nalu->src[i].src, &alu->src[i].src);
+      __clone_src(state, nir_instr_mem_ctx(&nalu->instr),
+                  &nalu->src[i].src, &alu->src[i].src);
       nalu->src[i].negate = alu->src[i].negate;
       nalu->src[i].abs = alu->src[i].abs;
       memcpy(nalu->src[i].swizzle, alu->src[i].swizzle,
@@ -324,7 +326,8 @@ clone_deref_instr(clone_state *state, const nir_deref_instr *deref)
       return nderef;
    }
 
-   __clone_src(state, &nderef->instr, &nderef->parent, &deref->parent);
+   __clone_src(state, nir_instr_mem_ctx(&nderef->instr),
+               &nderef->parent, &deref->parent);
 
    switch (deref->deref_type) {
    case nir_deref_type_struct:
@@ -333,7 +336,7 @@ clone_deref_instr(clone_state *state, const nir_deref_instr *deref)
 
    case nir_deref_type_array:
    case nir_deref_type_ptr_as_array:
-      __clone_src(state, &nderef->instr,
+      __clone_src(state, nir_instr_mem_ctx(&nderef->instr),
                   &nderef->arr.index, &deref->arr.index);
       break;
 
@@ -367,7 +370,8 @@ clone_intrinsic(clone_state *state, const nir_intrinsic_instr *itr)
    memcpy(nitr->const_index, itr->const_index, sizeof(nitr->const_index));
 
    for (unsigned i = 0; i < num_srcs; i++)
-      __clone_src(state, &nitr->instr, &nitr->src[i], &itr->src[i]);
+      __clone_src(state, nir_instr_mem_ctx(&nitr->instr),
+                  &nitr->src[i], &itr->src[i]);
 
    return nitr;
 }
@@ -487,7 +491,8 @@ clone_call(clone_state *state, const nir_call_instr *call)
    nir_call_instr *ncall = nir_call_instr_create(state->ns, ncallee);
 
    for (unsigned i = 0; i < ncall->num_params; i++)
-      __clone_src(state, ncall, &ncall->params[i], &call->params[i]);
+      __clone_src(state, nir_instr_mem_ctx(&ncall->instr),
+                  &ncall->params[i], &call->params[i]);
 
    return ncall;
 }
@@ -724,8 +729,8 @@ clone_function(clone_state *state, const nir_function *fxn, nir_shader *ns)
    return nfxn;
 }
 
-nir_shader *
-nir_shader_clone(void *mem_ctx, const nir_shader *s)
+static nir_shader *
+clone_shader(void *mem_ctx, const nir_shader *s, bool use_instr_arena)
 {
    clone_state state;
    init_clone_state(&state, NULL, true, false);
@@ -733,6 +738,9 @@ nir_shader_clone(void *mem_ctx, const nir_shader *s)
    nir_shader *ns = nir_shader_create(mem_ctx, s->info.stage, s->options, NULL);
    state.ns = ns;
 
+   if (use_instr_arena)
+      nir_shader_use_instr_arena(ns);
+
    clone_var_list(&state, &ns->uniforms, &s->uniforms);
    clone_var_list(&state, &ns->inputs,   &s->inputs);
    clone_var_list(&state, &ns->outputs,  &s->outputs);
@@ -765,6 +773,7 @@ nir_shader_clone(void *mem_ctx, const nir_shader *s)
    ns->num_outputs = s->num_outputs;
    ns->num_shared = s->num_shared;
    ns->scratch_size = s->scratch_size;
+   ns->change_counter = s->change_counter;
 
    ns->constant_data_size = s->constant_data_size;
    if (s->constant_data_size > 0) {
@@ -777,13 +786,39 @@ nir_shader_clone(void *mem_ctx, const nir_shader *s)
    return ns;
 }
 
+nir_shader *
+nir_shader_clone(void *mem_ctx, const nir_shader *s)
+{
+   return clone_shader(mem_ctx, s, s->instr_arena != NULL);
+}
+
+/**
+ * Moves all instructions out of the shader's instruction arena, if any, and
+ * goes back to allocating every instruction with ralloc.
+ *
+ * Passes that introduce register indirects call this first, because arena
+ * instructions can't be used as the ralloc context of the indirect source
+ * that nir_src_copy() allocates.  All pointers into the shader are
+ * invalidated.
+ */
+void
+nir_shader_release_instr_arena(nir_shader *shader)
+{
+   if (!shader->instr_arena)
+      return;
+
+   nir_shader_replace(shader,
+                      clone_shader(ralloc_parent(shader), shader, false));
+}
+
 /** Overwrites dst and replaces its contents with src
  *
  * Everything ralloc parented to dst and src itself (but not its children)
  * will be freed.
  *
- * This should only be used by test code which needs to swap out shaders with
- * a cloned or deserialized version.
+ * This is used by nir_sweep() for shaders with an instruction arena and by
+ * test code which needs to swap out shaders with a cloned or deserialized
+ * version.
  */
 void
 nir_shader_replace(nir_shader *dst, nir_shader *src)
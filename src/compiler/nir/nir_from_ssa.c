@@ -461,6 +461,19 @@ create_reg_for_ssa_def(nir_ssa_def *def, nir_function_impl *impl)
    return reg;
 }
 
+/* The caller may still look at a removed instruction, so ralloc'ed ones are
+ * only freed along with dead_ctx.  Arena instructions aren't ralloc contexts
+ * and stay around until the next nir_sweep().
+ */
+static void
+free_dead_instr(struct from_ssa_state *state, nir_instr *instr)
+{
+   if (instr->arena)
+      nir_instr_free(instr);
+   else
+      ralloc_steal(state->dead_ctx, instr);
+}
+
 static bool
 rewrite_ssa_def(nir_ssa_def *def, void *void_state)
 {
@@ -503,7 +516,7 @@ rewrite_ssa_def(nir_ssa_def *def, void *void_state)
        */
       nir_instr *parent_instr = def->parent_instr;
       nir_instr_remove(parent_instr);
-      ralloc_steal(state->dead_ctx, parent_instr);
+      free_dead_instr(state, parent_instr);
       state->progress = true;
       return true;
    }
@@ -532,7 +545,7 @@ resolve_registers_block(nir_block *block, struct from_ssa_state *state)
 
       if (instr->type == nir_instr_type_phi) {
          nir_instr_remove(instr);
-         ralloc_steal(state->dead_ctx, instr);
+         free_dead_instr(state, instr);
          state->progress = true;
       }
    }
@@ -552,7 +565,7 @@ emit_copy(nir_builder *b, nir_src src, nir_src dest_src)
       assert(src.reg.reg->num_components >= dest_src.reg.reg->num_components);
 
    nir_alu_instr *mov = nir_alu_instr_create(b->shader, nir_op_mov);
-   nir_src_copy(&mov->src[0].src, &src, mov);
+   nir_src_copy(&mov->src[0].src, &src, nir_instr_mem_ctx(&mov->instr));
    mov->dest.dest = nir_dest_for_reg(dest_src.reg.reg);
    mov->dest.write_mask = (1 << dest_src.reg.reg->num_components) - 1;
 
@@ -592,6 +592,8 @@ lower_flrp_impl(nir_function_impl *impl,
    nir_builder b;
    nir_builder_init(&b, impl);
 
+   const int dead_before = u_vector_length(dead_flrp);
+
    nir_foreach_block(block, impl) {
       nir_foreach_instr_safe(instr, block) {
          if (instr->type == nir_instr_type_alu) {
@@ -606,8 +608,14 @@ lower_flrp_impl(nir_function_impl *impl,
       }
    }
 
-   nir_metadata_preserve(impl, nir_metadata_block_index |
-                               nir_metadata_dominance);
+   if (u_vector_length(dead_flrp) != dead_before) {
+      nir_metadata_preserve(impl, nir_metadata_block_index |
+                                  nir_metadata_dominance);
+   } else {
+#ifndef NDEBUG
+      impl->valid_metadata &= ~nir_metadata_not_properly_reset;
+#endif
+   }
 }
 
 /**
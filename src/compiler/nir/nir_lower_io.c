@@ -471,7 +471,8 @@ lower_atomic(nir_intrinsic_instr *intrin, struct lower_io_state *state,
    assert(nir_intrinsic_infos[intrin->intrinsic].num_srcs ==
           nir_intrinsic_infos[op].num_srcs);
    for (unsigned i = 1; i < nir_intrinsic_infos[op].num_srcs; i++) {
-      nir_src_copy(&atomic->src[i], &intrin->src[i], atomic);
+      nir_src_copy(&atomic->src[i], &intrin->src[i],
+                   nir_instr_mem_ctx(&atomic->instr));
    }
 
    if (nir_intrinsic_infos[op].has_dest) {
@@ -539,7 +540,8 @@ lower_interpolate_at(nir_intrinsic_instr *intrin, struct lower_io_state *state,
    if (intrin->intrinsic == nir_intrinsic_interp_deref_at_sample ||
        intrin->intrinsic == nir_intrinsic_interp_deref_at_offset ||
        intrin->intrinsic == nir_intrinsic_interp_deref_at_vertex)
-      nir_src_copy(&bary_setup->src[0], &intrin->src[1], bary_setup);
+      nir_src_copy(&bary_setup->src[0], &intrin->src[1],
+                   nir_instr_mem_ctx(&bary_setup->instr));
 
    nir_builder_instr_insert(b, &bary_setup->instr);
 
@@ -51,7 +51,8 @@ lower_load_input_to_scalar(nir_builder *b, nir_intrinsic_instr *intr)
       nir_intrinsic_set_component(chan_intr, nir_intrinsic_component(intr) + i);
       nir_intrinsic_set_type(chan_intr, nir_intrinsic_type(intr));
       /* offset */
-      nir_src_copy(&chan_intr->src[0], &intr->src[0], chan_intr);
+      nir_src_copy(&chan_intr->src[0], &intr->src[0],
+                   nir_instr_mem_ctx(&chan_intr->instr));
 
       nir_builder_instr_insert(b, &chan_intr->instr);
 
@@ -87,7 +88,8 @@ lower_store_output_to_scalar(nir_builder *b, nir_intrinsic_instr *intr)
       /* value */
       chan_intr->src[0] = nir_src_for_ssa(nir_channel(b, value, i));
       /* offset */
-      nir_src_copy(&chan_intr->src[1], &intr->src[1], chan_intr);
+      nir_src_copy(&chan_intr->src[1], &intr->src[1],
+                   nir_instr_mem_ctx(&chan_intr->instr));
 
       nir_builder_instr_insert(b, &chan_intr->instr);
    }
@@ -219,7 +221,8 @@ lower_load_to_scalar_early(nir_builder *b, nir_intrinsic_instr *intr,
       if (intr->intrinsic == nir_intrinsic_interp_deref_at_offset ||
           intr->intrinsic == nir_intrinsic_interp_deref_at_sample ||
           intr->intrinsic == nir_intrinsic_interp_deref_at_vertex)
-         nir_src_copy(&chan_intr->src[1], &intr->src[1], &chan_intr->instr);
+         nir_src_copy(&chan_intr->src[1], &intr->src[1],
+                      nir_instr_mem_ctx(&chan_intr->instr));
 
       nir_builder_instr_insert(b, &chan_intr->instr);
 
@@ -226,7 +226,8 @@ lower_locals_to_regs_block(nir_block *block,
          nir_src reg_src = get_deref_reg_src(deref, state);
 
          nir_alu_instr *mov = nir_alu_instr_create(b->shader, nir_op_mov);
-         nir_src_copy(&mov->src[0].src, &intrin->src[1], mov);
+         nir_src_copy(&mov->src[0].src, &intrin->src[1],
+                      nir_instr_mem_ctx(&mov->instr));
          mov->dest.write_mask = nir_intrinsic_write_mask(intrin);
          mov->dest.dest.is_ssa = false;
          mov->dest.dest.reg.reg = reg_src.reg.reg;
@@ -280,6 +281,11 @@ nir_lower_locals_to_regs(nir_shader *shader)
 {
    bool progress = false;
 
+   /* Indirect register accesses are allocated as ralloc children of the
+    * instructions using them.
+    */
+   nir_shader_release_instr_arena(shader);
+
    nir_foreach_function(function, shader) {
       if (function->impl)
          progress = nir_lower_locals_to_regs_impl(function->impl) || progress;
@@ -44,7 +44,8 @@ lower_subgroups_64bit_split_intrinsic(nir_builder *b, nir_intrinsic_instr *intri
    intr->const_index[1] = intrin->const_index[1];
    intr->src[0] = nir_src_for_ssa(comp);
    if (nir_intrinsic_infos[intrin->intrinsic].num_srcs == 2)
-      nir_src_copy(&intr->src[1], &intrin->src[1], intr);
+      nir_src_copy(&intr->src[1], &intrin->src[1],
+                   nir_instr_mem_ctx(&intr->instr));
 
    intr->num_components = 1;
    nir_builder_instr_insert(b, &intr->instr);
@@ -134,7 +135,8 @@ lower_subgroup_op_to_scalar(nir_builder *b, nir_intrinsic_instr *intrin,
       /* invocation */
       if (nir_intrinsic_infos[intrin->intrinsic].num_srcs > 1) {
          assert(nir_intrinsic_infos[intrin->intrinsic].num_srcs == 2);
-         nir_src_copy(&chan_intrin->src[1], &intrin->src[1], chan_intrin);
+         nir_src_copy(&chan_intrin->src[1], &intrin->src[1],
+                      nir_instr_mem_ctx(&chan_intrin->instr));
       }
 
       chan_intrin->const_index[0] = intrin->const_index[0];
@@ -270,7 +272,8 @@ lower_shuffle(nir_builder *b, nir_intrinsic_instr *intrin,
    nir_intrinsic_instr *shuffle =
       nir_intrinsic_instr_create(b->shader, nir_intrinsic_shuffle);
    shuffle->num_components = intrin->num_components;
-   nir_src_copy(&shuffle->src[0], &intrin->src[0], shuffle);
+   nir_src_copy(&shuffle->src[0], &intrin->src[0],
+                nir_instr_mem_ctx(&shuffle->instr));
    shuffle->src[1] = nir_src_for_ssa(index);
    nir_ssa_dest_init(&shuffle->instr, &shuffle->dest,
                      intrin->dest.ssa.num_components,
@@ -391,7 +394,8 @@ lower_subgroups_instr(nir_builder *b, nir_instr *instr, void *_options)
       ballot->num_components = 1;
       nir_ssa_dest_init(&ballot->instr, &ballot->dest,
                         1, options->ballot_bit_size, NULL);
-      nir_src_copy(&ballot->src[0], &intrin->src[0], ballot);
+      nir_src_copy(&ballot->src[0], &intrin->src[0],
+                   nir_instr_mem_ctx(&ballot->instr));
       nir_builder_instr_insert(b, &ballot->instr);
 
       return uint_to_ballot_type(b, &ballot->dest.ssa,
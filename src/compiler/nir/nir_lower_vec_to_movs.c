@@ -97,7 +97,7 @@ insert_mov(nir_alu_instr *vec, unsigned start_idx, nir_shader *shader)
    if (mov->dest.write_mask) {
       nir_instr_insert_before(&vec->instr, &mov->instr);
    } else {
-      ralloc_free(mov);
+      nir_instr_free(&mov->instr);
    }
 
    return channels_handled;
@@ -276,7 +276,7 @@ lower_vec_to_movs_block(nir_block *block, nir_function_impl *impl)
       }
 
       nir_instr_remove(&vec->instr);
-      ralloc_free(vec);
+      nir_instr_free(&vec->instr);
       progress = true;
    }
 
@@ -56,6 +56,17 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
 void
 nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved)
 {
+   const nir_metadata all = nir_metadata_block_index |
+                            nir_metadata_dominance |
+                            nir_metadata_live_ssa_defs |
+                            nir_metadata_loop_analysis;
+
+   /* Anything short of preserving everything means the function may have
+    * changed, which is what nir_opt_loop uses to decide what to rerun.
+    */
+   if ((preserved & all) != all && impl->function)
+      impl->function->shader->change_counter++;
+
    impl->valid_metadata &= preserved;
 }
 
@@ -110,7 +110,7 @@ constant_fold_alu_instr(struct constant_fold_state *state, nir_alu_instr *instr)
                             nir_src_for_ssa(&new_instr->def));
 
    nir_instr_remove(&instr->instr);
-   ralloc_free(instr);
+   nir_instr_free(&instr->instr);
 
    return true;
 }
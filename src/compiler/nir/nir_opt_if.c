@@ -514,7 +514,7 @@ opt_split_alu_of_phi(nir_builder *b, nir_loop *loop)
           * remove it.
           */
          nir_instr_remove_v(&alu->instr);
-         ralloc_free(alu);
+         nir_instr_free(&alu->instr);
 
          progress = true;
       }
@@ -734,7 +734,7 @@ opt_simplify_bcsel_of_phi(nir_builder *b, nir_loop *loop)
        * just remove it.
        */
       nir_instr_remove_v(&bcsel->instr);
-      ralloc_free(bcsel);
+      nir_instr_free(&bcsel->instr);
 
       progress = true;
    }
@@ -1402,8 +1402,10 @@ nir_opt_if(nir_shader *shader, bool aggressive_last_continue)
       nir_metadata_require(function->impl, nir_metadata_block_index |
                            nir_metadata_dominance);
       progress = opt_if_safe_cf_list(&b, &function->impl->body);
-      nir_metadata_preserve(function->impl, nir_metadata_block_index |
-                            nir_metadata_dominance);
+      if (progress) {
+         nir_metadata_preserve(function->impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
+      }
 
       if (opt_if_cf_list(&b, &function->impl->body,
                          aggressive_last_continue)) {
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+
+/*
+ * Skips passes of an optimization loop that cannot make progress because
+ * the shader has not changed since they last ran.  See nir_opt_loop in
+ * nir.h.
+ */
+
+void
+nir_opt_loop_init(nir_opt_loop *loop, nir_shader *shader)
+{
+   memset(loop, 0, sizeof(*loop));
+   loop->shader = shader;
+   loop->last_change_counter = shader->change_counter;
+   loop->current = -1;
+}
+
+static void
+observe_changes(nir_opt_loop *loop)
+{
+   if (loop->shader->change_counter != loop->last_change_counter) {
+      loop->last_change_counter = loop->shader->change_counter;
+      loop->generation++;
+   }
+}
+
+bool
+nir_opt_loop_begin_pass(nir_opt_loop *loop, const char *file, unsigned line)
+{
+   observe_changes(loop);
+
+   int idx = -1;
+   for (unsigned i = 0; i < loop->num_passes; i++) {
+      if (loop->passes[i].line == line && loop->passes[i].file == file) {
+         idx = i;
+         break;
+      }
+   }
+
+   if (idx < 0 && loop->num_passes < NIR_OPT_LOOP_MAX_PASSES) {
+      idx = loop->num_passes++;
+      loop->passes[idx].file = file;
+      loop->passes[idx].line = line;
+      loop->passes[idx].clean = false;
+   }
+
+   if (idx >= 0 && loop->passes[idx].clean &&
+       loop->passes[idx].clean_generation == loop->generation) {
+      loop->num_skipped++;
+      return false;
+   }
+
+   loop->current = idx;
+   loop->num_run++;
+   return true;
+}
+
+void
+nir_opt_loop_end_pass(nir_opt_loop *loop, bool progress)
+{
+   /* For wrapped passes, only reported progress counts as a change.  Some
+    * passes throw away metadata even when they don't change anything, and
+    * that mustn't make every other pass of the loop run again.
+    */
+   loop->last_change_counter = loop->shader->change_counter;
+   if (progress)
+      loop->generation++;
+
+   if (loop->current >= 0) {
+      loop->passes[loop->current].clean = !progress;
+      loop->passes[loop->current].clean_generation = loop->generation;
+   }
+
+   loop->current = -1;
+}
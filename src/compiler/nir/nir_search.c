@@ -523,9 +523,12 @@ construct_value(nir_builder *build,
       const nir_search_variable *var = nir_search_value_as_variable(value);
       assert(state->variables_seen & (1 << var->variable));
 
+      /* There is no instruction yet, so copy the source by hand. */
       nir_alu_src val = { NIR_SRC_INIT };
-      nir_alu_src_copy(&val, &state->variables[var->variable],
-                       (void *)build->shader);
+      nir_src_copy(&val.src, &state->variables[var->variable].src,
+                   build->shader);
+      val.abs = state->variables[var->variable].abs;
+      val.negate = state->variables[var->variable].negate;
       assert(!var->is_constant);
 
       for (unsigned i = 0; i < NIR_MAX_VEC_COMPONENTS; i++)
@@ -33,6 +33,11 @@
  * The expectation is that drivers should call this when finished compiling the shader
  * (after any optimization, lowering, and so on).  However, it's also fine to call it
  * earlier, and even many times, trading CPU cycles for memory savings.
+ *
+ * Shaders that allocate instructions from an arena (see nir_shader_use_instr_arena)
+ * can't give back individual instructions, so they are cloned into a fresh arena
+ * instead and the old one is freed as a whole.  In that case, all pointers into the
+ * shader are invalidated.
  */
 
 #define steal_list(mem_ctx, type, list) \
@@ -153,6 +158,11 @@ sweep_function(nir_shader *nir, nir_function *f)
 void
 nir_sweep(nir_shader *nir)
 {
+   if (nir->instr_arena) {
+      nir_shader_replace(nir, nir_shader_clone(ralloc_parent(nir), nir));
+      return;
+   }
+
    void *rubbish = ralloc_context(NULL);
 
    /* First, move ownership of all the memory to a temporary context; assume dead. */
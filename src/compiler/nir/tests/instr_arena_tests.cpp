@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+
+namespace {
+
+class nir_instr_arena_test : public ::testing::Test {
+protected:
+   nir_instr_arena_test();
+   ~nir_instr_arena_test();
+
+   unsigned count_instrs(bool *all_in_arena);
+
+   void *mem_ctx;
+   nir_builder *b;
+   const nir_shader_compiler_options options;
+};
+
+nir_instr_arena_test::nir_instr_arena_test()
+:  options()
+{
+   glsl_type_singleton_init_or_ref();
+
+   mem_ctx = ralloc_context(NULL);
+
+   b = rzalloc(mem_ctx, nir_builder);
+   nir_builder_init_simple_shader(b, mem_ctx, MESA_SHADER_COMPUTE, &options);
+   nir_shader_use_instr_arena(b->shader);
+}
+
+nir_instr_arena_test::~nir_instr_arena_test()
+{
+   if (HasFailure()) {
+      printf("\nShader from the failed test:\n\n");
+      nir_print_shader(b->shader, stdout);
+   }
+
+   ralloc_free(mem_ctx);
+
+   glsl_type_singleton_decref();
+}
+
+unsigned
+nir_instr_arena_test::count_instrs(bool *all_in_arena)
+{
+   unsigned count = 0;
+
+   *all_in_arena = true;
+   nir_foreach_function(function, b->shader) {
+      if (!function->impl)
+         continue;
+
+      nir_foreach_block(block, function->impl) {
+         nir_foreach_instr(instr, block) {
+            /* Texture, phi and parallel copy instructions are never
+             * allocated from the arena.
+             */
+            *all_in_arena &= instr->arena;
+            count++;
+         }
+      }
+   }
+
+   return count;
+}
+
+} // namespace
+
+TEST_F(nir_instr_arena_test, sweep)
+{
+   nir_variable *var = nir_variable_create(b->shader, nir_var_mem_ssbo,
+                                           glsl_uint_type(), "out");
+   nir_ssa_def *inv = nir_load_local_invocation_index(b);
+   nir_ssa_def *val = nir_iadd(b, inv, nir_imul_imm(b, nir_imm_int(b, 3), 5));
+   val->name = ralloc_strdup(nir_instr_mem_ctx(val->parent_instr), "val");
+   nir_store_deref(b, nir_build_deref_var(b, var), val, 0x1);
+
+   /* Dead code. */
+   nir_iadd(b, inv, nir_imm_int(b, 7));
+
+   bool all_in_arena;
+   count_instrs(&all_in_arena);
+   ASSERT_TRUE(all_in_arena);
+
+   NIR_PASS_V(b->shader, nir_opt_constant_folding);
+   NIR_PASS_V(b->shader, nir_opt_dce);
+   unsigned count = count_instrs(&all_in_arena);
+
+   nir_sweep(b->shader);
+   nir_validate_shader(b->shader, "after sweep");
+
+   ASSERT_NE(b->shader->instr_arena, nullptr);
+   ASSERT_EQ(count_instrs(&all_in_arena), count);
+   ASSERT_TRUE(all_in_arena);
+
+   nir_shader *clone = nir_shader_clone(mem_ctx, b->shader);
+   ASSERT_NE(clone->instr_arena, nullptr);
+}
+
+TEST_F(nir_instr_arena_test, release_for_regs)
+{
+   nir_variable *var = nir_local_variable_create(b->impl,
+                                                 glsl_array_type(glsl_uint_type(), 4, 0),
+                                                 "arr");
+   nir_ssa_def *inv = nir_load_local_invocation_index(b);
+   nir_deref_instr *deref = nir_build_deref_var(b, var);
+   nir_store_deref(b, nir_build_deref_array(b, deref, inv), inv, 0x1);
+   nir_load_deref(b, nir_build_deref_array(b, deref, nir_iadd_imm(b, inv, 1)));
+
+   NIR_PASS_V(b->shader, nir_lower_locals_to_regs);
+   nir_validate_shader(b->shader, "after locals_to_regs");
+
+   bool all_in_arena;
+   count_instrs(&all_in_arena);
+   ASSERT_EQ(b->shader->instr_arena, nullptr);
+   ASSERT_FALSE(all_in_arena);
+
+   nir_sweep(b->shader);
+   nir_validate_shader(b->shader, "after sweep");
+}
+
+TEST_F(nir_instr_arena_test, out_of_ssa)
+{
+   nir_ssa_def *inv = nir_load_local_invocation_index(b);
+   nir_ssa_def *undef = nir_ssa_undef(b, 1, 32);
+
+   nir_push_if(b, nir_ieq(b, inv, nir_imm_int(b, 0)));
+   nir_ssa_def *then_val = nir_iadd_imm(b, inv, 1);
+   nir_push_else(b, NULL);
+   nir_ssa_def *else_val = nir_imul_imm(b, inv, 3);
+   nir_pop_if(b, NULL);
+   nir_ssa_def *phi = nir_if_phi(b, then_val, else_val);
+
+   /* The first channel is a mov that vec_to_movs drops again, the undef is
+    * removed by from_ssa.
+    */
+   nir_ssa_def *vec = nir_vec4(b, nir_channel(b, phi, 0), undef, inv,
+                               nir_iadd(b, phi, inv));
+
+   /* from_ssa doesn't handle derefs, so store with an explicit binding. */
+   nir_intrinsic_instr *store =
+      nir_intrinsic_instr_create(b->shader, nir_intrinsic_store_ssbo);
+   store->num_components = 4;
+   store->src[0] = nir_src_for_ssa(vec);
+   store->src[1] = nir_src_for_ssa(nir_imm_int(b, 0));
+   store->src[2] = nir_src_for_ssa(nir_imul_imm(b, inv, 16));
+   nir_intrinsic_set_write_mask(store, 0xf);
+   nir_intrinsic_set_align(store, 16, 0);
+   nir_builder_instr_insert(b, &store->instr);
+
+   NIR_PASS_V(b->shader, nir_convert_from_ssa, false);
+   NIR_PASS_V(b->shader, nir_lower_vec_to_movs);
+   nir_validate_shader(b->shader, "after vec_to_movs");
+
+   nir_foreach_block(block, b->impl) {
+      nir_foreach_instr(instr, block) {
+         ASSERT_NE(instr->type, nir_instr_type_phi);
+         ASSERT_NE(instr->type, nir_instr_type_ssa_undef);
+         if (instr->type == nir_instr_type_alu) {
+            ASSERT_NE(nir_instr_as_alu(instr)->op, nir_op_vec4);
+         }
+      }
+   }
+
+   nir_sweep(b->shader);
+   nir_validate_shader(b->shader, "after sweep");
+
+   bool all_in_arena;
+   count_instrs(&all_in_arena);
+   ASSERT_TRUE(all_in_arena);
+}
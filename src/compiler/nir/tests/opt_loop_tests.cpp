@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+
+namespace {
+
+class nir_opt_loop_test : public ::testing::Test {
+protected:
+   nir_opt_loop_test();
+   ~nir_opt_loop_test();
+
+   bool run_iteration();
+
+   void *mem_ctx;
+   nir_builder *b;
+   nir_opt_loop loop;
+   const nir_shader_compiler_options options;
+};
+
+nir_opt_loop_test::nir_opt_loop_test()
+:  options()
+{
+   glsl_type_singleton_init_or_ref();
+
+   mem_ctx = ralloc_context(NULL);
+
+   b = rzalloc(mem_ctx, nir_builder);
+   nir_builder_init_simple_shader(b, mem_ctx, MESA_SHADER_COMPUTE, &options);
+}
+
+nir_opt_loop_test::~nir_opt_loop_test()
+{
+   if (HasFailure()) {
+      printf("\nShader from the failed test:\n\n");
+      nir_print_shader(b->shader, stdout);
+   }
+
+   ralloc_free(mem_ctx);
+
+   glsl_type_singleton_decref();
+}
+
+bool
+nir_opt_loop_test::run_iteration()
+{
+   bool progress = false;
+
+   NIR_LOOP_PASS(progress, &loop, b->shader, nir_opt_constant_folding);
+   NIR_LOOP_PASS(progress, &loop, b->shader, nir_opt_dce);
+   NIR_LOOP_PASS(progress, &loop, b->shader, nir_copy_prop);
+
+   return progress;
+}
+
+} // namespace
+
+TEST_F(nir_opt_loop_test, skip_unchanged)
+{
+   nir_variable *var = nir_variable_create(b->shader, nir_var_mem_ssbo,
+                                           glsl_uint_type(), "out");
+   nir_ssa_def *val = nir_iadd(b, nir_imm_int(b, 1), nir_imm_int(b, 2));
+   nir_store_deref(b, nir_build_deref_var(b, var), val, 0x1);
+
+   nir_opt_loop_init(&loop, b->shader);
+
+   /* Folding and DCE make progress, copy propagation doesn't. */
+   ASSERT_TRUE(run_iteration());
+   ASSERT_EQ(loop.num_run, 3);
+   ASSERT_EQ(loop.num_skipped, 0);
+
+   /* Nothing left to do.  Copy propagation already saw the final shader. */
+   ASSERT_FALSE(run_iteration());
+   ASSERT_EQ(loop.num_run, 5);
+   ASSERT_EQ(loop.num_skipped, 1);
+
+   ASSERT_FALSE(run_iteration());
+   ASSERT_EQ(loop.num_run, 5);
+   ASSERT_EQ(loop.num_skipped, 4);
+}
+
+TEST_F(nir_opt_loop_test, rerun_after_change)
+{
+   nir_variable *var = nir_variable_create(b->shader, nir_var_mem_ssbo,
+                                           glsl_uint_type(), "out");
+   nir_ssa_def *inv = nir_load_local_invocation_index(b);
+   nir_store_deref(b, nir_build_deref_var(b, var), inv, 0x1);
+
+   nir_opt_loop_init(&loop, b->shader);
+
+   ASSERT_FALSE(run_iteration());
+   ASSERT_FALSE(run_iteration());
+   ASSERT_EQ(loop.num_run, 3);
+   ASSERT_EQ(loop.num_skipped, 3);
+
+   /* Modify the shader behind the loop's back. */
+   b->cursor = nir_before_instr(inv->parent_instr);
+   nir_iadd(b, nir_imm_int(b, 1), nir_imm_int(b, 2));
+   nir_metadata_preserve(b->impl, nir_metadata_none);
+
+   ASSERT_TRUE(run_iteration());
+   ASSERT_EQ(loop.num_run, 6);
+   ASSERT_EQ(loop.num_skipped, 3);
+}
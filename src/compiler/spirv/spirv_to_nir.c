@@ -5300,6 +5300,8 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
    words+= 5;
 
    b->shader = nir_shader_create(b, stage, nir_options, NULL);
+   if (nir_options->use_instr_arena)
+      nir_shader_use_instr_arena(b->shader);
 
    /* Handle all the preamble instructions */
    words = vtn_foreach_instruction(b, words, word_end,
@@ -38,12 +38,34 @@
 
 struct cso_cache {
    struct cso_hash *hashes[CSO_CACHE_MAX];
+   struct list_head lru[CSO_CACHE_MAX];
+   struct cso_cache_stats stats[CSO_CACHE_MAX];
    int    max_size;
 
-   cso_sanitize_callback sanitize_cb;
-   void                 *sanitize_data;
+   cso_delete_callback delete_cb;
+   void               *delete_data;
 };
 
+static const unsigned entry_offset[CSO_CACHE_MAX] = {
+   [CSO_RASTERIZER] = offsetof(struct cso_rasterizer, cache),
+   [CSO_BLEND] = offsetof(struct cso_blend, cache),
+   [CSO_DEPTH_STENCIL_ALPHA] = offsetof(struct cso_depth_stencil_alpha, cache),
+   [CSO_SAMPLER] = offsetof(struct cso_sampler, cache),
+   [CSO_VELEMENTS] = offsetof(struct cso_velements, cache),
+};
+
+static inline struct cso_cache_entry *
+cso_entry(void *state, enum cso_cache_type type)
+{
+   return (struct cso_cache_entry *)((char *)state + entry_offset[type]);
+}
+
+static inline void *
+cso_entry_state(struct cso_cache_entry *entry, enum cso_cache_type type)
+{
+   return (char *)entry - entry_offset[type];
+}
+
 #if 1
 static unsigned hash_key(const void *key, unsigned key_size)
 {
@@ -127,7 +149,8 @@ static void delete_velements(void *state, UNUSED void *data)
    FREE(state);
 }
 
-static inline void delete_cso(void *state, enum cso_cache_type type)
+static boolean delete_cso(void *state, enum cso_cache_type type,
+                          UNUSED void *data)
 {
    switch (type) {
    case CSO_BLEND:
@@ -149,37 +172,59 @@ static inline void delete_cso(void *state, enum cso_cache_type type)
       assert(0);
       FREE(state);
    }
+   return TRUE;
 }
 
 
-static inline void sanitize_hash(struct cso_cache *sc,
-                                 struct cso_hash *hash,
-                                 enum cso_cache_type type,
-                                 int max_size)
-{
-   if (sc->sanitize_cb)
-      sc->sanitize_cb(hash, type, max_size, sc->sanitize_data);
-}
-
-
-static inline void sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
-			       int max_size, UNUSED void *user_data)
+/**
+ * Remove the least recently used state objects of the given type if
+ * there are more than max_size of them.
+ */
+static void evict_states(struct cso_cache *sc, enum cso_cache_type type,
+                         int max_size)
 {
+   struct cso_hash *hash = _cso_hash_for_type(sc, type);
    /* if we're approach the maximum size, remove fourth of the entries
     * otherwise every subsequent call will go through the same */
    int hash_size = cso_hash_size(hash);
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
+   struct cso_cache_entry *entry, *prev;
+   struct list_head busy;
+
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      struct cso_hash_iter iter = cso_hash_first_node(hash);
-      void  *cso = cso_hash_take(hash, cso_hash_iter_key(iter));
-      delete_cso(cso, type);
-      --to_remove;
+
+   list_inithead(&busy);
+
+   LIST_FOR_EACH_ENTRY_SAFE_REV(entry, prev, &sc->lru[type], lru) {
+      void *state = cso_entry_state(entry, type);
+      struct cso_hash_iter iter;
+
+      if (!to_remove)
+         break;
+
+      iter = cso_hash_find(hash, entry->hash_key);
+      while (cso_hash_iter_data(iter) != state)
+         iter = cso_hash_iter_next(iter);
+
+      /* The callback frees the entry along with the state. */
+      list_del(&entry->lru);
+
+      if (sc->delete_cb(state, type, sc->delete_data)) {
+         cso_hash_erase(hash, iter);
+         sc->stats[type].evictions++;
+         --to_remove;
+      } else {
+         /* Still in use, so it's not a candidate for a while.  It's only
+          * moved to the front after the walk, which would reach it again
+          * otherwise.
+          */
+         list_add(&entry->lru, &busy);
+      }
    }
+
+   list_splice(&busy, &sc->lru[type]);
 }
 
 struct cso_hash_iter
@@ -188,9 +233,17 @@ cso_insert_state(struct cso_cache *sc,
                  void *state)
 {
    struct cso_hash *hash = _cso_hash_for_type(sc, type);
-   sanitize_hash(sc, hash, type, sc->max_size);
+   struct cso_cache_entry *entry = cso_entry(state, type);
+   struct cso_hash_iter iter;
+
+   evict_states(sc, type, sc->max_size);
 
-   return cso_hash_insert(hash, hash_key, state);
+   iter = cso_hash_insert(hash, hash_key, state);
+   if (!cso_hash_iter_is_null(iter)) {
+      entry->hash_key = hash_key;
+      list_add(&entry->lru, &sc->lru[type]);
+   }
+   return iter;
 }
 
 struct cso_hash_iter
@@ -229,10 +282,18 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
    struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
    while (!cso_hash_iter_is_null(iter)) {
       void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size))
+      if (!memcmp(iter_data, templ, size)) {
+         struct cso_cache_entry *entry = cso_entry(iter_data, type);
+
+         /* Move it to the front of the LRU list. */
+         list_del(&entry->lru);
+         list_add(&entry->lru, &sc->lru[type]);
+         sc->stats[type].hits++;
          return iter;
+      }
       iter = cso_hash_iter_next(iter);
    }
+   sc->stats[type].misses++;
    return iter;
 }
 
@@ -240,22 +301,28 @@ void * cso_take_state(struct cso_cache *sc,
                       unsigned hash_key, enum cso_cache_type type)
 {
    struct cso_hash *hash = _cso_hash_for_type(sc, type);
-   return cso_hash_take(hash, hash_key);
+   void *state = cso_hash_take(hash, hash_key);
+
+   if (state)
+      list_del(&cso_entry(state, type)->lru);
+   return state;
 }
 
 struct cso_cache *cso_cache_create(void)
 {
-   struct cso_cache *sc = MALLOC_STRUCT(cso_cache);
+   struct cso_cache *sc = CALLOC_STRUCT(cso_cache);
    int i;
    if (!sc)
       return NULL;
 
    sc->max_size           = 4096;
-   for (i = 0; i < CSO_CACHE_MAX; i++)
+   for (i = 0; i < CSO_CACHE_MAX; i++) {
       sc->hashes[i] = cso_hash_create();
+      list_inithead(&sc->lru[i]);
+   }
 
-   sc->sanitize_cb        = sanitize_cb;
-   sc->sanitize_data      = 0;
+   sc->delete_cb          = delete_cso;
+   sc->delete_data        = 0;
 
    return sc;
 }
@@ -304,7 +371,7 @@ void cso_set_maximum_cache_size(struct cso_cache *sc, int number)
    sc->max_size = number;
 
    for (i = 0; i < CSO_CACHE_MAX; i++)
-      sanitize_hash(sc, sc->hashes[i], i, sc->max_size);
+      evict_states(sc, i, sc->max_size);
 }
 
 int cso_maximum_cache_size(const struct cso_cache *sc)
@@ -312,11 +379,17 @@ int cso_maximum_cache_size(const struct cso_cache *sc)
    return sc->max_size;
 }
 
-void cso_cache_set_sanitize_callback(struct cso_cache *sc,
-                                     cso_sanitize_callback cb,
-                                     void *user_data)
+void cso_cache_set_delete_callback(struct cso_cache *sc,
+                                   cso_delete_callback cb,
+                                   void *user_data)
+{
+   sc->delete_cb   = cb;
+   sc->delete_data = user_data;
+}
+
+void cso_cache_get_stats(const struct cso_cache *sc, enum cso_cache_type type,
+                         struct cso_cache_stats *stats)
 {
-   sc->sanitize_cb   = cb;
-   sc->sanitize_data = user_data;
+   *stats = sc->stats[type];
 }
 
@@ -75,6 +75,7 @@
 
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
+#include "util/list.h"
 
 /* cso_hash.h is necessary for cso_hash_iter, as MSVC requires structures
  * returned by value to be fully defined */
@@ -96,18 +97,36 @@ enum cso_cache_type {
 
 typedef void (*cso_state_callback)(void *ctx, void *obj);
 
-typedef void (*cso_sanitize_callback)(struct cso_hash *hash,
-                                      enum cso_cache_type type,
-                                      int max_size,
-                                      void *user_data);
+/**
+ * Deletes a state object evicted from the cache.  Returns false if the
+ * state object is still in use and must be kept.
+ */
+typedef boolean (*cso_delete_callback)(void *state,
+                                       enum cso_cache_type type,
+                                       void *user_data);
 
 struct cso_cache;
 
+/**
+ * Cache bookkeeping embedded in each of the state objects below.
+ */
+struct cso_cache_entry {
+   struct list_head lru; /**< most recently used first */
+   unsigned hash_key;
+};
+
+struct cso_cache_stats {
+   uint64_t hits;
+   uint64_t misses;
+   uint64_t evictions;
+};
+
 struct cso_blend {
    struct pipe_blend_state state;
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   struct cso_cache_entry cache;
 };
 
 struct cso_depth_stencil_alpha {
@@ -115,6 +134,7 @@ struct cso_depth_stencil_alpha {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   struct cso_cache_entry cache;
 };
 
 struct cso_rasterizer {
@@ -122,6 +142,7 @@ struct cso_rasterizer {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   struct cso_cache_entry cache;
 };
 
 struct cso_sampler {
@@ -129,7 +150,7 @@ struct cso_sampler {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
-   unsigned hash_key;
+   struct cso_cache_entry cache;
 };
 
 struct cso_velems_state {
@@ -142,6 +163,7 @@ struct cso_velements {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   struct cso_cache_entry cache;
 };
 
 unsigned cso_construct_key(void *item, int item_size);
@@ -149,9 +171,9 @@ unsigned cso_construct_key(void *item, int item_size);
 struct cso_cache *cso_cache_create(void);
 void cso_cache_delete(struct cso_cache *sc);
 
-void cso_cache_set_sanitize_callback(struct cso_cache *sc,
-                                     cso_sanitize_callback cb,
-                                     void *user_data);
+void cso_cache_set_delete_callback(struct cso_cache *sc,
+                                   cso_delete_callback cb,
+                                   void *user_data);
 
 struct cso_hash_iter cso_insert_state(struct cso_cache *sc,
                                       unsigned hash_key, enum cso_cache_type type,
@@ -169,6 +191,9 @@ void * cso_take_state(struct cso_cache *sc, unsigned hash_key,
 void cso_set_maximum_cache_size(struct cso_cache *sc, int number);
 int cso_maximum_cache_size(const struct cso_cache *sc);
 
+void cso_cache_get_stats(const struct cso_cache *sc, enum cso_cache_type type,
+                         struct cso_cache_stats *stats);
+
 #ifdef	__cplusplus
 }
 #endif
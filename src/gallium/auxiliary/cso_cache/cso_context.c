@@ -135,6 +135,26 @@ struct pipe_context *cso_get_pipe_context(struct cso_context *cso)
    return cso->pipe;
 }
 
+/**
+ * Return the state object cache statistics summed over all the types.
+ */
+void cso_get_cache_stats(struct cso_context *cso,
+                         struct cso_cache_stats *stats)
+{
+   int i;
+
+   memset(stats, 0, sizeof(*stats));
+
+   for (i = 0; i < CSO_CACHE_MAX; i++) {
+      struct cso_cache_stats type_stats;
+
+      cso_cache_get_stats(cso->cache, i, &type_stats);
+      stats->hits += type_stats.hits;
+      stats->misses += type_stats.misses;
+      stats->evictions += type_stats.evictions;
+   }
+}
+
 static boolean delete_blend_state(struct cso_context *ctx, void *state)
 {
    struct cso_blend *cso = (struct cso_blend *)state;
@@ -163,9 +183,18 @@ static boolean delete_depth_stencil_state(struct cso_context *ctx, void *state)
    return TRUE;
 }
 
-static boolean delete_sampler_state(UNUSED struct cso_context *ctx, void *state)
+static boolean delete_sampler_state(struct cso_context *ctx, void *state)
 {
    struct cso_sampler *cso = (struct cso_sampler *)state;
+   unsigned i, j;
+
+   for (i = 0; i < PIPE_SHADER_TYPES; i++) {
+      for (j = 0; j < PIPE_MAX_SAMPLERS; j++) {
+         if (ctx->samplers[i].cso_samplers[j] == cso)
+            return FALSE;
+      }
+   }
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -220,71 +249,10 @@ static inline boolean delete_cso(struct cso_context *ctx,
    return FALSE;
 }
 
-static inline void
-sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
-              int max_size, void *user_data)
+static boolean
+delete_evicted_cso(void *state, enum cso_cache_type type, void *user_data)
 {
-   struct cso_context *ctx = (struct cso_context *)user_data;
-   /* if we're approach the maximum size, remove fourth of the entries
-    * otherwise every subsequent call will go through the same */
-   int hash_size = cso_hash_size(hash);
-   int max_entries = (max_size > hash_size) ? max_size : hash_size;
-   int to_remove =  (max_size < max_entries) * max_entries/4;
-   struct cso_hash_iter iter;
-   struct cso_sampler **samplers_to_restore = NULL;
-   unsigned to_restore = 0;
-
-   if (hash_size > max_size)
-      to_remove += hash_size - max_size;
-
-   if (to_remove == 0)
-      return;
-
-   if (type == CSO_SAMPLER) {
-      int i, j;
-
-      samplers_to_restore = MALLOC(PIPE_SHADER_TYPES * PIPE_MAX_SAMPLERS *
-                                   sizeof(*samplers_to_restore));
-
-      /* Temporarily remove currently bound sampler states from the hash
-       * table, to prevent them from being deleted
-       */
-      for (i = 0; i < PIPE_SHADER_TYPES; i++) {
-         for (j = 0; j < PIPE_MAX_SAMPLERS; j++) {
-            struct cso_sampler *sampler = ctx->samplers[i].cso_samplers[j];
-
-            if (sampler && cso_hash_take(hash, sampler->hash_key))
-               samplers_to_restore[to_restore++] = sampler;
-         }
-      }
-   }
-
-   iter = cso_hash_first_node(hash);
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      void *cso = cso_hash_iter_data(iter);
-
-      if (!cso)
-         break;
-
-      if (delete_cso(ctx, cso, type)) {
-         iter = cso_hash_erase(hash, iter);
-         --to_remove;
-      } else
-         iter = cso_hash_iter_next(iter);
-   }
-
-   if (type == CSO_SAMPLER) {
-      /* Put currently bound sampler states back into the hash table */
-      while (to_restore--) {
-         struct cso_sampler *sampler = samplers_to_restore[to_restore];
-
-         cso_hash_insert(hash, sampler->hash_key, sampler);
-      }
-
-      FREE(samplers_to_restore);
-   }
+   return delete_cso((struct cso_context *)user_data, state, type);
 }
 
 static void cso_init_vbuf(struct cso_context *cso, unsigned flags)
@@ -314,9 +282,9 @@ cso_create_context(struct pipe_context *pipe, unsigned flags)
    ctx->cache = cso_cache_create();
    if (ctx->cache == NULL)
       goto out;
-   cso_cache_set_sanitize_callback(ctx->cache,
-                                   sanitize_hash,
-                                   ctx);
+   cso_cache_set_delete_callback(ctx->cache,
+                                 delete_evicted_cso,
+                                 ctx);
 
    ctx->pipe = pipe;
    ctx->sample_mask = ~0;
@@ -1313,7 +1281,6 @@ cso_single_sampler(struct cso_context *ctx, enum pipe_shader_type shader_stage,
          cso->delete_state =
             (cso_state_callback) ctx->pipe->delete_sampler_state;
          cso->context = ctx->pipe;
-         cso->hash_key = hash_key;
 
          iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
          if (cso_hash_iter_is_null(iter)) {
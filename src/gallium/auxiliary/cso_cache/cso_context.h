@@ -39,6 +39,7 @@ extern "C" {
 #endif
 
 struct cso_context;
+struct cso_cache_stats;
 struct u_vbuf;
 
 #define CSO_NO_USER_VERTEX_BUFFERS (1 << 0)
@@ -47,6 +48,8 @@ struct cso_context *cso_create_context(struct pipe_context *pipe,
                                        unsigned flags);
 void cso_destroy_context( struct cso_context *cso );
 struct pipe_context *cso_get_pipe_context(struct cso_context *cso);
+void cso_get_cache_stats(struct cso_context *cso,
+                         struct cso_cache_stats *stats);
 
 
 enum pipe_error cso_set_blend( struct cso_context *cso,
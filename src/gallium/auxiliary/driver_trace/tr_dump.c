@@ -43,11 +43,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #include "pipe/p_compiler.h"
 #include "os/os_thread.h"
 #include "util/os_time.h"
 #include "util/u_debug.h"
 #include "util/u_memory.h"
+#include "util/u_queue.h"
 #include "util/u_string.h"
 #include "util/u_math.h"
 #include "util/format/u_format.h"
@@ -57,18 +62,124 @@
 #include "tr_texture.h"
 
 
+/** Size of the chunks of trace handed to the writer thread */
+#define TRACE_BUFFER_SIZE (1024 * 1024)
+
+/** Max number of chunks waiting to be written before the caller blocks */
+#define TRACE_MAX_PENDING 16
+
+
+struct trace_buffer
+{
+   struct util_queue_fence fence;
+   size_t size;
+   char data[TRACE_BUFFER_SIZE];
+};
+
+
 static bool close_stream = false;
 static FILE *stream = NULL;
+#ifdef HAVE_ZLIB
+static gzFile gz_stream = NULL;
+#endif
 static mtx_t call_mutex = _MTX_INITIALIZER_NP;
 static long unsigned call_no = 0;
 static bool dumping = false;
 
+/*
+ * The trace is written to the stream by a background thread, in chunks,
+ * unless GALLIUM_TRACE_SYNC is set.  In that case, the trace is written
+ * out after every call and before every draw, so that it's complete even
+ * if the driver crashes, which is a lot slower.
+ */
+static bool sync_writes = false;
+static bool writer_started = false;
+static struct util_queue writer;
+static struct trace_buffer *buffer = NULL;
 
-static inline void
+
+static inline bool
+trace_dump_stream_open(void)
+{
+#ifdef HAVE_ZLIB
+   if (gz_stream)
+      return true;
+#endif
+   return stream != NULL;
+}
+
+
+static void
+trace_dump_write_buffer(void *job, int thread_index)
+{
+   struct trace_buffer *buf = job;
+
+#ifdef HAVE_ZLIB
+   if (gz_stream) {
+      gzwrite(gz_stream, buf->data, buf->size);
+      return;
+   }
+#endif
+   fwrite(buf->data, buf->size, 1, stream);
+}
+
+
+static void
+trace_dump_free_buffer(void *job, int thread_index)
+{
+   struct trace_buffer *buf = job;
+
+   util_queue_fence_destroy(&buf->fence);
+   FREE(buf);
+}
+
+
+/**
+ * Hand the current chunk over to the writer thread, or write it out on
+ * this thread if there is no writer.
+ */
+static void
+trace_dump_submit(void)
+{
+   if (!buffer || !buffer->size)
+      return;
+
+   if (writer_started) {
+      util_queue_add_job(&writer, buffer, &buffer->fence,
+                         trace_dump_write_buffer, trace_dump_free_buffer, 0);
+   } else {
+      trace_dump_write_buffer(buffer, 0);
+      trace_dump_free_buffer(buffer, 0);
+   }
+   buffer = NULL;
+}
+
+
+static void
 trace_dump_write(const char *buf, size_t size)
 {
-   if (stream) {
-      fwrite(buf, size, 1, stream);
+   if (!trace_dump_stream_open())
+      return;
+
+   while (size) {
+      size_t n;
+
+      if (!buffer) {
+         buffer = MALLOC_STRUCT(trace_buffer);
+         if (!buffer)
+            return;
+         util_queue_fence_init(&buffer->fence);
+         buffer->size = 0;
+      }
+
+      n = MIN2(size, TRACE_BUFFER_SIZE - buffer->size);
+      memcpy(buffer->data + buffer->size, buf, n);
+      buffer->size += n;
+      buf += n;
+      size -= n;
+
+      if (buffer->size == TRACE_BUFFER_SIZE)
+         trace_dump_submit();
    }
 }
 
@@ -99,7 +210,17 @@ trace_dump_escape(const char *str)
    const unsigned char *p = (const unsigned char *)str;
    unsigned char c;
    while((c = *p++) != 0) {
-      if(c == '<')
+      /* Write runs of characters that need no escaping at once */
+      const unsigned char *run = p - 1;
+      while (c >= 0x20 && c <= 0x7e && c != '<' && c != '>' && c != '&' &&
+             c != '\'' && c != '\"')
+         c = *p++;
+      if (p - 1 > run)
+         trace_dump_write((const char *)run, p - 1 - run);
+
+      if(c == 0)
+         break;
+      else if(c == '<')
          trace_dump_writes("&lt;");
       else if(c == '>')
          trace_dump_writes("&gt;");
@@ -109,8 +230,6 @@ trace_dump_escape(const char *str)
          trace_dump_writes("&apos;");
       else if(c == '\"')
          trace_dump_writes("&quot;");
-      else if(c >= 0x20 && c <= 0x7e)
-         trace_dump_writef("%c", c);
       else
          trace_dump_writef("&#%u;", c);
    }
@@ -163,23 +282,47 @@ trace_dump_tag_end(const char *name)
    trace_dump_writes(">");
 }
 
+/**
+ * Write out everything dumped so far.  Only done with GALLIUM_TRACE_SYNC,
+ * otherwise the chunks are written as they fill up.
+ */
 void
 trace_dump_trace_flush(void)
 {
-   if (stream) {
-      fflush(stream);
+   if (trace_dump_stream_open() && sync_writes) {
+      trace_dump_submit();
+#ifdef HAVE_ZLIB
+      if (gz_stream)
+         gzflush(gz_stream, Z_SYNC_FLUSH);
+#endif
+      if (stream)
+         fflush(stream);
    }
 }
 
 static void
 trace_dump_trace_close(void)
 {
-   if (stream) {
+   if (trace_dump_stream_open()) {
       trace_dump_writes("</trace>\n");
+      trace_dump_submit();
+      if (writer_started) {
+         util_queue_finish(&writer);
+         util_queue_destroy(&writer);
+         writer_started = false;
+      }
+#ifdef HAVE_ZLIB
+      if (gz_stream) {
+         gzclose(gz_stream);
+         gz_stream = NULL;
+      }
+#endif
       if (close_stream) {
          fclose(stream);
          close_stream = false;
          stream = NULL;
+      } else if (stream) {
+         fflush(stream);
       }
       call_no = 0;
    }
@@ -189,7 +332,7 @@ trace_dump_trace_close(void)
 static void
 trace_dump_call_time(int64_t time)
 {
-   if (stream) {
+   if (trace_dump_stream_open()) {
       trace_dump_indent(2);
       trace_dump_tag_begin("time");
       trace_dump_int(time);
@@ -208,7 +351,7 @@ trace_dump_trace_begin(void)
    if (!filename)
       return false;
 
-   if (!stream) {
+   if (!trace_dump_stream_open()) {
 
       if (strcmp(filename, "stderr") == 0) {
          close_stream = false;
@@ -218,6 +361,15 @@ trace_dump_trace_begin(void)
          close_stream = false;
          stream = stdout;
       }
+#ifdef HAVE_ZLIB
+      /* Compress traces named *.gz, the tools read them directly */
+      else if (strlen(filename) > 3 &&
+               strcmp(filename + strlen(filename) - 3, ".gz") == 0) {
+         gz_stream = gzopen(filename, "wb");
+         if (!gz_stream)
+            return false;
+      }
+#endif
       else {
          close_stream = true;
          stream = fopen(filename, "wt");
@@ -225,6 +377,12 @@ trace_dump_trace_begin(void)
             return false;
       }
 
+      sync_writes = debug_get_bool_option("GALLIUM_TRACE_SYNC", false);
+      if (!sync_writes) {
+         writer_started = util_queue_init(&writer, "trace", TRACE_MAX_PENDING,
+                                          1, 0);
+      }
+
       trace_dump_writes("<?xml version='1.0' encoding='UTF-8'?>\n");
       trace_dump_writes("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n");
       trace_dump_writes("<trace version='0.1'>\n");
@@ -241,7 +399,7 @@ trace_dump_trace_begin(void)
 
 bool trace_dump_trace_enabled(void)
 {
-   return stream ? true : false;
+   return trace_dump_stream_open();
 }
 
 /*
@@ -338,7 +496,7 @@ void trace_dump_call_end_locked(void)
    trace_dump_indent(1);
    trace_dump_tag_end("call");
    trace_dump_newline();
-   fflush(stream);
+   trace_dump_trace_flush();
 }
 
 void trace_dump_call_begin(const char *klass, const char *method)
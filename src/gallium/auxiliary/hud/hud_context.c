@@ -1273,6 +1273,15 @@ hud_parse_env_var(struct hud_context *hud, struct pipe_screen *screen,
       else if (strcmp(name, "main-thread-busy") == 0) {
          hud_thread_busy_install(pane, name, true);
       }
+      else if (strcmp(name, "cso-cache-hits") == 0) {
+         hud_cso_graph_install(pane, name, HUD_CSO_HITS);
+      }
+      else if (strcmp(name, "cso-cache-misses") == 0) {
+         hud_cso_graph_install(pane, name, HUD_CSO_MISSES);
+      }
+      else if (strcmp(name, "cso-cache-evictions") == 0) {
+         hud_cso_graph_install(pane, name, HUD_CSO_EVICTIONS);
+      }
 #ifdef HAVE_GALLIUM_EXTRA_HUD
       else if (sscanf(name, "nic-rx-%s", arg_name) == 1) {
          hud_nic_graph_install(pane, arg_name, NIC_DIRECTION_RX);
@@ -1565,6 +1574,9 @@ print_help(struct pipe_screen *screen)
    puts("    fps");
    puts("    frametime");
    puts("    cpu");
+   puts("    cso-cache-hits");
+   puts("    cso-cache-misses");
+   puts("    cso-cache-evictions");
 
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
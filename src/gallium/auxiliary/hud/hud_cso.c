@@ -0,0 +1,121 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/* This file contains code for displaying the state object cache statistics
+ * of the drawing context on the HUD.
+ */
+
+#include "hud/hud_private.h"
+#include "cso_cache/cso_cache.h"
+#include "cso_cache/cso_context.h"
+#include "util/os_time.h"
+#include "util/u_memory.h"
+
+struct cso_info {
+   enum hud_cso_counter counter;
+   uint64_t last_value;
+   uint64_t last_time;
+};
+
+static uint64_t
+get_counter(struct hud_graph *gr, enum hud_cso_counter counter)
+{
+   struct cso_context *cso = gr->pane->hud->cso;
+   struct cso_cache_stats stats;
+
+   if (!cso)
+      return 0;
+
+   cso_get_cache_stats(cso, &stats);
+
+   switch (counter) {
+   case HUD_CSO_HITS:
+      return stats.hits;
+   case HUD_CSO_MISSES:
+      return stats.misses;
+   case HUD_CSO_EVICTIONS:
+      return stats.evictions;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+static void
+query_cso_counter(struct hud_graph *gr, struct pipe_context *pipe)
+{
+   struct cso_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period <= now) {
+         uint64_t current_value = get_counter(gr, info->counter);
+
+         hud_graph_add_value(gr, current_value - info->last_value);
+         info->last_value = current_value;
+         info->last_time = now;
+      }
+   } else {
+      /* initialize */
+      info->last_value = get_counter(gr, info->counter);
+      info->last_time = now;
+   }
+}
+
+static void
+free_query_data(void *p, struct pipe_context *pipe)
+{
+   FREE(p);
+}
+
+void
+hud_cso_graph_install(struct hud_pane *pane, const char *name,
+                      enum hud_cso_counter counter)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+
+   if (!gr)
+      return;
+
+   strcpy(gr->name, name);
+   gr->query_data = CALLOC_STRUCT(cso_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   ((struct cso_info*)gr->query_data)->counter = counter;
+   gr->query_new_value = query_cso_counter;
+
+   /* Don't use free() as our callback as that messes up Gallium's
+    * memory debugger.  Use simple free_query_data() wrapper.
+    */
+   gr->free_query_data = free_query_data;
+
+   hud_pane_add_graph(pane, gr);
+}
@@ -39,6 +39,12 @@ enum hud_counter {
    HUD_COUNTER_SYNCS,
 };
 
+enum hud_cso_counter {
+   HUD_CSO_HITS,
+   HUD_CSO_MISSES,
+   HUD_CSO_EVICTIONS,
+};
+
 struct hud_context {
    int refcount;
    bool simple;
@@ -158,6 +164,8 @@ int hud_get_num_cpus(void);
 
 void hud_fps_graph_install(struct hud_pane *pane);
 void hud_frametime_graph_install(struct hud_pane *pane);
+void hud_cso_graph_install(struct hud_pane *pane, const char *name,
+                           enum hud_cso_counter counter);
 void hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index);
 void hud_thread_busy_install(struct hud_pane *pane, const char *name, bool main);
 void hud_thread_counter_install(struct hud_pane *pane, const char *name,
@@ -27,10 +27,28 @@
  **************************************************************************/
 
 #include "pb_cache.h"
+#include "util/u_atomic.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_thread.h"
 #include "util/os_time.h"
 
 
+static unsigned
+pb_cache_size_class(pb_size size)
+{
+   return size ? util_logbase2_64(size) : 0;
+}
+
+static void
+update_nonempty_class_locked(struct pb_cache_heap *heap, unsigned size_class)
+{
+   if (list_is_empty(&heap->size_classes[size_class]))
+      heap->nonempty_classes &= ~BITFIELD64_BIT(size_class);
+   else
+      heap->nonempty_classes |= BITFIELD64_BIT(size_class);
+}
+
 /**
  * Actually destroy the buffer.
  */
@@ -43,9 +61,11 @@ destroy_buffer_locked(struct pb_cache_entry *entry)
    assert(!pipe_is_referenced(&buf->reference));
    if (entry->head.next) {
       list_del(&entry->head);
+      update_nonempty_class_locked(&mgr->heaps[entry->bucket_index],
+                                   pb_cache_size_class(buf->size));
       assert(mgr->num_buffers);
-      --mgr->num_buffers;
-      mgr->cache_size -= buf->size;
+      p_atomic_dec(&mgr->num_buffers);
+      p_atomic_add(&mgr->cache_size, -(int64_t)buf->size);
    }
    mgr->destroy_buffer(buf);
 }
@@ -75,6 +95,16 @@ release_expired_buffers_locked(struct list_head *cache,
    }
 }
 
+static void
+release_expired_heap_locked(struct pb_cache_heap *heap, int64_t current_time)
+{
+   uint64_t mask = heap->nonempty_classes;
+
+   while (mask)
+      release_expired_buffers_locked(&heap->size_classes[u_bit_scan64(&mask)],
+                                     current_time);
+}
+
 /**
  * Add a buffer to the cache. This is typically done when the buffer is
  * being released.
@@ -83,31 +113,43 @@ void
 pb_cache_add_buffer(struct pb_cache_entry *entry)
 {
    struct pb_cache *mgr = entry->mgr;
-   struct list_head *cache = &mgr->buckets[entry->bucket_index];
+   struct pb_cache_heap *heap = &mgr->heaps[entry->bucket_index];
    struct pb_buffer *buf = entry->buffer;
+   unsigned size_class = pb_cache_size_class(buf->size);
+   struct list_head *cache = &heap->size_classes[size_class];
    unsigned i;
 
-   mtx_lock(&mgr->mutex);
    assert(!pipe_is_referenced(&buf->reference));
 
    int64_t current_time = os_time_get();
 
-   for (i = 0; i < mgr->num_heaps; i++)
-      release_expired_buffers_locked(&mgr->buckets[i], current_time);
+   /* Release the expired buffers of the other heaps too, unless they are
+    * in use by another thread.
+    */
+   for (i = 0; i < mgr->num_heaps; i++) {
+      if (&mgr->heaps[i] != heap && mtx_trylock(&mgr->heaps[i].mutex) == thrd_success) {
+         release_expired_heap_locked(&mgr->heaps[i], current_time);
+         mtx_unlock(&mgr->heaps[i].mutex);
+      }
+   }
+
+   mtx_lock(&heap->mutex);
+   release_expired_heap_locked(heap, current_time);
 
    /* Directly release any buffer that exceeds the limit. */
-   if (mgr->cache_size + buf->size > mgr->max_cache_size) {
+   if (p_atomic_read(&mgr->cache_size) + buf->size > mgr->max_cache_size) {
       mgr->destroy_buffer(buf);
-      mtx_unlock(&mgr->mutex);
+      mtx_unlock(&heap->mutex);
       return;
    }
 
    entry->start = os_time_get();
    entry->end = entry->start + mgr->usecs;
    list_addtail(&entry->head, cache);
-   ++mgr->num_buffers;
-   mgr->cache_size += buf->size;
-   mtx_unlock(&mgr->mutex);
+   heap->nonempty_classes |= BITFIELD64_BIT(size_class);
+   p_atomic_inc(&mgr->num_buffers);
+   p_atomic_add(&mgr->cache_size, buf->size);
+   mtx_unlock(&heap->mutex);
 }
 
 /**
@@ -127,7 +169,7 @@ pb_cache_is_buffer_compat(struct pb_cache_entry *entry,
 
    /* be lenient with size */
    if (buf->size < size ||
-       buf->size > (unsigned) (mgr->size_factor * size))
+       buf->size > (pb_size) (mgr->size_factor * size))
       return 0;
 
    if (usage & mgr->bypass_usage)
@@ -140,31 +182,23 @@ pb_cache_is_buffer_compat(struct pb_cache_entry *entry,
 }
 
 /**
- * Find a compatible buffer in the cache, return it, and remove it
- * from the cache.
+ * Find a compatible buffer in one size class and remove it from the list.
  */
-struct pb_buffer *
-pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
-                        unsigned alignment, unsigned usage,
-                        unsigned bucket_index)
+static struct pb_cache_entry *
+pb_cache_reclaim_from_list_locked(struct list_head *cache, int64_t now,
+                                  pb_size size, unsigned alignment,
+                                  unsigned usage)
 {
    struct pb_cache_entry *entry;
    struct pb_cache_entry *cur_entry;
    struct list_head *cur, *next;
-   int64_t now;
    int ret = 0;
 
-   assert(bucket_index < mgr->num_heaps);
-   struct list_head *cache = &mgr->buckets[bucket_index];
-
-   mtx_lock(&mgr->mutex);
-
    entry = NULL;
    cur = cache->next;
    next = cur->next;
 
    /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
    while (cur != cache) {
       cur_entry = LIST_ENTRY(struct pb_cache_entry, cur, head);
 
@@ -203,20 +237,58 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
       }
    }
 
+   return entry;
+}
+
+/**
+ * Find a compatible buffer in the cache, return it, and remove it
+ * from the cache.
+ */
+struct pb_buffer *
+pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
+                        unsigned alignment, unsigned usage,
+                        unsigned bucket_index)
+{
+   struct pb_cache_entry *entry = NULL;
+   int64_t now;
+
+   assert(bucket_index < mgr->num_heaps);
+   struct pb_cache_heap *heap = &mgr->heaps[bucket_index];
+
+   /* Only the size classes that can hold buffers between "size" and
+    * "size_factor * size" need to be searched.
+    */
+   unsigned first = pb_cache_size_class(size);
+   unsigned last = MIN2(pb_cache_size_class((pb_size)(mgr->size_factor * size)),
+                        PB_CACHE_NUM_SIZE_CLASSES - 1);
+
+   mtx_lock(&heap->mutex);
+
+   uint64_t mask = heap->nonempty_classes &
+                   BITFIELD64_RANGE(first, last - first + 1);
+
+   now = os_time_get();
+   while (mask && !entry) {
+      entry = pb_cache_reclaim_from_list_locked(
+                 &heap->size_classes[u_bit_scan64(&mask)], now,
+                 size, alignment, usage);
+   }
+
    /* found a compatible buffer, return it */
    if (entry) {
       struct pb_buffer *buf = entry->buffer;
 
-      mgr->cache_size -= buf->size;
+      p_atomic_add(&mgr->cache_size, -(int64_t)buf->size);
       list_del(&entry->head);
-      --mgr->num_buffers;
-      mtx_unlock(&mgr->mutex);
+      update_nonempty_class_locked(heap, pb_cache_size_class(buf->size));
+      p_atomic_dec(&mgr->num_buffers);
+      mtx_unlock(&heap->mutex);
       /* Increase refcount */
       pipe_reference_init(&buf->reference, 1);
       return buf;
    }
 
-   mtx_unlock(&mgr->mutex);
+   mtx_unlock(&heap->mutex);
    return NULL;
 }
 
@@ -228,22 +300,26 @@ pb_cache_release_all_buffers(struct pb_cache *mgr)
 {
    struct list_head *curr, *next;
    struct pb_cache_entry *buf;
-   unsigned i;
+   unsigned i, j;
 
-   mtx_lock(&mgr->mutex);
    for (i = 0; i < mgr->num_heaps; i++) {
-      struct list_head *cache = &mgr->buckets[i];
+      struct pb_cache_heap *heap = &mgr->heaps[i];
 
-      curr = cache->next;
-      next = curr->next;
-      while (curr != cache) {
-         buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
-         destroy_buffer_locked(buf);
-         curr = next;
+      mtx_lock(&heap->mutex);
+      for (j = 0; j < PB_CACHE_NUM_SIZE_CLASSES; j++) {
+         struct list_head *cache = &heap->size_classes[j];
+
+         curr = cache->next;
          next = curr->next;
+         while (curr != cache) {
+            buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
+            destroy_buffer_locked(buf);
+            curr = next;
+            next = curr->next;
+         }
       }
+      mtx_unlock(&heap->mutex);
    }
-   mtx_unlock(&mgr->mutex);
 }
 
 void
@@ -258,6 +334,80 @@ pb_cache_init_entry(struct pb_cache *mgr, struct pb_cache_entry *entry,
    entry->bucket_index = bucket_index;
 }
 
+/**
+ * Release the expired buffers, and then the oldest buffers of each size
+ * class, largest first, until the cache fits into the trimmer budget.
+ */
+static void
+pb_cache_trim(struct pb_cache *mgr)
+{
+   int64_t current_time = os_time_get();
+
+   for (unsigned i = 0; i < mgr->num_heaps; i++) {
+      mtx_lock(&mgr->heaps[i].mutex);
+      release_expired_heap_locked(&mgr->heaps[i], current_time);
+      mtx_unlock(&mgr->heaps[i].mutex);
+   }
+
+   for (int j = PB_CACHE_NUM_SIZE_CLASSES - 1; j >= 0; j--) {
+      for (unsigned i = 0; i < mgr->num_heaps; i++) {
+         struct pb_cache_heap *heap = &mgr->heaps[i];
+         struct list_head *cache = &heap->size_classes[j];
+
+         if (p_atomic_read(&mgr->cache_size) <= mgr->trimmer.budget)
+            return;
+
+         mtx_lock(&heap->mutex);
+         while (!list_is_empty(cache) &&
+                p_atomic_read(&mgr->cache_size) > mgr->trimmer.budget) {
+            destroy_buffer_locked(LIST_ENTRY(struct pb_cache_entry,
+                                             cache->next, head));
+         }
+         mtx_unlock(&heap->mutex);
+      }
+   }
+}
+
+static int
+pb_cache_trimmer_thread(void *data)
+{
+   struct pb_cache *mgr = (struct pb_cache*)data;
+
+   u_thread_setname("pb_cache");
+
+   /* Releasing expired buffers only needs a wakeup per expiry period.  When
+    * the budget is smaller than the maximum cache size, wake up a few times
+    * per period so that it is enforced soon after a burst.  Don't spin if
+    * buffers expire immediately.
+    */
+   unsigned period = mgr->trimmer.budget < mgr->max_cache_size ?
+                     mgr->usecs / 4 : mgr->usecs;
+   period = MAX2(period, 1000);
+
+   mtx_lock(&mgr->trimmer.mutex);
+   while (!mgr->trimmer.exit) {
+      struct timespec ts;
+
+      timespec_get(&ts, TIME_UTC);
+      ts.tv_sec += period / 1000000;
+      ts.tv_nsec += (period % 1000000) * 1000;
+      if (ts.tv_nsec >= 1000000000) {
+         ts.tv_sec++;
+         ts.tv_nsec -= 1000000000;
+      }
+
+      cnd_timedwait(&mgr->trimmer.cond, &mgr->trimmer.mutex, &ts);
+      if (mgr->trimmer.exit)
+         break;
+
+      mtx_unlock(&mgr->trimmer.mutex);
+      pb_cache_trim(mgr);
+      mtx_lock(&mgr->trimmer.mutex);
+   }
+   mtx_unlock(&mgr->trimmer.mutex);
+   return 0;
+}
+
 /**
  * Initialize a caching buffer manager.
  *
@@ -283,16 +433,18 @@ pb_cache_init(struct pb_cache *mgr, uint num_heaps,
               void (*destroy_buffer)(struct pb_buffer *buf),
               bool (*can_reclaim)(struct pb_buffer *buf))
 {
-   unsigned i;
+   unsigned i, j;
 
-   mgr->buckets = CALLOC(num_heaps, sizeof(struct list_head));
-   if (!mgr->buckets)
+   mgr->heaps = CALLOC(num_heaps, sizeof(struct pb_cache_heap));
+   if (!mgr->heaps)
       return;
 
-   for (i = 0; i < num_heaps; i++)
-      list_inithead(&mgr->buckets[i]);
+   for (i = 0; i < num_heaps; i++) {
+      (void) mtx_init(&mgr->heaps[i].mutex, mtx_plain);
+      for (j = 0; j < PB_CACHE_NUM_SIZE_CLASSES; j++)
+         list_inithead(&mgr->heaps[i].size_classes[j]);
+   }
 
-   (void) mtx_init(&mgr->mutex, mtx_plain);
    mgr->cache_size = 0;
    mgr->max_cache_size = maximum_cache_size;
    mgr->num_heaps = num_heaps;
@@ -302,6 +454,33 @@ pb_cache_init(struct pb_cache *mgr, uint num_heaps,
    mgr->size_factor = size_factor;
    mgr->destroy_buffer = destroy_buffer;
    mgr->can_reclaim = can_reclaim;
+   mgr->trimmer.started = false;
+}
+
+/**
+ * Start a thread that periodically releases expired buffers even when no
+ * buffers are allocated or released, and that releases more buffers when
+ * the cache holds more than "budget" bytes.  Pass the maximum cache size
+ * as the budget to only release expired buffers.
+ */
+void
+pb_cache_start_trimmer(struct pb_cache *mgr, uint64_t budget)
+{
+   if (!mgr->heaps || mgr->trimmer.started)
+      return;
+
+   (void) mtx_init(&mgr->trimmer.mutex, mtx_plain);
+   cnd_init(&mgr->trimmer.cond);
+   mgr->trimmer.budget = budget;
+   mgr->trimmer.exit = false;
+
+   mgr->trimmer.thread = u_thread_create(pb_cache_trimmer_thread, mgr);
+   if (!mgr->trimmer.thread) {
+      cnd_destroy(&mgr->trimmer.cond);
+      mtx_destroy(&mgr->trimmer.mutex);
+      return;
+   }
+   mgr->trimmer.started = true;
 }
 
 /**
@@ -310,8 +489,22 @@ pb_cache_init(struct pb_cache *mgr, uint num_heaps,
 void
 pb_cache_deinit(struct pb_cache *mgr)
 {
+   unsigned i;
+
+   if (mgr->trimmer.started) {
+      mtx_lock(&mgr->trimmer.mutex);
+      mgr->trimmer.exit = true;
+      cnd_signal(&mgr->trimmer.cond);
+      mtx_unlock(&mgr->trimmer.mutex);
+      thrd_join(mgr->trimmer.thread, NULL);
+      cnd_destroy(&mgr->trimmer.cond);
+      mtx_destroy(&mgr->trimmer.mutex);
+      mgr->trimmer.started = false;
+   }
+
    pb_cache_release_all_buffers(mgr);
-   mtx_destroy(&mgr->mutex);
-   FREE(mgr->buckets);
-   mgr->buckets = NULL;
+   for (i = 0; i < mgr->num_heaps; i++)
+      mtx_destroy(&mgr->heaps[i].mutex);
+   FREE(mgr->heaps);
+   mgr->heaps = NULL;
 }
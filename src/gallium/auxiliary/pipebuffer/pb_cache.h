@@ -45,14 +45,26 @@ struct pb_cache_entry
    unsigned bucket_index;
 };
 
+/* Buffers are sorted into size classes by the highest set bit of their size,
+ * so that a lookup only walks lists of buffers close to the requested size.
+ */
+#define PB_CACHE_NUM_SIZE_CLASSES 64
+
+struct pb_cache_heap
+{
+   mtx_t mutex;
+   uint64_t nonempty_classes; /**< Bitmask of the non-empty size classes */
+   struct list_head size_classes[PB_CACHE_NUM_SIZE_CLASSES];
+};
+
 struct pb_cache
 {
    /* The cache is divided into buckets for minimizing cache misses.
     * The driver controls which buffer goes into which bucket.
+    * Each bucket is a heap with its own lock.
     */
-   struct list_head *buckets;
+   struct pb_cache_heap *heaps;
 
-   mtx_t mutex;
    uint64_t cache_size;
    uint64_t max_cache_size;
    unsigned num_heaps;
@@ -63,6 +75,16 @@ struct pb_cache
 
    void (*destroy_buffer)(struct pb_buffer *buf);
    bool (*can_reclaim)(struct pb_buffer *buf);
+
+   /* Optional thread releasing expired buffers and enforcing the budget. */
+   struct {
+      thrd_t thread;
+      mtx_t mutex;
+      cnd_t cond;
+      uint64_t budget;
+      bool started;
+      bool exit;
+   } trimmer;
 };
 
 void pb_cache_add_buffer(struct pb_cache_entry *entry);
@@ -77,6 +99,7 @@ void pb_cache_init(struct pb_cache *mgr, uint num_heaps,
                    unsigned bypass_usage, uint64_t maximum_cache_size,
                    void (*destroy_buffer)(struct pb_buffer *buf),
                    bool (*can_reclaim)(struct pb_buffer *buf));
+void pb_cache_start_trimmer(struct pb_cache *mgr, uint64_t budget);
 void pb_cache_deinit(struct pb_cache *mgr);
 
 #endif
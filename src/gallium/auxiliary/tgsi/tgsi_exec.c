@@ -64,6 +64,59 @@
 #include "util/rounding.h"
 
 
+#if defined(PIPE_ARCH_SSE)
+
+#include <emmintrin.h>
+
+/*
+ * A channel holds one component of all TGSI_QUAD_SIZE lanes, which fits
+ * exactly in an SSE register.  The most common channel operations use the
+ * helpers below to run as single vector instructions instead of four scalar
+ * ones.  They give the same results as the C code, signed zeros included;
+ * only the payload of NaNs may differ, as it does between compilers.
+ */
+
+static inline __m128
+load_chan_ps(const union tgsi_exec_channel *chan)
+{
+   return _mm_loadu_ps(chan->f);
+}
+
+static inline __m128i
+load_chan_epi32(const union tgsi_exec_channel *chan)
+{
+   return _mm_loadu_si128((const __m128i *)chan->i);
+}
+
+static inline void
+store_chan_ps(union tgsi_exec_channel *chan, __m128 v)
+{
+   _mm_storeu_ps(chan->f, v);
+}
+
+static inline void
+store_chan_epi32(union tgsi_exec_channel *chan, __m128i v)
+{
+   _mm_storeu_si128((__m128i *)chan->i, v);
+}
+
+/** Pick a where mask is set, b elsewhere */
+static inline __m128
+select_ps(__m128 mask, __m128 a, __m128 b)
+{
+   return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/** 1.0f where mask is set, 0.0f elsewhere */
+static inline void
+store_chan_set(union tgsi_exec_channel *chan, __m128 mask)
+{
+   store_chan_ps(chan, _mm_and_ps(mask, _mm_set1_ps(1.0f)));
+}
+
+#endif /* PIPE_ARCH_SSE */
+
+
 #define DEBUG_EXECUTION 0
 
 
@@ -90,10 +143,14 @@ static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_andnot_ps(_mm_set1_ps(-0.0f), load_chan_ps(src)));
+#else
    dst->f[0] = fabsf(src->f[0]);
    dst->f[1] = fabsf(src->f[1]);
    dst->f[2] = fabsf(src->f[2]);
    dst->f[3] = fabsf(src->f[3]);
+#endif
 }
 
 static void
@@ -132,10 +189,15 @@ micro_cmp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, select_ps(_mm_cmplt_ps(load_chan_ps(src0), _mm_setzero_ps()),
+                                 load_chan_ps(src1), load_chan_ps(src2)));
+#else
    dst->f[0] = src0->f[0] < 0.0f ? src1->f[0] : src2->f[0];
    dst->f[1] = src0->f[1] < 0.0f ? src1->f[1] : src2->f[1];
    dst->f[2] = src0->f[2] < 0.0f ? src1->f[2] : src2->f[2];
    dst->f[3] = src0->f[3] < 0.0f ? src1->f[3] : src2->f[3];
+#endif
 }
 
 static void
@@ -517,10 +579,16 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_add_ps(_mm_mul_ps(load_chan_ps(src0),
+                                             _mm_sub_ps(load_chan_ps(src1), load_chan_ps(src2))),
+                                  load_chan_ps(src2)));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -529,20 +597,28 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_add_ps(_mm_mul_ps(load_chan_ps(src0), load_chan_ps(src1)), load_chan_ps(src2)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
 micro_mov(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, load_chan_epi32(src));
+#else
    dst->u[0] = src->u[0];
    dst->u[1] = src->u[1];
    dst->u[2] = src->u[2];
    dst->u[3] = src->u[3];
+#endif
 }
 
 static void
@@ -602,10 +678,14 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmpeq_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -613,10 +693,14 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmpge_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -644,10 +728,14 @@ micro_sgt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmpgt_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] > src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] > src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] > src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -665,10 +753,14 @@ micro_sle(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmple_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] <= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] <= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] <= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] <= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -676,10 +768,14 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmplt_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -687,10 +783,14 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_set(dst, _mm_cmpneq_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -1335,10 +1435,14 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_add_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -1380,10 +1484,15 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   /* maxps returns the second operand unless the first is greater */
+   store_chan_ps(dst, _mm_max_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1391,10 +1500,15 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   /* minps returns the second operand unless the first is less */
+   store_chan_ps(dst, _mm_min_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1402,10 +1516,14 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_mul_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1413,10 +1531,14 @@ micro_neg(
    union tgsi_exec_channel *dst,
    const union tgsi_exec_channel *src )
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_xor_ps(_mm_set1_ps(-0.0f), load_chan_ps(src)));
+#else
    dst->f[0] = -src->f[0];
    dst->f[1] = -src->f[1];
    dst->f[2] = -src->f[2];
    dst->f[3] = -src->f[3];
+#endif
 }
 
 static void
@@ -1454,10 +1576,14 @@ micro_sub(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_sub_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->f[0] = src0->f[0] - src1->f[0];
    dst->f[1] = src0->f[1] - src1->f[1];
    dst->f[2] = src0->f[2] - src1->f[2];
    dst->f[3] = src0->f[3] - src1->f[3];
+#endif
 }
 
 static void
@@ -1957,6 +2083,25 @@ store_dest(struct tgsi_exec_machine *mach,
    if (!dst)
       return;
 
+#if defined(PIPE_ARCH_SSE)
+   {
+      const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+      const __m128 mask = _mm_castsi128_ps(
+         _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(execmask), lanes),
+                         lanes));
+      __m128 v = load_chan_ps(chan);
+
+      if (inst->Instruction.Saturate) {
+         /* NaNs and -0.0 are passed through, like below */
+         v = select_ps(_mm_cmplt_ps(v, _mm_setzero_ps()), _mm_setzero_ps(), v);
+         v = select_ps(_mm_cmpgt_ps(v, _mm_set1_ps(1.0f)), _mm_set1_ps(1.0f), v);
+      }
+
+      store_chan_ps(dst, select_ps(mask, v, load_chan_ps(dst)));
+      return;
+   }
+#endif
+
    if (!inst->Instruction.Saturate) {
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i))
@@ -4595,20 +4740,29 @@ static void
 micro_i2f(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_cvtepi32_ps(load_chan_epi32(src)));
+#else
    dst->f[0] = (float)src->i[0];
    dst->f[1] = (float)src->i[1];
    dst->f[2] = (float)src->i[2];
    dst->f[3] = (float)src->i[3];
+#endif
 }
 
 static void
 micro_not(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_xor_si128(load_chan_epi32(src),
+                                      _mm_set1_epi32(~0)));
+#else
    dst->u[0] = ~src->u[0];
    dst->u[1] = ~src->u[1];
    dst->u[2] = ~src->u[2];
    dst->u[3] = ~src->u[3];
+#endif
 }
 
 static void
@@ -4632,10 +4786,14 @@ micro_and(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_and_si128(load_chan_epi32(src0), load_chan_epi32(src1)));
+#else
    dst->u[0] = src0->u[0] & src1->u[0];
    dst->u[1] = src0->u[1] & src1->u[1];
    dst->u[2] = src0->u[2] & src1->u[2];
    dst->u[3] = src0->u[3] & src1->u[3];
+#endif
 }
 
 static void
@@ -4643,10 +4801,14 @@ micro_or(union tgsi_exec_channel *dst,
          const union tgsi_exec_channel *src0,
          const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_or_si128(load_chan_epi32(src0), load_chan_epi32(src1)));
+#else
    dst->u[0] = src0->u[0] | src1->u[0];
    dst->u[1] = src0->u[1] | src1->u[1];
    dst->u[2] = src0->u[2] | src1->u[2];
    dst->u[3] = src0->u[3] | src1->u[3];
+#endif
 }
 
 static void
@@ -4654,10 +4816,14 @@ micro_xor(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_xor_si128(load_chan_epi32(src0), load_chan_epi32(src1)));
+#else
    dst->u[0] = src0->u[0] ^ src1->u[0];
    dst->u[1] = src0->u[1] ^ src1->u[1];
    dst->u[2] = src0->u[2] ^ src1->u[2];
    dst->u[3] = src0->u[3] ^ src1->u[3];
+#endif
 }
 
 static void
@@ -4675,10 +4841,14 @@ static void
 micro_f2i(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_cvttps_epi32(load_chan_ps(src)));
+#else
    dst->i[0] = (int)src->f[0];
    dst->i[1] = (int)src->f[1];
    dst->i[2] = (int)src->f[2];
    dst->i[3] = (int)src->f[3];
+#endif
 }
 
 static void
@@ -4686,10 +4856,14 @@ micro_fseq(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_cmpeq_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->u[0] = src0->f[0] == src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] == src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] == src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] == src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4697,10 +4871,14 @@ micro_fsge(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_cmpge_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->u[0] = src0->f[0] >= src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] >= src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] >= src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] >= src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4708,10 +4886,14 @@ micro_fslt(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_cmplt_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->u[0] = src0->f[0] < src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] < src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] < src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] < src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4719,10 +4901,14 @@ micro_fsne(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_ps(dst, _mm_cmpneq_ps(load_chan_ps(src0), load_chan_ps(src1)));
+#else
    dst->u[0] = src0->f[0] != src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] != src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] != src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] != src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4821,10 +5007,14 @@ micro_uadd(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_add_epi32(load_chan_epi32(src0), load_chan_epi32(src1)));
+#else
    dst->u[0] = src0->u[0] + src1->u[0];
    dst->u[1] = src0->u[1] + src1->u[1];
    dst->u[2] = src0->u[2] + src1->u[2];
    dst->u[3] = src0->u[3] + src1->u[3];
+#endif
 }
 
 static void
@@ -4925,10 +5115,14 @@ micro_useq(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_cmpeq_epi32(load_chan_epi32(src0), load_chan_epi32(src1)));
+#else
    dst->u[0] = src0->u[0] == src1->u[0] ? ~0 : 0;
    dst->u[1] = src0->u[1] == src1->u[1] ? ~0 : 0;
    dst->u[2] = src0->u[2] == src1->u[2] ? ~0 : 0;
    dst->u[3] = src0->u[3] == src1->u[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4974,10 +5168,15 @@ micro_usne(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   store_chan_epi32(dst, _mm_xor_si128(_mm_cmpeq_epi32(load_chan_epi32(src0), load_chan_epi32(src1)),
+                                      _mm_set1_epi32(~0)));
+#else
    dst->u[0] = src0->u[0] != src1->u[0] ? ~0 : 0;
    dst->u[1] = src0->u[1] != src1->u[1] ? ~0 : 0;
    dst->u[2] = src0->u[2] != src1->u[2] ? ~0 : 0;
    dst->u[3] = src0->u[3] != src1->u[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -43,8 +43,14 @@
 typedef void (*fetch_func)(void *dst,
                            const uint8_t *src,
                            unsigned i, unsigned j);
+typedef void (*unpack_func)(void *dst, unsigned dst_stride,
+                            const uint8_t *src, unsigned src_stride,
+                            unsigned width, unsigned height);
 typedef void (*emit_func)(const void *attrib, void *ptr);
 
+/** Number of vertices unpacked at once by generic_run() */
+#define BATCH_SIZE 64
+
 
 
 struct translate_generic {
@@ -54,6 +60,10 @@ struct translate_generic {
       enum translate_element_type type;
 
       fetch_func fetch;
+      /* row version of fetch, NULL if it can't be used */
+      unpack_func unpack;
+      /* the unpacked data is already in the output format */
+      boolean unpack_to_output;
       unsigned buffer;
       unsigned input_offset;
       unsigned instance_divisor;
@@ -586,6 +596,66 @@ get_emit_func(enum pipe_format format)
    }
 }
 
+static ALWAYS_INLINE void
+generic_run_attrib(struct translate_generic *tg,
+                   unsigned attr,
+                   unsigned elt,
+                   unsigned start_instance,
+                   unsigned instance_id,
+                   void *vert)
+{
+   float data[4];
+   uint8_t *dst = (uint8_t *)vert + tg->attrib[attr].output_offset;
+
+   if (tg->attrib[attr].type == TRANSLATE_ELEMENT_NORMAL) {
+      const uint8_t *src;
+      unsigned index;
+      int copy_size;
+
+      if (tg->attrib[attr].instance_divisor) {
+         index = start_instance;
+         index += (instance_id  / tg->attrib[attr].instance_divisor);
+         /* XXX we need to clamp the index here too, but to a
+          * per-array max value, not the draw->pt.max_index value
+          * that's being given to us via translate->set_buffer().
+          */
+      }
+      else {
+         index = elt;
+         /* clamp to avoid going out of bounds */
+         index = MIN2(index, tg->attrib[attr].max_index);
+      }
+
+      src = tg->attrib[attr].input_ptr +
+            (ptrdiff_t)tg->attrib[attr].input_stride * index;
+
+      copy_size = tg->attrib[attr].copy_size;
+      if (likely(copy_size >= 0)) {
+         memcpy(dst, src, copy_size);
+      } else {
+         tg->attrib[attr].fetch(data, src, 0, 0);
+
+         if (0)
+            debug_printf("Fetch linear attr %d  from %p  stride %d  index %d: "
+                      " %f, %f, %f, %f \n",
+                      attr,
+                      tg->attrib[attr].input_ptr,
+                      tg->attrib[attr].input_stride,
+                      index,
+                      data[0], data[1],data[2], data[3]);
+
+         tg->attrib[attr].emit(data, dst);
+      }
+   } else {
+      if (likely(tg->attrib[attr].copy_size >= 0)) {
+         memcpy(data, &instance_id, 4);
+      } else {
+         data[0] = (float)instance_id;
+         tg->attrib[attr].emit(data, dst);
+      }
+   }
+}
+
 static ALWAYS_INLINE void PIPE_CDECL
 generic_run_one(struct translate_generic *tg,
                 unsigned elt,
@@ -596,58 +666,8 @@ generic_run_one(struct translate_generic *tg,
    unsigned nr_attrs = tg->nr_attrib;
    unsigned attr;
 
-   for (attr = 0; attr < nr_attrs; attr++) {
-      float data[4];
-      uint8_t *dst = (uint8_t *)vert + tg->attrib[attr].output_offset;
-
-      if (tg->attrib[attr].type == TRANSLATE_ELEMENT_NORMAL) {
-         const uint8_t *src;
-         unsigned index;
-         int copy_size;
-
-         if (tg->attrib[attr].instance_divisor) {
-            index = start_instance;
-            index += (instance_id  / tg->attrib[attr].instance_divisor);
-            /* XXX we need to clamp the index here too, but to a
-             * per-array max value, not the draw->pt.max_index value
-             * that's being given to us via translate->set_buffer().
-             */
-         }
-         else {
-            index = elt;
-            /* clamp to avoid going out of bounds */
-            index = MIN2(index, tg->attrib[attr].max_index);
-         }
-
-         src = tg->attrib[attr].input_ptr +
-               (ptrdiff_t)tg->attrib[attr].input_stride * index;
-
-         copy_size = tg->attrib[attr].copy_size;
-         if (likely(copy_size >= 0)) {
-            memcpy(dst, src, copy_size);
-         } else {
-            tg->attrib[attr].fetch(data, src, 0, 0);
-
-            if (0)
-               debug_printf("Fetch linear attr %d  from %p  stride %d  index %d: "
-                         " %f, %f, %f, %f \n",
-                         attr,
-                         tg->attrib[attr].input_ptr,
-                         tg->attrib[attr].input_stride,
-                         index,
-                         data[0], data[1],data[2], data[3]);
-
-            tg->attrib[attr].emit(data, dst);
-         }
-      } else {
-         if (likely(tg->attrib[attr].copy_size >= 0)) {
-            memcpy(data, &instance_id, 4);
-         } else {
-            data[0] = (float)instance_id;
-            tg->attrib[attr].emit(data, dst);
-         }
-      }
-   }
+   for (attr = 0; attr < nr_attrs; attr++)
+      generic_run_attrib(tg, attr, elt, start_instance, instance_id, vert);
 }
 
 /**
@@ -707,6 +727,57 @@ generic_run_elts8(struct translate *translate,
    }
 }
 
+/**
+ * Fetch a vertex attribute for 'count' vertices using consecutive elements
+ * of the input array, where 'src_stride' is either its stride or zero.
+ */
+static void
+generic_run_batch(struct translate_generic *tg,
+                  unsigned attr,
+                  const uint8_t *src,
+                  unsigned src_stride,
+                  unsigned count,
+                  uint8_t *dst)
+{
+   const unsigned dst_stride = tg->translate.key.output_stride;
+   const int copy_size = tg->attrib[attr].copy_size;
+   float data[BATCH_SIZE][4];
+   unsigned i, j, n;
+
+   if (copy_size >= 0) {
+      for (i = 0; i < count; i++) {
+         memcpy(dst, src, copy_size);
+         src += src_stride;
+         dst += dst_stride;
+      }
+      return;
+   }
+
+   if (tg->attrib[attr].unpack_to_output) {
+      tg->attrib[attr].unpack(dst, dst_stride, src, src_stride, 1, count);
+      return;
+   }
+
+   for (i = 0; i < count; i += n) {
+      n = MIN2(count - i, BATCH_SIZE);
+
+      tg->attrib[attr].unpack(data, sizeof(data[0]), src, src_stride, 1, n);
+      for (j = 0; j < n; j++) {
+         tg->attrib[attr].emit(data[j], dst);
+         dst += dst_stride;
+      }
+
+      src += src_stride * n;
+   }
+}
+
+/**
+ * Fetch vertex attributes for 'count' consecutive vertices.
+ *
+ * Unlike the elts variants, this goes one attribute at a time, so that the
+ * input formats can be unpacked with their row functions rather than one
+ * call per vertex.
+ */
 static void PIPE_CDECL
 generic_run(struct translate *translate,
             unsigned start,
@@ -716,12 +787,44 @@ generic_run(struct translate *translate,
             void *output_buffer)
 {
    struct translate_generic *tg = translate_generic(translate);
-   char *vert = output_buffer;
-   unsigned i;
+   const unsigned stride = tg->translate.key.output_stride;
+   unsigned attr, i;
+
+   for (attr = 0; attr < tg->nr_attrib; attr++) {
+      const unsigned max_index = tg->attrib[attr].max_index;
+      char *vert = output_buffer;
+
+      if (tg->attrib[attr].type != TRANSLATE_ELEMENT_NORMAL ||
+          tg->attrib[attr].instance_divisor ||
+          !tg->attrib[attr].unpack) {
+         for (i = 0; i < count; i++) {
+            generic_run_attrib(tg, attr, start + i, start_instance,
+                               instance_id, vert);
+            vert += stride;
+         }
+         continue;
+      }
 
-   for (i = 0; i < count; i++) {
-      generic_run_one(tg, start + i, start_instance, instance_id, vert);
-      vert += tg->translate.key.output_stride;
+      i = 0;
+      while (i < count) {
+         /* Indices are clamped to max_index like in generic_run_attrib(),
+          * so all the vertices past it fetch the same element.
+          */
+         const unsigned index = MIN2(start + i, max_index);
+         const unsigned src_stride =
+            index == start + i ? tg->attrib[attr].input_stride : 0;
+         const unsigned n = src_stride ?
+            MIN2(count - i - 1, max_index - index) + 1 : count - i;
+
+         generic_run_batch(tg, attr,
+                           tg->attrib[attr].input_ptr +
+                           (ptrdiff_t)tg->attrib[attr].input_stride * index,
+                           src_stride, n,
+                           (uint8_t *)vert + tg->attrib[attr].output_offset);
+
+         vert += stride * n;
+         i += n;
+      }
    }
 }
 
@@ -799,6 +902,7 @@ translate_generic_create(const struct translate_key *key)
    for (i = 0; i < key->nr_elements; i++) {
       const struct util_format_description *format_desc =
             util_format_description(key->element[i].input_format);
+      enum pipe_format unpacked_format;
 
       assert(format_desc);
 
@@ -816,15 +920,31 @@ translate_generic_create(const struct translate_key *key)
          if (format_desc->channel[0].type == UTIL_FORMAT_TYPE_SIGNED) {
             assert(format_desc->fetch_rgba_sint);
             tg->attrib[i].fetch = (fetch_func)format_desc->fetch_rgba_sint;
+            tg->attrib[i].unpack = (unpack_func)format_desc->unpack_rgba_sint;
+            unpacked_format = PIPE_FORMAT_R32G32B32A32_SINT;
          } else {
             assert(format_desc->fetch_rgba_uint);
             tg->attrib[i].fetch = (fetch_func)format_desc->fetch_rgba_uint;
+            tg->attrib[i].unpack = (unpack_func)format_desc->unpack_rgba_uint;
+            unpacked_format = PIPE_FORMAT_R32G32B32A32_UINT;
          }
       } else {
          assert(format_desc->fetch_rgba_float);
          tg->attrib[i].fetch = (fetch_func)format_desc->fetch_rgba_float;
+         tg->attrib[i].unpack = (unpack_func)format_desc->unpack_rgba_float;
+         unpacked_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
       }
 
+      /* The unpack functions give the same results as the fetch ones for
+       * plain formats.  They step through the output in units of their
+       * channel type, hence the stride check.
+       */
+      if (format_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN)
+         tg->attrib[i].unpack = NULL;
+      tg->attrib[i].unpack_to_output =
+         key->element[i].output_format == unpacked_format &&
+         key->output_stride % 4 == 0;
+
       tg->attrib[i].buffer = key->element[i].input_buffer;
       tg->attrib[i].input_offset = key->element[i].input_offset;
       tg->attrib[i].instance_divisor = key->element[i].instance_divisor;
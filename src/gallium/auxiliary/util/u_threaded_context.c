@@ -30,6 +30,8 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_prim.h"
+#include "util/u_framebuffer.h"
 
 /* 0 = disabled, 1 = assertions, 2 = printfs */
 #define TC_DEBUG 0
@@ -79,6 +81,10 @@ tc_debug_check(struct threaded_context *tc)
    }
 }
 
+static struct tc_call *
+tc_execute_draws(struct threaded_context *tc, struct pipe_context *pipe,
+                 struct tc_call *first, struct tc_call *last);
+
 static void
 tc_batch_execute(void *job, UNUSED int thread_index)
 {
@@ -90,10 +96,16 @@ tc_batch_execute(void *job, UNUSED int thread_index)
 
    assert(!batch->token);
 
-   for (struct tc_call *iter = batch->call; iter != last;
-        iter += iter->num_call_slots) {
+   for (struct tc_call *iter = batch->call; iter != last;) {
       tc_assert(iter->sentinel == TC_SENTINEL);
+
+      if (iter->call_id == TC_CALL_draw_vbo) {
+         iter = tc_execute_draws(batch->tc, pipe, iter, last);
+         continue;
+      }
+
       execute_func[iter->call_id](pipe, &iter->payload);
+      iter += iter->num_call_slots;
    }
 
    tc_batch_check(batch);
@@ -538,10 +550,40 @@ TC_CSO_WHOLE2(gs, shader)
 TC_CSO_WHOLE2(tcs, shader)
 TC_CSO_WHOLE2(tes, shader)
 TC_CSO_CREATE(sampler, sampler)
-TC_CSO_DELETE(sampler)
 TC_CSO_BIND(vertex_elements)
 TC_CSO_DELETE(vertex_elements)
 
+static void
+tc_call_delete_sampler_state(struct pipe_context *pipe,
+                             union tc_payload *payload)
+{
+   pipe->delete_sampler_state(pipe, *(void**)payload);
+}
+
+static void
+tc_delete_sampler_state(struct pipe_context *_pipe, void *state)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   /* A new sampler state can be created at the same address, so the slots
+    * still holding this one can't be compared anymore.
+    */
+   for (unsigned sh = 0; sh < PIPE_SHADER_TYPES; sh++) {
+      uint32_t mask = tc->samplers_valid[sh];
+
+      while (mask) {
+         int i = u_bit_scan(&mask);
+
+         if (tc->samplers[sh][i] == state)
+            tc->samplers_valid[sh] &= ~BITFIELD_BIT(i);
+      }
+   }
+
+   void **p = (void**)tc_add_sized_call(tc, TC_CALL_delete_sampler_state,
+                                        sizeof(void*));
+   *p = state;
+}
+
 static void *
 tc_create_vertex_elements_state(struct pipe_context *_pipe, unsigned count,
                                 const struct pipe_vertex_element *elems)
@@ -572,6 +614,16 @@ tc_bind_sampler_states(struct pipe_context *_pipe,
       return;
 
    struct threaded_context *tc = threaded_context(_pipe);
+   uint32_t mask = BITFIELD_RANGE(start, count);
+
+   if ((tc->samplers_valid[shader] & mask) == mask &&
+       !memcmp(&tc->samplers[shader][start], states,
+               count * sizeof(states[0])))
+      return;
+
+   memcpy(&tc->samplers[shader][start], states, count * sizeof(states[0]));
+   tc->samplers_valid[shader] |= mask;
+
    struct tc_sampler_states *p =
       tc_add_slot_based_call(tc, TC_CALL_bind_sampler_states, tc_sampler_states, count);
 
@@ -604,6 +656,16 @@ tc_set_framebuffer_state(struct pipe_context *_pipe,
                          const struct pipe_framebuffer_state *fb)
 {
    struct threaded_context *tc = threaded_context(_pipe);
+
+   if (tc->fb_valid && util_framebuffer_state_equal(&tc->fb, fb))
+      return;
+
+   /* The shadow copy holds references, so that the surfaces can't be
+    * replaced by new ones at the same addresses.
+    */
+   util_copy_framebuffer_state(&tc->fb, fb);
+   tc->fb_valid = true;
+
    struct pipe_framebuffer_state *p =
       tc_add_struct_typed_call(tc, TC_CALL_set_framebuffer_state,
                                pipe_framebuffer_state);
@@ -666,9 +728,30 @@ tc_set_constant_buffer(struct pipe_context *_pipe,
                        const struct pipe_constant_buffer *cb)
 {
    struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_constant_buffer *bound = &tc->const_buffers[shader][index];
    struct pipe_resource *buffer = NULL;
    unsigned offset;
 
+   /* User buffers are uploaded every time, so only bindings of real buffers
+    * can be compared. The shadow copy holds a reference, so that the buffer
+    * can't be replaced by a new one at the same address.
+    */
+   if (cb && cb->user_buffer) {
+      tc->const_buffers_valid[shader] &= ~BITFIELD_BIT(index);
+      pipe_resource_reference(&bound->buffer, NULL);
+   } else {
+      if (tc->const_buffers_valid[shader] & BITFIELD_BIT(index) &&
+          bound->buffer == (cb ? cb->buffer : NULL) &&
+          bound->buffer_offset == (cb ? cb->buffer_offset : 0) &&
+          bound->buffer_size == (cb ? cb->buffer_size : 0))
+         return;
+
+      pipe_resource_reference(&bound->buffer, cb ? cb->buffer : NULL);
+      bound->buffer_offset = cb ? cb->buffer_offset : 0;
+      bound->buffer_size = cb ? cb->buffer_size : 0;
+      tc->const_buffers_valid[shader] |= BITFIELD_BIT(index);
+   }
+
    /* This must be done before adding set_constant_buffer, because it could
     * generate e.g. transfer_unmap and flush partially-uninitialized
     * set_constant_buffer to the driver if it was done afterwards.
@@ -719,6 +802,15 @@ tc_set_scissor_states(struct pipe_context *_pipe,
                       const struct pipe_scissor_state *states)
 {
    struct threaded_context *tc = threaded_context(_pipe);
+   uint32_t mask = BITFIELD_RANGE(start, count);
+
+   if ((tc->scissors_valid & mask) == mask &&
+       !memcmp(&tc->scissors[start], states, count * sizeof(states[0])))
+      return;
+
+   memcpy(&tc->scissors[start], states, count * sizeof(states[0]));
+   tc->scissors_valid |= mask;
+
    struct tc_scissors *p =
       tc_add_slot_based_call(tc, TC_CALL_set_scissor_states, tc_scissors, count);
 
@@ -748,6 +840,15 @@ tc_set_viewport_states(struct pipe_context *_pipe,
       return;
 
    struct threaded_context *tc = threaded_context(_pipe);
+   uint32_t mask = BITFIELD_RANGE(start, count);
+
+   if ((tc->viewports_valid & mask) == mask &&
+       !memcmp(&tc->viewports[start], states, count * sizeof(states[0])))
+      return;
+
+   memcpy(&tc->viewports[start], states, count * sizeof(states[0]));
+   tc->viewports_valid |= mask;
+
    struct tc_viewports *p =
       tc_add_slot_based_call(tc, TC_CALL_set_viewport_states, tc_viewports, count);
 
@@ -2069,6 +2170,97 @@ tc_call_draw_vbo(struct pipe_context *pipe, union tc_payload *payload)
    }
 }
 
+/* Whether more draws can be appended to this one by extending its index
+ * range. That only works for indexed lists made of whole primitives,
+ * because appending to a strip or fan would connect the draws. Non-indexed
+ * draws are excluded, because drivers derive the base vertex from "start".
+ */
+static bool
+tc_is_mergeable_draw(const struct pipe_draw_info *info)
+{
+   if (!info->index_size || info->primitive_restart || info->indirect ||
+       info->count_from_stream_output)
+      return false;
+
+   switch (info->mode) {
+   case PIPE_PRIM_POINTS:
+   case PIPE_PRIM_LINES:
+   case PIPE_PRIM_TRIANGLES:
+   case PIPE_PRIM_LINES_ADJACENCY:
+   case PIPE_PRIM_TRIANGLES_ADJACENCY:
+      return info->count % u_vertices_per_prim(info->mode) == 0;
+   case PIPE_PRIM_PATCHES:
+      return info->vertices_per_patch &&
+             info->count % info->vertices_per_patch == 0;
+   default:
+      return false;
+   }
+}
+
+/* Whether "next" continues "draw" in the same index buffer and differs from
+ * it only in the index range. No state can change in between, because the
+ * calls are consecutive.
+ */
+static bool
+tc_can_append_draw(const struct pipe_draw_info *draw,
+                   const struct pipe_draw_info *next)
+{
+   return !next->indirect &&
+          !next->count_from_stream_output &&
+          next->index.resource == draw->index.resource &&
+          next->start == draw->start + draw->count &&
+          next->index_size == draw->index_size &&
+          next->mode == draw->mode &&
+          next->primitive_restart == draw->primitive_restart &&
+          next->vertices_per_patch == draw->vertices_per_patch &&
+          next->index_bias == draw->index_bias &&
+          next->start_instance == draw->start_instance &&
+          next->instance_count == draw->instance_count &&
+          next->drawid == draw->drawid;
+}
+
+/* Execute the draw at "first" together with all consecutive draws that can
+ * be appended to it, and return the first call that wasn't executed.
+ * Nothing is merged unless the driver allows it for the bound state.
+ */
+static struct tc_call *
+tc_execute_draws(struct threaded_context *tc, struct pipe_context *pipe,
+                 struct tc_call *first, struct tc_call *last)
+{
+   struct pipe_draw_info *draw =
+      &((struct tc_full_draw_info*)&first->payload)->draw;
+   struct tc_call *iter = first + first->num_call_slots;
+   bool merge_allowed = false;
+
+   while (iter != last && iter->call_id == TC_CALL_draw_vbo &&
+          tc->can_merge_draws && tc_is_mergeable_draw(draw)) {
+      struct pipe_draw_info *next =
+         &((struct tc_full_draw_info*)&iter->payload)->draw;
+
+      tc_assert(iter->sentinel == TC_SENTINEL);
+      if (!tc_can_append_draw(draw, next))
+         break;
+
+      /* Only ask once there is something to merge. The bound state is the
+       * same for all consecutive draws.
+       */
+      if (!merge_allowed) {
+         if (!tc->can_merge_draws(pipe))
+            break;
+         merge_allowed = true;
+      }
+
+      draw->count += next->count;
+      draw->min_index = MIN2(draw->min_index, next->min_index);
+      draw->max_index = MAX2(draw->max_index, next->max_index);
+      pipe_resource_reference(&next->index.resource, NULL);
+      iter += iter->num_call_slots;
+   }
+
+   tc_call_draw_vbo(pipe, &first->payload);
+   return iter;
+}
+
 static struct tc_full_draw_info *
 tc_add_draw_vbo(struct pipe_context *_pipe, bool indirect)
 {
@@ -2536,6 +2728,13 @@ tc_destroy(struct pipe_context *_pipe)
 
    slab_destroy_child(&tc->pool_transfers);
    assert(tc->batch_slots[tc->next].num_total_call_slots == 0);
+
+   util_unreference_framebuffer_state(&tc->fb);
+   for (unsigned sh = 0; sh < PIPE_SHADER_TYPES; sh++) {
+      for (unsigned i = 0; i < PIPE_MAX_CONSTANT_BUFFERS; i++)
+         pipe_resource_reference(&tc->const_buffers[sh][i].buffer, NULL);
+   }
+
    pipe->destroy(pipe);
    os_free_aligned(tc);
 }
@@ -2555,6 +2754,8 @@ static const tc_execute execute_func[TC_NUM_CALLS] = {
  *                             in pipe_screen.
  * \param replace_buffer  callback for replacing a pipe_resource's storage
  *                        with another pipe_resource's storage.
+ * \param can_merge_draws  callback allowing consecutive indexed draws to be
+ *                         merged, or NULL to never merge them.
  * \param out  if successful, the threaded_context will be returned here in
  *             addition to the return value if "out" != NULL
  */
@@ -2563,6 +2764,7 @@ threaded_context_create(struct pipe_context *pipe,
                         struct slab_parent_pool *parent_transfer_pool,
                         tc_replace_buffer_storage_func replace_buffer,
                         tc_create_fence_func create_fence,
+                        tc_can_merge_draws_func can_merge_draws,
                         struct threaded_context **out)
 {
    struct threaded_context *tc;
@@ -2598,6 +2800,7 @@ threaded_context_create(struct pipe_context *pipe,
    tc->pipe = pipe;
    tc->replace_buffer_storage = replace_buffer;
    tc->create_fence = create_fence;
+   tc->can_merge_draws = can_merge_draws;
    tc->map_buffer_alignment =
       pipe->screen->get_param(pipe->screen, PIPE_CAP_MIN_MAP_BUFFER_ALIGNMENT);
    tc->base.priv = pipe; /* priv points to the wrapped driver context */
@@ -2624,6 +2827,7 @@ threaded_context_create(struct pipe_context *pipe,
    for (unsigned i = 0; i < TC_MAX_BATCHES; i++) {
       tc->batch_slots[i].sentinel = TC_SENTINEL;
       tc->batch_slots[i].pipe = pipe;
+      tc->batch_slots[i].tc = tc;
       util_queue_fence_init(&tc->batch_slots[i].fence);
    }
 
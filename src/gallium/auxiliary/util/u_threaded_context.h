@@ -237,6 +237,12 @@ typedef void (*tc_replace_buffer_storage_func)(struct pipe_context *ctx,
                                                struct pipe_resource *src);
 typedef struct pipe_fence_handle *(*tc_create_fence_func)(struct pipe_context *ctx,
                                                           struct tc_unflushed_batch_token *token);
+/* Return whether consecutive indexed draws may be merged into one with the
+ * currently bound state. Merging renumbers the primitives of all but the
+ * first draw, so this must return false while a bound shader reads
+ * PrimitiveID. Called by the driver thread before draw_vbo.
+ */
+typedef bool (*tc_can_merge_draws_func)(struct pipe_context *ctx);
 
 struct threaded_resource {
    struct pipe_resource b;
@@ -339,6 +345,7 @@ struct tc_unflushed_batch_token {
 
 struct tc_batch {
    struct pipe_context *pipe;
+   struct threaded_context *tc;
    unsigned sentinel;
    unsigned num_total_call_slots;
    struct tc_unflushed_batch_token *token;
@@ -352,6 +359,7 @@ struct threaded_context {
    struct slab_child_pool pool_transfers;
    tc_replace_buffer_storage_func replace_buffer_storage;
    tc_create_fence_func create_fence;
+   tc_can_merge_draws_func can_merge_draws;
    unsigned map_buffer_alignment;
 
    struct list_head unflushed_queries;
@@ -361,6 +369,22 @@ struct threaded_context {
    unsigned num_direct_slots;
    unsigned num_syncs;
 
+   /* Shadow copies of the bound state, used to drop calls that wouldn't
+    * change anything. Nothing is assumed about the initial state of the
+    * driver, so a state is only valid after it has been set through the
+    * threaded context.
+    */
+   struct pipe_framebuffer_state fb;
+   bool fb_valid;
+   void *samplers[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
+   uint32_t samplers_valid[PIPE_SHADER_TYPES];
+   struct pipe_constant_buffer const_buffers[PIPE_SHADER_TYPES][PIPE_MAX_CONSTANT_BUFFERS];
+   uint32_t const_buffers_valid[PIPE_SHADER_TYPES];
+   struct pipe_viewport_state viewports[PIPE_MAX_VIEWPORTS];
+   uint32_t viewports_valid;
+   struct pipe_scissor_state scissors[PIPE_MAX_VIEWPORTS];
+   uint32_t scissors_valid;
+
    struct util_queue queue;
    struct util_queue_fence *fence;
 
@@ -377,6 +401,7 @@ threaded_context_create(struct pipe_context *pipe,
                         struct slab_parent_pool *parent_transfer_pool,
                         tc_replace_buffer_storage_func replace_buffer,
                         tc_create_fence_func create_fence,
+                        tc_can_merge_draws_func can_merge_draws,
                         struct threaded_context **out);
 
 void
@@ -37,6 +37,9 @@
 
 #include "u_upload_mgr.h"
 
+/* The number of full upload buffers kept for reuse in ring mode. */
+#define U_UPLOAD_RING_SIZE 4
+
 
 struct u_upload_mgr {
    struct pipe_context *pipe;
@@ -47,6 +50,7 @@ struct u_upload_mgr {
    unsigned flags;
    unsigned map_flags;     /* Bitmask of PIPE_TRANSFER_* flags. */
    boolean map_persistent; /* If persistent mappings are supported. */
+   boolean ring;           /* If full buffers are kept for reuse. */
 
    struct pipe_resource *buffer;   /* Upload buffer. */
    struct pipe_transfer *transfer; /* Transfer object for the upload buffer. */
@@ -54,6 +58,10 @@ struct u_upload_mgr {
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
    unsigned flushed_size; /* Size we have flushed by transfer_flush_region. */
+
+   /* Full buffers waiting to be reused in ring mode, oldest first. */
+   struct pipe_resource *ring_buffers[U_UPLOAD_RING_SIZE];
+   unsigned num_ring_buffers;
 };
 
 
@@ -131,6 +139,12 @@ u_upload_disable_persistent(struct u_upload_mgr *upload)
    upload->map_flags |= PIPE_TRANSFER_FLUSH_EXPLICIT;
 }
 
+void
+u_upload_enable_ring(struct u_upload_mgr *upload)
+{
+   upload->ring = TRUE;
+}
+
 static void
 upload_unmap_internal(struct u_upload_mgr *upload, boolean destroying)
 {
@@ -178,10 +192,89 @@ void
 u_upload_destroy(struct u_upload_mgr *upload)
 {
    u_upload_release_buffer(upload);
+
+   for (unsigned i = 0; i < upload->num_ring_buffers; i++)
+      pipe_resource_reference(&upload->ring_buffers[i], NULL);
+
    FREE(upload);
 }
 
 
+static unsigned
+u_upload_ring_buffer_size(struct u_upload_mgr *upload)
+{
+   return align(upload->default_size, 4096);
+}
+
+
+/* Unmap the full upload buffer and keep it for reuse, or release it if it
+ * doesn't have the default size.
+ */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   if (!upload->ring || !upload->buffer ||
+       upload->buffer->width0 != u_upload_ring_buffer_size(upload)) {
+      u_upload_release_buffer(upload);
+      return;
+   }
+
+   upload_unmap_internal(upload, TRUE);
+
+   if (upload->num_ring_buffers == U_UPLOAD_RING_SIZE) {
+      pipe_resource_reference(&upload->ring_buffers[0], NULL);
+      memmove(upload->ring_buffers, upload->ring_buffers + 1,
+              (U_UPLOAD_RING_SIZE - 1) * sizeof(upload->ring_buffers[0]));
+      upload->num_ring_buffers--;
+   }
+
+   /* The reference moves to the ring. */
+   upload->ring_buffers[upload->num_ring_buffers++] = upload->buffer;
+   upload->buffer = NULL;
+}
+
+
+/* Make an idle buffer from the ring the upload buffer again.
+ *
+ * A buffer is idle when nothing else references it, i.e. no bound state
+ * can still use the data in it, and the driver can map it without
+ * waiting, i.e. the fences of all submitted work using it have signalled.
+ */
+static boolean
+u_upload_reuse_buffer(struct u_upload_mgr *upload)
+{
+   for (unsigned i = 0; i < upload->num_ring_buffers; i++) {
+      struct pipe_resource *buffer = upload->ring_buffers[i];
+      struct pipe_transfer *transfer;
+      uint8_t *map;
+
+      if (p_atomic_read(&buffer->reference.count) != 1)
+         continue;
+
+      map = pipe_buffer_map_range(upload->pipe, buffer, 0, buffer->width0,
+                                  (upload->map_flags &
+                                   ~PIPE_TRANSFER_UNSYNCHRONIZED) |
+                                  PIPE_TRANSFER_DONTBLOCK,
+                                  &transfer);
+      if (!map)
+         continue;
+
+      upload->buffer = buffer;
+      upload->transfer = transfer;
+      upload->map = map;
+      upload->offset = 0;
+
+      upload->num_ring_buffers--;
+      memmove(upload->ring_buffers + i, upload->ring_buffers + i + 1,
+              (upload->num_ring_buffers - i) *
+              sizeof(upload->ring_buffers[0]));
+      return TRUE;
+   }
+
+   return FALSE;
+}
+
+
 static void
 u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
 {
@@ -189,14 +282,18 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   /* Release or retire the old buffer, if present:
     */
-   u_upload_release_buffer(upload);
+   u_upload_retire_buffer(upload);
 
-   /* Allocate a new one:
+   /* Reuse an idle one or allocate a new one:
     */
    size = align(MAX2(upload->default_size, min_size), 4096);
 
+   if (upload->ring && size == u_upload_ring_buffer_size(upload) &&
+       u_upload_reuse_buffer(upload))
+      return;
+
    memset(&buffer, 0, sizeof buffer);
    buffer.target = PIPE_BUFFER;
    buffer.format = PIPE_FORMAT_R8_UNORM; /* want TYPELESS or similar */
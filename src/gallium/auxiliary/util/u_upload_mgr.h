@@ -77,6 +77,17 @@ u_upload_enable_flush_explicit(struct u_upload_mgr *upload);
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload);
 
+/**
+ * Keep full upload buffers of the default size in a small ring and reuse
+ * them once they are idle, instead of allocating a new buffer every time.
+ *
+ * Idleness is tested by mapping with PIPE_TRANSFER_DONTBLOCK, so this
+ * should only be enabled for drivers where that is cheap, and is not
+ * inherited by u_upload_clone.
+ */
+void
+u_upload_enable_ring(struct u_upload_mgr *upload);
+
 /**
  * Destroy the upload manager.
  */
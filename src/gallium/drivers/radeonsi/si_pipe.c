@@ -753,6 +753,7 @@ static struct pipe_context *si_pipe_create_context(struct pipe_screen *screen,
 	return threaded_context_create(ctx, &sscreen->pool_transfers,
 				       si_replace_buffer_storage,
 				       sscreen->info.is_amdgpu ? si_create_fence : NULL,
+				       si_can_merge_draws,
 				       &((struct si_context*)ctx)->tc);
 }
 
@@ -630,6 +630,7 @@ void si_prim_discard_signal_next_compute_ib_start(struct si_context *sctx);
 void gfx10_emit_cache_flush(struct si_context *sctx);
 void si_emit_cache_flush(struct si_context *sctx);
 void si_trace_emit(struct si_context *sctx);
+bool si_can_merge_draws(struct pipe_context *ctx);
 void si_init_draw_functions(struct si_context *sctx);
 
 /* si_state_msaa.c */
@@ -2309,6 +2309,27 @@ void si_trace_emit(struct si_context *sctx)
 		u_log_flush(sctx->log);
 }
 
+/* Merged draws number their primitives continuously, so the threaded
+ * context may only merge them if no bound shader reads PrimitiveID.
+ */
+bool si_can_merge_draws(struct pipe_context *ctx)
+{
+	struct si_context *sctx = (struct si_context *)ctx;
+	struct si_shader_selector *shaders[] = {
+		sctx->vs_shader.cso,
+		sctx->tcs_shader.cso,
+		sctx->tes_shader.cso,
+		sctx->gs_shader.cso,
+		sctx->ps_shader.cso,
+	};
+
+	for (unsigned i = 0; i < ARRAY_SIZE(shaders); i++) {
+		if (shaders[i] && shaders[i]->info.uses_primid)
+			return false;
+	}
+	return true;
+}
+
 void si_init_draw_functions(struct si_context *sctx)
 {
 	sctx->b.draw_vbo = si_draw_vbo;
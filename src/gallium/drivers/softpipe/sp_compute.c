@@ -20,14 +20,17 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
  * USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_pstipple.h"
+#include "util/u_queue.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
 #include "sp_context.h"
+#include "sp_quad_bin.h"
 #include "sp_screen.h"
 #include "sp_state.h"
 #include "sp_texture.h"
@@ -35,6 +38,44 @@
 #include "sp_tex_tile_cache.h"
 #include "tgsi/tgsi_parse.h"
 
+
+/** State of a grid launch, shared by all the threads running it */
+struct sp_grid_launch
+{
+   struct softpipe_context *softpipe;
+   const struct sp_compute_shader *cs;
+   uint32_t grid_size[3];
+   int bwidth, bheight, bdepth;
+
+   unsigned num_groups;
+   unsigned next_group;   /**< next workgroup to be picked by a thread */
+};
+
+
+struct sp_compute_worker
+{
+   struct sp_compute_pool *pool;
+
+   struct sp_tgsi_sampler sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   struct util_queue_fence fence;
+};
+
+
+struct sp_compute_pool
+{
+   struct softpipe_context *softpipe;
+
+   /** The launch being run, NULL when idle */
+   struct sp_grid_launch *launch;
+
+   unsigned num_workers;
+   struct sp_compute_worker *workers[SP_MAX_THREADS - 1];
+
+   struct util_queue queue;
+};
+
 static void
 cs_prepare(const struct sp_compute_shader *cs,
            struct tgsi_exec_machine *machine,
@@ -164,28 +205,26 @@ fill_grid_size(struct pipe_context *context,
    pipe_buffer_unmap(context, transfer);
 }
 
-void
-softpipe_launch_grid(struct pipe_context *context,
-                     const struct pipe_grid_info *info)
+/**
+ * Run workgroups of a launch until there are none left.  Each call runs
+ * the groups it picks with its own machines and local memory, so barriers
+ * only involve the machines of the group, as in the single-threaded case.
+ */
+static void
+run_workgroups(struct sp_grid_launch *launch,
+               struct tgsi_sampler *sampler)
 {
-   struct softpipe_context *softpipe = softpipe_context(context);
-   struct sp_compute_shader *cs = softpipe->cs;
-   int num_threads_in_group;
+   struct softpipe_context *softpipe = launch->softpipe;
+   const struct sp_compute_shader *cs = launch->cs;
+   const int bwidth = launch->bwidth;
+   const int bheight = launch->bheight;
+   const int bdepth = launch->bdepth;
+   const int num_threads_in_group = bwidth * bheight * bdepth;
    struct tgsi_exec_machine **machines;
-   int bwidth, bheight, bdepth;
    int w, h, d, i;
-   int g_w, g_h, g_d;
-   uint32_t grid_size[3] = {0};
+   unsigned group;
    void *local_mem = NULL;
 
-   softpipe_update_compute_samplers(softpipe);
-   bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
-   bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
-   bdepth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH];
-   num_threads_in_group = bwidth * bheight * bdepth;
-
-   fill_grid_size(context, info, grid_size);
-
    if (cs->shader.req_local_mem) {
       local_mem = CALLOC(1, cs->shader.req_local_mem);
    }
@@ -207,9 +246,10 @@ softpipe_launch_grid(struct pipe_context *context,
             machines[idx]->LocalMemSize = cs->shader.req_local_mem;
             cs_prepare(cs, machines[idx],
                        w, h, d,
-                       grid_size[0], grid_size[1], grid_size[2],
+                       launch->grid_size[0], launch->grid_size[1],
+                       launch->grid_size[2],
                        bwidth, bheight, bdepth,
-                       (struct tgsi_sampler *)softpipe->tgsi.sampler[PIPE_SHADER_COMPUTE],
+                       sampler,
                        (struct tgsi_image *)softpipe->tgsi.image[PIPE_SHADER_COMPUTE],
                        (struct tgsi_buffer *)softpipe->tgsi.buffer[PIPE_SHADER_COMPUTE]);
             tgsi_exec_set_constant_buffers(machines[idx], PIPE_MAX_CONSTANT_BUFFERS,
@@ -219,12 +259,14 @@ softpipe_launch_grid(struct pipe_context *context,
       }
    }
 
-   for (g_d = 0; g_d < grid_size[2]; g_d++) {
-      for (g_h = 0; g_h < grid_size[1]; g_h++) {
-         for (g_w = 0; g_w < grid_size[0]; g_w++) {
-            run_workgroup(cs, g_w, g_h, g_d, num_threads_in_group, machines);
-         }
-      }
+   /* Groups are numbered in the order the single-threaded loop ran them */
+   while ((group = p_atomic_inc_return(&launch->next_group) - 1) <
+          launch->num_groups) {
+      const unsigned g_w = group % launch->grid_size[0];
+      const unsigned g_h = group / launch->grid_size[0] % launch->grid_size[1];
+      const unsigned g_d = group / launch->grid_size[0] / launch->grid_size[1];
+
+      run_workgroup(cs, g_w, g_h, g_d, num_threads_in_group, machines);
    }
 
    for (i = 0; i < num_threads_in_group; i++) {
@@ -235,3 +277,166 @@ softpipe_launch_grid(struct pipe_context *context,
    FREE(local_mem);
    FREE(machines);
 }
+
+
+static void
+worker_execute(void *job, int thread_index)
+{
+   struct sp_compute_worker *w = job;
+
+   run_workgroups(w->pool->launch, (struct tgsi_sampler *)&w->sampler);
+}
+
+
+static void
+destroy_worker(struct sp_compute_worker *w)
+{
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(w->tex_cache); i++)
+      sp_destroy_tex_tile_cache(w->tex_cache[i]);
+
+   util_queue_fence_destroy(&w->fence);
+   FREE(w);
+}
+
+
+/**
+ * Create the threads that run workgroups along with the calling thread.
+ */
+struct sp_compute_pool *
+softpipe_create_compute_pool(struct softpipe_context *softpipe,
+                             unsigned num_threads)
+{
+   struct sp_compute_pool *pool = CALLOC_STRUCT(sp_compute_pool);
+   unsigned i;
+
+   if (!pool)
+      return NULL;
+
+   pool->softpipe = softpipe;
+
+   num_threads = MIN2(num_threads, SP_MAX_THREADS);
+
+   if (!util_queue_init(&pool->queue, "softpipe_cs", num_threads - 1,
+                        num_threads - 1, 0)) {
+      FREE(pool);
+      return NULL;
+   }
+
+   for (i = 0; i < num_threads - 1; i++) {
+      struct sp_compute_worker *w = CALLOC_STRUCT(sp_compute_worker);
+
+      if (!w) {
+         softpipe_destroy_compute_pool(pool);
+         return NULL;
+      }
+
+      w->pool = pool;
+      util_queue_fence_init(&w->fence);
+      pool->workers[pool->num_workers++] = w;
+   }
+
+   return pool;
+}
+
+
+void
+softpipe_destroy_compute_pool(struct sp_compute_pool *pool)
+{
+   unsigned i;
+
+   util_queue_destroy(&pool->queue);
+
+   for (i = 0; i < pool->num_workers; i++)
+      destroy_worker(pool->workers[i]);
+
+   FREE(pool);
+}
+
+
+/**
+ * Called along with sp_flush_tex_tile_cache() for the context's caches.
+ */
+void
+softpipe_compute_pool_flush_tex_caches(struct sp_compute_pool *pool)
+{
+   unsigned i, j;
+
+   for (i = 0; i < pool->num_workers; i++) {
+      for (j = 0; j < ARRAY_SIZE(pool->workers[i]->tex_cache); j++) {
+         if (pool->workers[i]->tex_cache[j])
+            sp_flush_tex_tile_cache(pool->workers[i]->tex_cache[j]);
+      }
+   }
+}
+
+
+/**
+ * Whether the workgroups of the current compute shader may run on several
+ * threads.  The buffer and image atomics are plain read-modify-writes, so
+ * shaders using them stay on the calling thread.
+ */
+static boolean
+can_run_threaded(const struct softpipe_context *softpipe,
+                 const struct sp_grid_launch *launch)
+{
+   const struct sp_compute_shader *cs = launch->cs;
+
+   return softpipe->compute_pool &&
+          launch->num_groups > 1 &&
+          !cs->info.shader_buffers_atomic &&
+          !cs->info.images_atomic;
+}
+
+
+void
+softpipe_launch_grid(struct pipe_context *context,
+                     const struct pipe_grid_info *info)
+{
+   struct softpipe_context *softpipe = softpipe_context(context);
+   struct sp_compute_pool *pool = softpipe->compute_pool;
+   struct sp_compute_shader *cs = softpipe->cs;
+   struct sp_grid_launch launch = {0};
+   unsigned num_workers = 0;
+   unsigned i;
+
+   softpipe_update_compute_samplers(softpipe);
+
+   launch.softpipe = softpipe;
+   launch.cs = cs;
+   launch.bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
+   launch.bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
+   launch.bdepth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH];
+
+   fill_grid_size(context, info, launch.grid_size);
+   launch.num_groups = launch.grid_size[0] * launch.grid_size[1] *
+                       launch.grid_size[2];
+
+   if (can_run_threaded(softpipe, &launch)) {
+      /* No point in waking up more threads than there are groups */
+      num_workers = MIN2(pool->num_workers, launch.num_groups - 1);
+      pool->launch = &launch;
+
+      for (i = 0; i < num_workers; i++) {
+         struct sp_compute_worker *w = pool->workers[i];
+
+         if (!softpipe_copy_tgsi_sampler(softpipe, PIPE_SHADER_COMPUTE,
+                                         &w->sampler, w->tex_cache))
+            break;
+
+         util_queue_add_job(&pool->queue, w, &w->fence,
+                            worker_execute, NULL, 0);
+      }
+      num_workers = i;
+   }
+
+   run_workgroups(&launch,
+                  (struct tgsi_sampler *)softpipe->tgsi.sampler[PIPE_SHADER_COMPUTE]);
+
+   for (i = 0; i < num_workers; i++)
+      util_queue_fence_wait(&pool->workers[i]->fence);
+
+   if (pool)
+      pool->launch = NULL;
+}
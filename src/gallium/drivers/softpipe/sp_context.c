@@ -48,6 +48,7 @@
 #include "sp_surface.h"
 #include "sp_tile_cache.h"
 #include "sp_tex_tile_cache.h"
+#include "sp_quad_bin.h"
 #include "sp_texture.h"
 #include "sp_query.h"
 #include "sp_screen.h"
@@ -78,6 +79,12 @@ softpipe_destroy( struct pipe_context *pipe )
    if (softpipe->quad.shade)
       softpipe->quad.shade->destroy( softpipe->quad.shade );
 
+   if (softpipe->quad_bins)
+      sp_destroy_quad_bins(softpipe->quad_bins);
+
+   if (softpipe->compute_pool)
+      softpipe_destroy_compute_pool(softpipe->compute_pool);
+
    if (softpipe->quad.depth_test)
       softpipe->quad.depth_test->destroy( softpipe->quad.depth_test );
 
@@ -199,6 +206,7 @@ softpipe_create_context(struct pipe_screen *screen,
    struct softpipe_screen *sp_screen = softpipe_screen(screen);
    struct softpipe_context *softpipe = CALLOC_STRUCT(softpipe_context);
    uint i, sh;
+   long num_threads;
 
    util_init_math();
 
@@ -271,9 +279,18 @@ softpipe_create_context(struct pipe_screen *screen,
    softpipe->quad.blend = sp_quad_blend_stage(softpipe);
    softpipe->quad.pstipple = sp_quad_polygon_stipple_stage(softpipe);
 
+   /* Optionally run the quad stages on several threads */
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", 0);
+   if (num_threads > 1) {
+      softpipe->quad_bins = sp_create_quad_bins(softpipe, num_threads);
+      softpipe->compute_pool =
+         softpipe_create_compute_pool(softpipe, num_threads);
+   }
+
    softpipe->pipe.stream_uploader = u_upload_create_default(&softpipe->pipe);
    if (!softpipe->pipe.stream_uploader)
       goto fail;
+   u_upload_enable_ring(softpipe->pipe.stream_uploader);
    softpipe->pipe.const_uploader = softpipe->pipe.stream_uploader;
 
    /*
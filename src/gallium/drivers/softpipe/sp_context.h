@@ -56,6 +56,8 @@ struct sp_fragment_shader;
 struct sp_vertex_shader;
 struct sp_velems_state;
 struct sp_so_state;
+struct sp_quad_bins;
+struct sp_compute_pool;
 
 struct softpipe_context {
    struct pipe_context pipe;  /**< base class */
@@ -205,6 +207,12 @@ struct softpipe_context {
     */
    struct softpipe_tex_tile_cache *tex_cache[PIPE_SHADER_TYPES][PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
+   /** Quad bins for the worker threads, NULL when running single-threaded */
+   struct sp_quad_bins *quad_bins;
+
+   /** Worker threads running compute workgroups, NULL when single-threaded */
+   struct sp_compute_pool *compute_pool;
+
    unsigned dump_fs : 1;
    unsigned dump_gs : 1;
    unsigned dump_cs : 1;
@@ -38,6 +38,7 @@
 #include "sp_state.h"
 #include "sp_tile_cache.h"
 #include "sp_tex_tile_cache.h"
+#include "sp_quad_bin.h"
 #include "util/u_debug_image.h"
 #include "util/u_memory.h"
 #include "util/u_string.h"
@@ -61,6 +62,11 @@ softpipe_flush( struct pipe_context *pipe,
             sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
          }
       }
+
+      if (softpipe->quad_bins)
+         sp_quad_bins_flush_tex_caches(softpipe->quad_bins);
+      if (softpipe->compute_pool)
+         softpipe_compute_pool_flush_tex_caches(softpipe->compute_pool);
    }
 
    /* If this is a swapbuffers, just flush color buffers.
@@ -180,6 +186,11 @@ void softpipe_texture_barrier(struct pipe_context *pipe, unsigned flags)
       }
    }
 
+   if (softpipe->quad_bins)
+      sp_quad_bins_flush_tex_caches(softpipe->quad_bins);
+   if (softpipe->compute_pool)
+      softpipe_compute_pool_flush_tex_caches(softpipe->compute_pool);
+
    for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++)
       if (softpipe->cbuf_cache[i])
          sp_flush_tile_cache(softpipe->cbuf_cache[i]);
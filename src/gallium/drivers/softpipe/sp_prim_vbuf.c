@@ -37,6 +37,7 @@
 
 
 #include "sp_context.h"
+#include "sp_quad_bin.h"
 #include "sp_setup.h"
 #include "sp_state.h"
 #include "sp_prim_vbuf.h"
@@ -345,6 +346,10 @@ sp_vbuf_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
    default:
       assert(0);
    }
+
+   /* Run the binned quads before the state can change */
+   if (softpipe->quad_bins)
+      sp_quad_bins_flush(softpipe->quad_bins);
 }
 
 
@@ -585,6 +590,10 @@ sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
    default:
       assert(0);
    }
+
+   /* Run the binned quads before the state can change */
+   if (softpipe->quad_bins)
+      sp_quad_bins_flush(softpipe->quad_bins);
 }
 
 /*
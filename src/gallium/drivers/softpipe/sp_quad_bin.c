@@ -0,0 +1,576 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Multi-threaded quad pipeline.
+ *
+ * Instead of running the quad pipeline right away, triangle setup puts the
+ * quad batches it generates into bins.  There is one bin per position of
+ * the color/depth tile caches, which are direct mapped, so all the quads
+ * touching a given cache entry end up in the same bin, in the order they
+ * were generated.  Each bin is then run by a single worker, which replays
+ * exactly the same sequence of tile cache hits, misses and write-backs as
+ * the single-threaded code, so the results are identical.
+ *
+ * Every worker has its own copy of the context state, fragment shader
+ * machine, quad stages and texture tile caches, and a fork of the color and
+ * depth tile caches which is merged back once all bins have been run.
+ *
+ * Bins are run at the end of every vbuf draw, which is before draw_flush()
+ * returns, so the state they were binned with is still current.
+ */
+
+
+#include "util/u_atomic.h"
+#include "util/u_dynarray.h"
+#include "util/u_memory.h"
+#include "util/u_queue.h"
+#include "tgsi/tgsi_exec.h"
+#include "sp_context.h"
+#include "sp_quad.h"
+#include "sp_quad_bin.h"
+#include "sp_quad_pipe.h"
+#include "sp_state.h"
+#include "sp_texture.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_tile_cache.h"
+
+
+/** Bins are flushed early once they hold that much data */
+#define SP_QUAD_BINS_MAX_SIZE (8 * 1024 * 1024)
+
+/** Max number of quads in a batch, see MAX_QUADS in sp_setup.c */
+#define SP_QUAD_BINS_MAX_QUADS 16
+
+
+/** Header of a batch of quads in a bin, followed by the quads */
+struct sp_binned_batch
+{
+   unsigned coefs;   /**< index of the posCoef in sp_quad_bins::coefs */
+   unsigned nr;
+};
+
+
+struct sp_binned_quad
+{
+   struct quad_header_input input;
+   struct quad_header_inout inout;
+};
+
+
+struct sp_quad_worker
+{
+   struct sp_quad_bins *bins;
+
+   /** Copy of the context state the quad stages of this worker run with */
+   struct softpipe_context sp;
+
+   struct tgsi_exec_machine *fs_machine;
+   struct quad_stage *shade;
+   struct quad_stage *depth_test;
+   struct quad_stage *blend;
+
+   struct sp_tgsi_sampler sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   struct softpipe_tile_cache cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache zsbuf_cache;
+
+   struct quad_header quad[SP_QUAD_BINS_MAX_QUADS];
+   struct quad_header *quad_ptrs[SP_QUAD_BINS_MAX_QUADS];
+
+   /** Bins run by this worker during the last flush */
+   unsigned num_slots;
+   unsigned slots[NUM_ENTRIES];
+
+   struct util_queue_fence fence;
+};
+
+
+struct sp_quad_bins
+{
+   struct softpipe_context *softpipe;
+
+   /** Interpolation coefficients of the binned primitives */
+   struct util_dynarray coefs;
+   /** Index of the current primitive's coefficients, or -1 */
+   int prim_coefs;
+
+   struct util_dynarray bin[NUM_ENTRIES];
+   unsigned num_used;
+   unsigned used[NUM_ENTRIES];   /**< non-empty bins, in first use order */
+   unsigned size;                /**< total bytes in bins and coefs */
+
+   unsigned next_used;   /**< next entry of used[] to be picked by a worker */
+
+   unsigned num_workers;
+   struct sp_quad_worker *workers[SP_MAX_THREADS];
+
+   struct util_queue queue;
+};
+
+
+static void
+destroy_worker(struct sp_quad_worker *w)
+{
+   unsigned i;
+
+   if (w->shade)
+      w->shade->destroy(w->shade);
+   if (w->depth_test)
+      w->depth_test->destroy(w->depth_test);
+   if (w->blend)
+      w->blend->destroy(w->blend);
+
+   for (i = 0; i < ARRAY_SIZE(w->tex_cache); i++)
+      sp_destroy_tex_tile_cache(w->tex_cache[i]);
+
+   if (w->fs_machine)
+      tgsi_exec_machine_destroy(w->fs_machine);
+
+   util_queue_fence_destroy(&w->fence);
+   FREE(w);
+}
+
+
+static struct sp_quad_worker *
+create_worker(struct sp_quad_bins *bins)
+{
+   struct sp_quad_worker *w = CALLOC_STRUCT(sp_quad_worker);
+
+   if (!w)
+      return NULL;
+
+   w->bins = bins;
+   util_queue_fence_init(&w->fence);
+
+   /* The stages keep a pointer to the worker's copy of the context */
+   w->fs_machine = tgsi_exec_machine_create(PIPE_SHADER_FRAGMENT);
+   w->shade = sp_quad_shade_stage(&w->sp);
+   w->depth_test = sp_quad_depth_test_stage(&w->sp);
+   w->blend = sp_quad_blend_stage(&w->sp);
+
+   if (!w->fs_machine || !w->shade || !w->depth_test || !w->blend) {
+      destroy_worker(w);
+      return NULL;
+   }
+
+   return w;
+}
+
+
+struct sp_quad_bins *
+sp_create_quad_bins(struct softpipe_context *softpipe, unsigned num_threads)
+{
+   struct sp_quad_bins *bins = CALLOC_STRUCT(sp_quad_bins);
+   unsigned i;
+
+   if (!bins)
+      return NULL;
+
+   bins->softpipe = softpipe;
+   bins->prim_coefs = -1;
+   util_dynarray_init(&bins->coefs, NULL);
+   for (i = 0; i < NUM_ENTRIES; i++)
+      util_dynarray_init(&bins->bin[i], NULL);
+
+   num_threads = MIN2(num_threads, SP_MAX_THREADS);
+
+   /* The calling thread runs the first worker itself */
+   if (!util_queue_init(&bins->queue, "softpipe", num_threads - 1,
+                        num_threads - 1, 0)) {
+      FREE(bins);
+      return NULL;
+   }
+
+   for (i = 0; i < num_threads; i++) {
+      bins->workers[i] = create_worker(bins);
+      if (!bins->workers[i]) {
+         sp_destroy_quad_bins(bins);
+         return NULL;
+      }
+      bins->num_workers++;
+   }
+
+   return bins;
+}
+
+
+void
+sp_destroy_quad_bins(struct sp_quad_bins *bins)
+{
+   unsigned i;
+
+   util_queue_destroy(&bins->queue);
+
+   for (i = 0; i < bins->num_workers; i++)
+      destroy_worker(bins->workers[i]);
+
+   util_dynarray_fini(&bins->coefs);
+   for (i = 0; i < NUM_ENTRIES; i++)
+      util_dynarray_fini(&bins->bin[i]);
+
+   FREE(bins);
+}
+
+
+/**
+ * Can the quads of the current state be binned and run on several threads?
+ */
+boolean
+sp_quad_bins_supported(const struct softpipe_context *softpipe)
+{
+   const struct tgsi_shader_info *info = &softpipe->fs_variant->info;
+
+   /* Stores, atomics and framebuffer fetches must happen in order */
+   if (info->writes_memory || info->uses_fbfetch)
+      return FALSE;
+
+#if !DO_PSTIPPLE_IN_DRAW_MODULE && !DO_PSTIPPLE_IN_HELPER_MODULE
+   if (softpipe->rasterizer->poly_stipple_enable)
+      return FALSE;
+#endif
+
+   return TRUE;
+}
+
+
+/**
+ * Called by setup before emitting the quads of a new primitive, which have
+ * new interpolation coefficients.
+ */
+void
+sp_quad_bins_begin_prim(struct sp_quad_bins *bins)
+{
+   bins->prim_coefs = -1;
+}
+
+
+/**
+ * Add a batch of quads to the bin of its tile.  All the quads of a batch
+ * are in the same tile, which the quad stages find with quads[0].
+ */
+void
+sp_quad_bins_add(struct sp_quad_bins *bins,
+                 struct quad_header *quads[], unsigned nr)
+{
+   struct softpipe_context *softpipe = bins->softpipe;
+   const union tile_address addr = tile_address(quads[0]->input.x0,
+                                                quads[0]->input.y0,
+                                                quads[0]->input.layer);
+   const unsigned slot = CACHE_POS(addr.bits.x, addr.bits.y, addr.bits.layer);
+   struct util_dynarray *bin = &bins->bin[slot];
+   const boolean first_use = bin->size == 0;
+   struct sp_binned_batch *batch;
+   struct sp_binned_quad *bq;
+   unsigned i;
+
+   assert(nr <= SP_QUAD_BINS_MAX_QUADS);
+
+   if (bins->size >= SP_QUAD_BINS_MAX_SIZE)
+      sp_quad_bins_flush(bins);
+
+   if (bins->prim_coefs < 0) {
+      const unsigned num_coefs = 1 + softpipe->fs_variant->info.num_inputs;
+      struct tgsi_interp_coef *coefs =
+         util_dynarray_grow(&bins->coefs, struct tgsi_interp_coef, num_coefs);
+
+      if (!coefs)
+         goto fallback;
+
+      coefs[0] = *quads[0]->posCoef;
+      memcpy(coefs + 1, quads[0]->coef, (num_coefs - 1) * sizeof(*coefs));
+      bins->prim_coefs = coefs - (struct tgsi_interp_coef *) bins->coefs.data;
+      bins->size += num_coefs * sizeof(*coefs);
+   }
+
+   batch = util_dynarray_grow_bytes(bin, 1, sizeof(*batch) + nr * sizeof(*bq));
+   if (!batch)
+      goto fallback;
+
+   batch->coefs = bins->prim_coefs;
+   batch->nr = nr;
+
+   bq = (struct sp_binned_quad *) (batch + 1);
+   for (i = 0; i < nr; i++) {
+      bq[i].input = quads[i]->input;
+      bq[i].inout = quads[i]->inout;
+   }
+
+   if (first_use)
+      bins->used[bins->num_used++] = slot;
+   bins->size += sizeof(*batch) + nr * sizeof(*bq);
+   return;
+
+fallback:
+   /* Out of memory, run what was binned so far and then this batch */
+   sp_quad_bins_flush(bins);
+   softpipe->quad.first->run(softpipe->quad.first, quads, nr);
+}
+
+
+/**
+ * Run the quad batches of one bin, in order, through the quad pipeline of
+ * the given context.
+ */
+static void
+run_bin(const struct sp_quad_bins *bins, struct softpipe_context *sp,
+        struct quad_header *quad, struct quad_header *quad_ptrs[],
+        unsigned slot)
+{
+   const struct tgsi_interp_coef *coefs = bins->coefs.data;
+   const struct util_dynarray *bin = &bins->bin[slot];
+   const uint8_t *p = bin->data;
+   const uint8_t *end = p + bin->size;
+   unsigned i;
+
+   while (p < end) {
+      const struct sp_binned_batch *batch =
+         (const struct sp_binned_batch *) p;
+      const struct sp_binned_quad *bq =
+         (const struct sp_binned_quad *) (batch + 1);
+
+      for (i = 0; i < batch->nr; i++) {
+         quad[i].input = bq[i].input;
+         quad[i].inout = bq[i].inout;
+         quad[i].posCoef = &coefs[batch->coefs];
+         quad[i].coef = &coefs[batch->coefs + 1];
+         quad_ptrs[i] = &quad[i];
+      }
+
+      sp->quad.first->run(sp->quad.first, quad_ptrs, batch->nr);
+
+      p = (const uint8_t *) (bq + batch->nr);
+   }
+}
+
+
+static void
+worker_execute(void *job, int thread_index)
+{
+   struct sp_quad_worker *w = (struct sp_quad_worker *) job;
+   struct sp_quad_bins *bins = w->bins;
+   unsigned i;
+
+   while ((i = p_atomic_inc_return(&bins->next_used) - 1) < bins->num_used) {
+      const unsigned slot = bins->used[i];
+
+      run_bin(bins, &w->sp, w->quad, w->quad_ptrs, slot);
+      w->slots[w->num_slots++] = slot;
+   }
+}
+
+
+static boolean
+prepare_worker(struct sp_quad_worker *w)
+{
+   struct softpipe_context *softpipe = w->bins->softpipe;
+   const struct sp_fragment_shader_variant *fs = softpipe->fs_variant;
+   unsigned i;
+
+   if (!softpipe_copy_tgsi_sampler(softpipe, PIPE_SHADER_FRAGMENT,
+                                   &w->sampler, w->tex_cache))
+      return FALSE;
+
+   w->sp = *softpipe;
+   w->sp.quad_bins = NULL;
+   w->sp.fs_machine = w->fs_machine;
+   w->sp.tgsi.sampler[PIPE_SHADER_FRAGMENT] = &w->sampler;
+   w->sp.occlusion_count = 0;
+   w->sp.pipeline_statistics.ps_invocations = 0;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      sp_tile_cache_fork(&w->cbuf_cache[i], softpipe->cbuf_cache[i]);
+      w->sp.cbuf_cache[i] = &w->cbuf_cache[i];
+   }
+   sp_tile_cache_fork(&w->zsbuf_cache, softpipe->zsbuf_cache);
+   w->sp.zsbuf_cache = &w->zsbuf_cache;
+
+   w->sp.quad.shade = w->shade;
+   w->sp.quad.depth_test = w->depth_test;
+   w->sp.quad.blend = w->blend;
+   w->sp.quad.pstipple = NULL;
+   sp_build_quad_pipeline(&w->sp);
+   w->sp.quad.first->begin(w->sp.quad.first);
+
+   /* The sampler is the same object every time, only rebind on shader
+    * changes since that parses the tokens again.
+    */
+   if (w->fs_machine->Tokens != fs->tokens) {
+      fs->prepare(fs, w->fs_machine,
+                  (struct tgsi_sampler *) &w->sampler,
+                  (struct tgsi_image *) softpipe->tgsi.image[PIPE_SHADER_FRAGMENT],
+                  (struct tgsi_buffer *) softpipe->tgsi.buffer[PIPE_SHADER_FRAGMENT]);
+   }
+
+   w->num_slots = 0;
+   return TRUE;
+}
+
+
+/**
+ * Make sure no tile cache needs to allocate tiles while the workers run.
+ */
+static boolean
+reserve_tiles(struct sp_quad_bins *bins)
+{
+   struct softpipe_context *softpipe = bins->softpipe;
+   unsigned i, j;
+
+   for (i = 0; i < bins->num_used; i++) {
+      for (j = 0; j < softpipe->framebuffer.nr_cbufs; j++) {
+         if (softpipe->framebuffer.cbufs[j])
+            sp_tile_cache_reserve(softpipe->cbuf_cache[j], bins->used[i]);
+      }
+      if (softpipe->framebuffer.zsbuf)
+         sp_tile_cache_reserve(softpipe->zsbuf_cache, bins->used[i]);
+   }
+
+   /* When allocations fail tiles are stolen from other positions */
+   for (i = 0; i < bins->num_used; i++) {
+      for (j = 0; j < softpipe->framebuffer.nr_cbufs; j++) {
+         if (softpipe->framebuffer.cbufs[j] &&
+             !softpipe->cbuf_cache[j]->entries[bins->used[i]])
+            return FALSE;
+      }
+      if (softpipe->framebuffer.zsbuf &&
+          !softpipe->zsbuf_cache->entries[bins->used[i]])
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Run all the binned quads and empty the bins.
+ */
+void
+sp_quad_bins_flush(struct sp_quad_bins *bins)
+{
+   struct softpipe_context *softpipe = bins->softpipe;
+   unsigned num_workers = MIN2(bins->num_workers, bins->num_used);
+   unsigned i, j, k;
+
+   if (!bins->num_used)
+      return;
+
+   if (num_workers > 1) {
+      if (!reserve_tiles(bins))
+         num_workers = 1;
+
+      for (i = 0; i < num_workers; i++) {
+         if (!prepare_worker(bins->workers[i])) {
+            num_workers = i;
+            break;
+         }
+      }
+   }
+
+   if (num_workers <= 1) {
+      /* Not worth forking, or out of memory: use the context itself */
+      struct sp_quad_worker *w = bins->workers[0];
+
+      for (i = 0; i < bins->num_used; i++)
+         run_bin(bins, softpipe, w->quad, w->quad_ptrs, bins->used[i]);
+   }
+   else {
+      bins->next_used = 0;
+
+      for (i = 1; i < num_workers; i++) {
+         util_queue_add_job(&bins->queue, bins->workers[i],
+                            &bins->workers[i]->fence, worker_execute,
+                            NULL, 0);
+      }
+
+      worker_execute(bins->workers[0], 0);
+
+      for (i = 0; i < num_workers; i++) {
+         struct sp_quad_worker *w = bins->workers[i];
+
+         if (i > 0)
+            util_queue_fence_wait(&w->fence);
+
+         for (j = 0; j < w->num_slots; j++) {
+            for (k = 0; k < PIPE_MAX_COLOR_BUFS; k++) {
+               sp_tile_cache_join(softpipe->cbuf_cache[k],
+                                  &w->cbuf_cache[k], w->slots[j]);
+            }
+            sp_tile_cache_join(softpipe->zsbuf_cache, &w->zsbuf_cache,
+                               w->slots[j]);
+         }
+
+         softpipe->occlusion_count += w->sp.occlusion_count;
+         softpipe->pipeline_statistics.ps_invocations +=
+            w->sp.pipeline_statistics.ps_invocations;
+      }
+   }
+
+   for (i = 0; i < bins->num_used; i++)
+      util_dynarray_clear(&bins->bin[bins->used[i]]);
+   util_dynarray_clear(&bins->coefs);
+   bins->num_used = 0;
+   bins->size = 0;
+   bins->prim_coefs = -1;
+}
+
+
+/**
+ * Called along with sp_flush_tex_tile_cache() for the context's caches.
+ */
+void
+sp_quad_bins_flush_tex_caches(struct sp_quad_bins *bins)
+{
+   unsigned i, j;
+
+   for (i = 0; i < bins->num_workers; i++) {
+      for (j = 0; j < ARRAY_SIZE(bins->workers[i]->tex_cache); j++) {
+         if (bins->workers[i]->tex_cache[j])
+            sp_flush_tex_tile_cache(bins->workers[i]->tex_cache[j]);
+      }
+   }
+}
+
+
+/**
+ * Unbind a fragment shader variant that is about to be deleted from the
+ * workers' machines, like exec_delete() does for the context's machine.
+ */
+void
+sp_quad_bins_unbind_fs(struct sp_quad_bins *bins,
+                       const struct sp_fragment_shader_variant *var)
+{
+   unsigned i;
+
+   for (i = 0; i < bins->num_workers; i++) {
+      struct tgsi_exec_machine *machine = bins->workers[i]->fs_machine;
+
+      if (machine->Tokens == var->tokens)
+         tgsi_exec_machine_bind_shader(machine, NULL, NULL, NULL, NULL);
+   }
+}
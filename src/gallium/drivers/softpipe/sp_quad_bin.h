@@ -0,0 +1,76 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Binning of quads into screen tiles, so that the quad pipeline can run
+ * on several threads.
+ */
+
+#ifndef SP_QUAD_BIN_H
+#define SP_QUAD_BIN_H
+
+#include "pipe/p_compiler.h"
+
+
+struct softpipe_context;
+struct sp_fragment_shader_variant;
+struct quad_header;
+struct sp_quad_bins;
+
+
+/** Max number of threads running the quad pipeline, including the caller */
+#define SP_MAX_THREADS 16
+
+
+struct sp_quad_bins *
+sp_create_quad_bins(struct softpipe_context *softpipe, unsigned num_threads);
+
+void
+sp_destroy_quad_bins(struct sp_quad_bins *bins);
+
+boolean
+sp_quad_bins_supported(const struct softpipe_context *softpipe);
+
+void
+sp_quad_bins_begin_prim(struct sp_quad_bins *bins);
+
+void
+sp_quad_bins_add(struct sp_quad_bins *bins,
+                 struct quad_header *quads[], unsigned nr);
+
+void
+sp_quad_bins_flush(struct sp_quad_bins *bins);
+
+void
+sp_quad_bins_flush_tex_caches(struct sp_quad_bins *bins);
+
+void
+sp_quad_bins_unbind_fs(struct sp_quad_bins *bins,
+                       const struct sp_fragment_shader_variant *var);
+
+
+#endif /* SP_QUAD_BIN_H */
@@ -34,6 +34,7 @@
 
 #include "sp_context.h"
 #include "sp_quad.h"
+#include "sp_quad_bin.h"
 #include "sp_quad_pipe.h"
 #include "sp_setup.h"
 #include "sp_state.h"
@@ -113,6 +114,9 @@ struct setup_context {
 
    unsigned cull_face;		/* which faces cull */
    unsigned nr_vertex_attrs;
+
+   /** Where quads go instead of the quad pipeline, or NULL */
+   struct sp_quad_bins *bins;
 };
 
 
@@ -153,6 +157,34 @@ quad_clip(struct setup_context *setup, struct quad_header *quad)
 }
 
 
+/**
+ * Pass quads to the quad pipeline, or bin them for the worker threads.
+ */
+static inline void
+emit_quads(struct setup_context *setup, struct quad_header *quads[],
+           unsigned nr)
+{
+   if (setup->bins) {
+      sp_quad_bins_add(setup->bins, quads, nr);
+   }
+   else {
+      struct quad_stage *first = setup->softpipe->quad.first;
+      first->run(first, quads, nr);
+   }
+}
+
+
+/**
+ * Called at the start of each primitive, which has new coefficients.
+ */
+static inline void
+begin_prim(struct setup_context *setup)
+{
+   if (setup->bins)
+      sp_quad_bins_begin_prim(setup->bins);
+}
+
+
 /**
  * Emit a quad (pass to next stage) with clipping.
  */
@@ -162,13 +194,11 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
    quad_clip(setup, quad);
 
    if (quad->inout.mask) {
-      struct softpipe_context *sp = setup->softpipe;
-
 #if DEBUG_FRAGS
       setup->numFragsEmitted += util_bitcount(quad->inout.mask);
 #endif
 
-      sp->quad.first->run( sp->quad.first, &quad, 1 );
+      emit_quads(setup, &quad, 1);
    }
 }
 
@@ -203,7 +233,6 @@ flush_spans(struct setup_context *setup)
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
    const int xright1 = setup->span.right[1];
-   struct quad_stage *pipe = setup->softpipe->quad.first;
 
    const int minleft = block_x(MIN2(xleft0, xleft1));
    const int maxright = MAX2(xright0, xright1);
@@ -248,7 +277,7 @@ flush_spans(struct setup_context *setup)
             lx += 2;
          } while (mask0 | mask1);
 
-         pipe->run( pipe, setup->quad_ptrs, q );
+         emit_quads(setup, setup->quad_ptrs, q);
       }
    }
 
@@ -824,6 +853,7 @@ sp_setup_tri(struct setup_context *setup,
    if (!setup_sort_vertices( setup, det, v0, v1, v2 ))
       return;
 
+   begin_prim( setup );
    setup_tri_coefficients( setup );
    setup_tri_edges( setup );
 
@@ -1099,6 +1129,7 @@ sp_setup_line(struct setup_context *setup,
    if (dx == 0 && dy == 0)
       return;
 
+   begin_prim(setup);
    if (!setup_line_coefficients(setup, v0, v1))
       return;
 
@@ -1275,6 +1306,8 @@ sp_setup_point(struct setup_context *setup,
     */
    setup->vprovoke = v0;
 
+   begin_prim(setup);
+
    /* setup Z, W */
    const_coeff(setup, &setup->posCoef, 0, 2);
    const_coeff(setup, &setup->posCoef, 0, 3);
@@ -1479,6 +1512,12 @@ sp_setup_prepare(struct setup_context *setup)
 
    sp->quad.first->begin( sp->quad.first );
 
+   /* Bin the quads if the state allows running them on several threads */
+   if (sp->quad_bins && sp_quad_bins_supported(sp))
+      setup->bins = sp->quad_bins;
+   else
+      setup->bins = NULL;
+
    if (sp->reduced_api_prim == PIPE_PRIM_TRIANGLES &&
        sp->rasterizer->fill_front == PIPE_POLYGON_MODE_FILL &&
        sp->rasterizer->fill_back == PIPE_POLYGON_MODE_FILL) {
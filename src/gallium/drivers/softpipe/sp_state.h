@@ -60,6 +60,9 @@ struct tgsi_image;
 struct tgsi_buffer;
 struct tgsi_exec_machine;
 struct vertex_info;
+struct sp_tgsi_sampler;
+struct softpipe_tex_tile_cache;
+struct sp_compute_pool;
 
 
 struct sp_fragment_shader_variant_key
@@ -226,4 +229,20 @@ softpipe_launch_grid(struct pipe_context *context,
 
 void
 softpipe_update_compute_samplers(struct softpipe_context *softpipe);
+
+boolean
+softpipe_copy_tgsi_sampler(struct softpipe_context *softpipe,
+                           enum pipe_shader_type shader,
+                           struct sp_tgsi_sampler *sampler,
+                           struct softpipe_tex_tile_cache **tex_cache);
+
+struct sp_compute_pool *
+softpipe_create_compute_pool(struct softpipe_context *softpipe,
+                             unsigned num_threads);
+
+void
+softpipe_destroy_compute_pool(struct sp_compute_pool *pool);
+
+void
+softpipe_compute_pool_flush_tex_caches(struct sp_compute_pool *pool);
 #endif
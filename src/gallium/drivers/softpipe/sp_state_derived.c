@@ -298,6 +298,47 @@ softpipe_update_compute_samplers(struct softpipe_context *softpipe)
    set_shader_sampler(softpipe, PIPE_SHADER_COMPUTE, softpipe->cs->max_sampler);
 }
 
+/**
+ * Copy the samplers of a shader stage for use on another thread.  The copy
+ * gets its own texture tile caches, created as needed, since the caches are
+ * modified while sampling.  They're validated like in update_tgsi_samplers().
+ */
+boolean
+softpipe_copy_tgsi_sampler(struct softpipe_context *softpipe,
+                           enum pipe_shader_type shader,
+                           struct sp_tgsi_sampler *sampler,
+                           struct softpipe_tex_tile_cache **tex_cache)
+{
+   unsigned i;
+
+   *sampler = *softpipe->tgsi.sampler[shader];
+
+   for (i = 0; i < softpipe->num_sampler_views[shader]; i++) {
+      struct softpipe_tex_tile_cache *tc = tex_cache[i];
+
+      if (!tc) {
+         tc = tex_cache[i] = sp_create_tex_tile_cache(&softpipe->pipe);
+         if (!tc)
+            return FALSE;
+      }
+
+      sp_tex_tile_cache_set_sampler_view(tc,
+                                         softpipe->sampler_views[shader][i]);
+
+      if (tc->texture) {
+         struct softpipe_resource *spt = softpipe_resource(tc->texture);
+         if (spt->timestamp != tc->timestamp) {
+            sp_tex_tile_cache_validate_texture(tc);
+            tc->timestamp = spt->timestamp;
+         }
+      }
+
+      sampler->sp_sview[i].cache = tc;
+   }
+
+   return TRUE;
+}
+
 static void
 update_tgsi_samplers( struct softpipe_context *softpipe )
 {
@@ -29,6 +29,7 @@
 #include "sp_state.h"
 #include "sp_fs.h"
 #include "sp_texture.h"
+#include "sp_quad_bin.h"
 
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
@@ -190,6 +191,9 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       draw_delete_fragment_shader(softpipe->draw, var->draw_shader);
 #endif
 
+      if (softpipe->quad_bins)
+         sp_quad_bins_unbind_fs(softpipe->quad_bins, var);
+
       var->delete(var, softpipe->fs_machine);
    }
 
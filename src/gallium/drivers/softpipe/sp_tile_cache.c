@@ -34,6 +34,7 @@
 
 #include "util/u_inlines.h"
 #include "util/format/u_format.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "util/u_tile.h"
 #include "sp_tile_cache.h"
@@ -42,16 +43,6 @@ static struct softpipe_cached_tile *
 sp_alloc_tile(struct softpipe_tile_cache *tc);
 
 
-/**
- * Return the position in the cache for the tile that contains win pos (x,y).
- * We currently use a direct mapped cache so this is like a hack key.
- * At some point we should investige something more sophisticated, like
- * a LRU replacement policy.
- */
-#define CACHE_POS(x, y, l)                        \
-   (((x) + (y) * 5 + (l) * 10) % NUM_ENTRIES)
-
-
 static inline int addr_to_clear_pos(union tile_address addr)
 {
    int pos;
@@ -76,14 +67,20 @@ is_clear_flag_set(const uint *bitvec, union tile_address addr, unsigned max)
 
 /**
  * Mark the tile at (x,y) as not cleared.
+ * Forks of the cache share the flags, so other bits of the word may be
+ * cleared concurrently by other threads.
  */
 static inline void
 clear_clear_flag(uint *bitvec, union tile_address addr, unsigned max)
 {
    int pos;
+   uint old, val;
    pos = addr_to_clear_pos(addr);
    assert(pos / 32 < max);
-   bitvec[pos / 32] &= ~(1 << (pos & 31));
+   do {
+      old = bitvec[pos / 32];
+      val = old & ~(1 << (pos & 31));
+   } while (old != val && p_atomic_cmpxchg(&bitvec[pos / 32], old, val) != old);
 }
    
 
@@ -648,3 +645,50 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
    }
    tc->last_tile_addr.bits.invalid = 1;
 }
+
+
+/**
+ * Make sure the given cache position has a tile allocated, so that a fork
+ * of the cache never needs to allocate or steal tiles.
+ */
+void
+sp_tile_cache_reserve(struct softpipe_tile_cache *tc, unsigned pos)
+{
+   assert(pos < NUM_ENTRIES);
+
+   if (!tc->entries[pos])
+      tc->entries[pos] = sp_alloc_tile(tc);
+}
+
+
+/**
+ * Initialize \p fork as a copy of \p tc which another thread may use to
+ * access the tiles of some cache positions, while other forks access the
+ * other positions.  The positions must have been reserved with
+ * sp_tile_cache_reserve() beforehand.
+ */
+void
+sp_tile_cache_fork(struct softpipe_tile_cache *fork,
+                   const struct softpipe_tile_cache *tc)
+{
+   *fork = *tc;
+   fork->tile = NULL;
+   fork->last_tile = NULL;
+   fork->last_tile_addr.bits.invalid = 1;
+}
+
+
+/**
+ * Take back the state of cache position \p pos from a fork, once the thread
+ * using the fork is done.
+ */
+void
+sp_tile_cache_join(struct softpipe_tile_cache *tc,
+                   const struct softpipe_tile_cache *fork, unsigned pos)
+{
+   assert(pos < NUM_ENTRIES);
+
+   tc->entries[pos] = fork->entries[pos];
+   tc->tile_addrs[pos] = fork->tile_addrs[pos];
+   tc->last_tile_addr.bits.invalid = 1;
+}
@@ -105,30 +105,44 @@ static const struct qpu_reg vc4_regs[] = {
 #define AB_INDEX      (ACC_INDEX + ACC_COUNT)
 #define AB_COUNT      64
 
+#define CLASS_COUNT   11
+
+/**
+ * Sets up the register class indices.
+ *
+ * ra_alloc_reg_class() hands out indices in order, so these match both a
+ * freshly built register set and one deserialized from the screen.
+ */
 static void
-vc4_alloc_reg_set(struct vc4_context *vc4)
+vc4_init_reg_classes(struct vc4_context *vc4)
 {
-        assert(vc4_regs[AB_INDEX].addr == 0);
-        assert(vc4_regs[AB_INDEX + 1].addr == 0);
-        STATIC_ASSERT(ARRAY_SIZE(vc4_regs) == AB_INDEX + 64);
-
-        if (vc4->regs)
-                return;
-
-        vc4->regs = ra_alloc_reg_set(vc4, ARRAY_SIZE(vc4_regs), true);
+        unsigned int class = 0;
 
         /* The physical regfiles split us into two classes, with [0] being the
          * whole space and [1] being the bottom half (for threaded fragment
          * shaders).
          */
         for (int i = 0; i < 2; i++) {
-                vc4->reg_class_any[i] = ra_alloc_reg_class(vc4->regs);
-                vc4->reg_class_a_or_b[i] = ra_alloc_reg_class(vc4->regs);
-                vc4->reg_class_a_or_b_or_acc[i] = ra_alloc_reg_class(vc4->regs);
-                vc4->reg_class_r4_or_a[i] = ra_alloc_reg_class(vc4->regs);
-                vc4->reg_class_a[i] = ra_alloc_reg_class(vc4->regs);
+                vc4->reg_class_any[i] = class++;
+                vc4->reg_class_a_or_b[i] = class++;
+                vc4->reg_class_a_or_b_or_acc[i] = class++;
+                vc4->reg_class_r4_or_a[i] = class++;
+                vc4->reg_class_a[i] = class++;
+        }
+        vc4->reg_class_r0_r3 = class++;
+
+        assert(class == CLASS_COUNT);
+}
+
+static void
+vc4_build_reg_set(struct vc4_context *vc4)
+{
+        vc4->regs = ra_alloc_reg_set(vc4, ARRAY_SIZE(vc4_regs), true);
+
+        for (unsigned int i = 0; i < CLASS_COUNT; i++) {
+                ASSERTED unsigned int class = ra_alloc_reg_class(vc4->regs);
+                assert(class == i);
         }
-        vc4->reg_class_r0_r3 = ra_alloc_reg_class(vc4->regs);
 
         /* r0-r3 */
         for (uint32_t i = ACC_INDEX; i < ACC_INDEX + 4; i++) {
@@ -183,6 +197,39 @@ vc4_alloc_reg_set(struct vc4_context *vc4)
         ra_set_finalize(vc4->regs, NULL);
 }
 
+static void
+vc4_alloc_reg_set(struct vc4_context *vc4)
+{
+        struct vc4_screen *screen = vc4->screen;
+
+        assert(vc4_regs[AB_INDEX].addr == 0);
+        assert(vc4_regs[AB_INDEX + 1].addr == 0);
+        STATIC_ASSERT(ARRAY_SIZE(vc4_regs) == AB_INDEX + 64);
+
+        if (vc4->regs)
+                return;
+
+        vc4_init_reg_classes(vc4);
+
+        /* Finalizing the set is by far the most expensive part, so only the
+         * first context of the screen does it.
+         */
+        mtx_lock(&screen->reg_set_mutex);
+        if (screen->reg_set.size) {
+                struct blob_reader reader;
+                blob_reader_init(&reader, screen->reg_set.data,
+                                 screen->reg_set.size);
+                vc4->regs = ra_set_deserialize(vc4, &reader);
+        }
+
+        if (!vc4->regs) {
+                vc4_build_reg_set(vc4);
+                if (!screen->reg_set.size)
+                        ra_set_serialize(vc4->regs, &screen->reg_set);
+        }
+        mtx_unlock(&screen->reg_set_mutex);
+}
+
 struct node_to_temp_map {
         uint32_t temp;
         uint32_t priority;
@@ -105,6 +105,8 @@ vc4_screen_destroy(struct pipe_screen *pscreen)
         util_hash_table_destroy(screen->bo_handles);
         vc4_bufmgr_destroy(pscreen);
         slab_destroy_parent(&screen->transfer_pool);
+        blob_finish(&screen->reg_set);
+        mtx_destroy(&screen->reg_set_mutex);
         free(screen->ro);
 
 #ifdef USE_VC4_SIMULATOR
@@ -526,6 +528,8 @@ vc4_screen_create(int fd, struct renderonly *ro)
         list_inithead(&screen->bo_cache.time_list);
         (void) mtx_init(&screen->bo_handles_mutex, mtx_plain);
         screen->bo_handles = util_hash_table_create(handle_hash, handle_compare);
+        blob_init(&screen->reg_set);
+        (void) mtx_init(&screen->reg_set_mutex, mtx_plain);
 
         screen->has_control_flow =
                 vc4_has_feature(screen, DRM_VC4_PARAM_SUPPORTS_BRANCHES);
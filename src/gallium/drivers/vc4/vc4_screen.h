@@ -28,6 +28,7 @@
 #include "renderonly/renderonly.h"
 #include "os/os_thread.h"
 #include "state_tracker/drm_driver.h"
+#include "util/blob.h"
 #include "util/list.h"
 #include "util/slab.h"
 
@@ -90,6 +91,13 @@ struct vc4_screen {
         struct util_hash_table *bo_handles;
         mtx_t bo_handles_mutex;
 
+        /**
+         * The finalized register set, serialized by the first context that
+         * built it so that later contexts only have to deserialize it.
+         */
+        struct blob reg_set;
+        mtx_t reg_set_mutex;
+
         uint32_t bo_size;
         uint32_t bo_count;
         bool has_control_flow;
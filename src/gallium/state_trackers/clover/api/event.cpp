@@ -192,7 +192,7 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
 
    // Create a hard event that depends on the events in the wait list:
    // previous commands in the same queue are implicitly serialized
-   // with respect to it -- hard events always are.
+   // with respect to it if the list is empty or the queue is in-order.
    auto hev = create<hard_event>(q, CL_COMMAND_MARKER, deps);
 
    ret_object(rd_ev, hev);
@@ -204,9 +204,12 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
 
 CLOVER_API cl_int
 clEnqueueBarrier(cl_command_queue d_q) try {
-   obj(d_q);
+   auto &q = obj(d_q);
 
-   // No need to do anything, q preserves data ordering strictly.
+   // No need to do anything if q preserves data ordering strictly,
+   // otherwise the barrier event orders the subsequent commands.
+   if (q.out_of_order())
+      create<hard_event>(q, CL_COMMAND_BARRIER, ref_vector<event> {});
 
    return CL_SUCCESS;
 
@@ -225,9 +228,10 @@ clEnqueueBarrierWithWaitList(cl_command_queue d_q, cl_uint num_deps,
          throw error(CL_INVALID_CONTEXT);
    }
 
-   // Create a hard event that depends on the events in the wait list:
-   // subsequent commands in the same queue will be implicitly
-   // serialized with respect to it -- hard events always are.
+   // Create a hard event that depends on the events in the wait list,
+   // or on all previous commands if the list is empty: subsequent
+   // commands in the same queue will be implicitly serialized with
+   // respect to it.
    auto hev = create<hard_event>(q, CL_COMMAND_BARRIER, deps);
 
    ret_object(rd_ev, hev);
@@ -295,9 +299,10 @@ CLOVER_API cl_int
 clFinish(cl_command_queue d_q) try {
    auto &q = obj(d_q);
 
-   // Create a temporary hard event -- it implicitly depends on all
-   // the previously queued hard events.
-   auto hev = create<hard_event>(q, 0, ref_vector<event> {});
+   // Create a temporary marker -- without a wait list it implicitly
+   // depends on all the previously queued hard events, even if the
+   // queue is out of order.
+   auto hev = create<hard_event>(q, CL_COMMAND_MARKER, ref_vector<event> {});
 
    // And wait on it.
    hev().wait();
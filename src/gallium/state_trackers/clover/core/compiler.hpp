@@ -23,44 +23,231 @@
 #ifndef CLOVER_CORE_COMPILER_HPP
 #define CLOVER_CORE_COMPILER_HPP
 
+#include <algorithm>
+#include <sstream>
+
 #include "core/device.hpp"
 #include "core/module.hpp"
 #include "llvm/invocation.hpp"
 #include "nir/invocation.hpp"
 #include "spirv/invocation.hpp"
+#include "util/disk_cache.h"
 
 namespace clover {
    namespace compiler {
+      namespace detail {
+         static inline void
+         hash_string(mesa_sha1 &ctx, const std::string &s) {
+            const uint32_t size = s.size();
+
+            _mesa_sha1_update(&ctx, &size, sizeof(size));
+            _mesa_sha1_update(&ctx, s.data(), size);
+         }
+
+         static inline void
+         hash_module(mesa_sha1 &ctx, const module &m) {
+            std::ostringstream os;
+
+            m.serialize(os);
+            hash_string(ctx, os.str());
+         }
+
+         ///
+         /// Whether compiling \a source may read files that aren't among
+         /// the inputs of the cache key: -I and similar options, and
+         /// #include directives that don't name one of the embedded
+         /// \a headers.  Directives are matched conservatively, ignoring
+         /// comments and conditionals.
+         ///
+         static inline bool
+         reads_include_files(const std::string &source,
+                             const header_map &headers,
+                             const std::string &opts) {
+            std::istringstream os(opts);
+            std::string opt;
+
+            while (os >> opt) {
+               if (opt.compare(0, 2, "-I") == 0 ||
+                   opt.compare(0, 2, "-i") == 0 ||
+                   opt.compare(0, 9, "--include") == 0)
+                  return true;
+            }
+
+            std::vector<const std::string *> texts = { &source };
+            for (auto &header : headers)
+               texts.push_back(&header.second);
+
+            for (const std::string *text : texts) {
+               std::istringstream is(*text);
+               std::string line;
+
+               while (std::getline(is, line)) {
+                  size_t i = line.find_first_not_of(" \t");
+                  if (i == std::string::npos || line[i] != '#')
+                     continue;
+
+                  i = line.find_first_not_of(" \t", i + 1);
+                  if (i == std::string::npos ||
+                      (line.compare(i, 7, "include") != 0 &&
+                       line.compare(i, 6, "import") != 0))
+                     continue;
+
+                  // Anything but a quoted name, like a macro, may name
+                  // any file.
+                  i = line.find_first_of("<\"", i);
+                  if (i == std::string::npos)
+                     return true;
+
+                  const size_t end = line.find(line[i] == '<' ? '>' : '"',
+                                               i + 1);
+                  if (end == std::string::npos)
+                     return true;
+
+                  const std::string name = line.substr(i + 1, end - i - 1);
+                  if (std::none_of(headers.begin(), headers.end(),
+                                   [&](const std::pair<std::string,
+                                                       std::string> &h) {
+                                      return h.first == name;
+                                   }))
+                     return true;
+               }
+            }
+
+            return false;
+         }
+
+         ///
+         /// Return the module built by \a build from the inputs hashed by
+         /// \a hash_inputs, taking it from the program cache of \a dev if
+         /// an identical build was done before.  The part of the build log
+         /// written by \a build is cached along with the module.
+         ///
+         template<typename H, typename B>
+         module
+         cached_build(const device &dev, const char *stage, std::string &log,
+                      H hash_inputs, B build) {
+            ::disk_cache *cache = dev.program_cache();
+
+            if (!cache)
+               return build();
+
+            mesa_sha1 ctx;
+            cache_key key;
+
+            _mesa_sha1_init(&ctx);
+            hash_string(ctx, stage);
+#ifdef MESA_LLVM_VERSION_STRING
+            hash_string(ctx, MESA_LLVM_VERSION_STRING);
+#endif
+            hash_string(ctx, dev.device_name());
+            hash_string(ctx, dev.ir_target());
+            hash_string(ctx, std::to_string(dev.ir_format()));
+            hash_inputs(ctx);
+            _mesa_sha1_final(&ctx, key);
+
+            size_t size;
+            if (void *data = disk_cache_get(cache, key, &size)) {
+               std::istringstream is(std::string((const char *)data, size));
+               free(data);
+
+               try {
+                  uint32_t log_size;
+                  is.read((char *)&log_size, sizeof(log_size));
+                  std::string cached_log(log_size, '\0');
+                  is.read(&cached_log[0], log_size);
+                  const module m = module::deserialize(is);
+
+                  if (is) {
+                     log += cached_log;
+                     return m;
+                  }
+               } catch (...) {
+               }
+            }
+
+            const size_t log_start = log.size();
+            const module m = build();
+            const std::string build_log = log.substr(log_start);
+            const uint32_t log_size = build_log.size();
+            std::ostringstream os;
+
+            os.write((const char *)&log_size, sizeof(log_size));
+            os << build_log;
+            m.serialize(os);
+
+            const std::string entry = os.str();
+            disk_cache_put(cache, key, entry.data(), entry.size(), NULL);
+
+            return m;
+         }
+      }
+
       static inline module
       compile_program(const std::string &source, const header_map &headers,
                       const device &dev, const std::string &opts,
                       std::string &log) {
-         switch (dev.ir_format()) {
+         auto build = [&]() {
+            switch (dev.ir_format()) {
 #ifdef HAVE_CLOVER_SPIRV
-         case PIPE_SHADER_IR_NIR_SERIALIZED:
-            return llvm::compile_to_spirv(source, headers, dev, opts, log);
+            case PIPE_SHADER_IR_NIR_SERIALIZED:
+               return llvm::compile_to_spirv(source, headers, dev, opts,
+                                             log);
 #endif
-         case PIPE_SHADER_IR_NATIVE:
-            return llvm::compile_program(source, headers, dev, opts, log);
-         default:
-            unreachable("device with unsupported IR");
-            throw error(CL_INVALID_VALUE);
-         }
+            case PIPE_SHADER_IR_NATIVE:
+               return llvm::compile_program(source, headers, dev, opts,
+                                            log);
+            default:
+               unreachable("device with unsupported IR");
+               throw error(CL_INVALID_VALUE);
+            }
+         };
+
+         // Files found through the include paths can't be part of the key.
+         if (detail::reads_include_files(source, headers, opts))
+            return build();
+
+         return detail::cached_build(dev, "compile", log,
+            [&](mesa_sha1 &ctx) {
+               detail::hash_string(ctx, opts);
+               detail::hash_string(ctx, source);
+
+               for (auto &header : headers) {
+                  detail::hash_string(ctx, header.first);
+                  detail::hash_string(ctx, header.second);
+               }
+
+               if (dev.ir_format() == PIPE_SHADER_IR_NATIVE)
+                  detail::hash_string(ctx, llvm::libclc_identity(dev));
+            },
+            build);
       }
 
       static inline module
       link_program(const std::vector<module> &ms, const device &dev,
                    const std::string &opts, std::string &log) {
-         switch (dev.ir_format()) {
-         case PIPE_SHADER_IR_NIR_SERIALIZED:
-            return nir::spirv_to_nir(spirv::link_program(ms, dev, opts, log),
-                                     dev, log);
-         case PIPE_SHADER_IR_NATIVE:
-            return llvm::link_program(ms, dev, opts, log);
-         default:
-            unreachable("device with unsupported IR");
-            throw error(CL_INVALID_VALUE);
-         }
+         return detail::cached_build(dev, "link", log,
+            [&](mesa_sha1 &ctx) {
+               detail::hash_string(ctx, opts);
+
+               for (auto &m : ms)
+                  detail::hash_module(ctx, m);
+
+               if (dev.ir_format() == PIPE_SHADER_IR_NIR_SERIALIZED)
+                  detail::hash_string(ctx, nir::compiler_options_id(dev));
+            },
+            [&]() {
+               switch (dev.ir_format()) {
+               case PIPE_SHADER_IR_NIR_SERIALIZED:
+                  return nir::spirv_to_nir(spirv::link_program(ms, dev, opts,
+                                                               log),
+                                           dev, log);
+               case PIPE_SHADER_IR_NATIVE:
+                  return llvm::link_program(ms, dev, opts, log);
+               default:
+                  unreachable("device with unsupported IR");
+                  throw error(CL_INVALID_VALUE);
+               }
+            });
       }
    }
 }
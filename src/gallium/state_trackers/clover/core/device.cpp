@@ -26,6 +26,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 #include "util/bitscan.h"
+#include "util/disk_cache.h"
 #include "util/u_debug.h"
 
 using namespace clover;
@@ -41,17 +42,54 @@ namespace {
       pipe->get_compute_param(pipe, ir_format, cap, &v.front());
       return v;
    }
+
+   ::disk_cache *
+   create_program_cache(pipe_screen *pipe) {
+#ifdef HAVE_DLADDR
+      struct mesa_sha1 ctx;
+      unsigned char sha1[20];
+      char cache_id[20 * 2 + 1];
+
+      _mesa_sha1_init(&ctx);
+
+      if (!disk_cache_get_function_identifier((void *)create_program_cache,
+                                              &ctx))
+         return NULL;
+
+      // Identify the driver too, which provides the NIR compiler options.
+      // Its shader cache key covers its build and the GPU.
+      if (pipe->get_disk_shader_cache) {
+         if (::disk_cache *driver_cache = pipe->get_disk_shader_cache(pipe)) {
+            cache_key driver_key;
+
+            disk_cache_compute_key(driver_cache, NULL, 0, driver_key);
+            _mesa_sha1_update(&ctx, driver_key, sizeof(driver_key));
+         }
+      }
+
+      _mesa_sha1_final(&ctx, sha1);
+      disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+
+      return disk_cache_create("clover", cache_id, 0);
+#else
+      return NULL;
+#endif
+   }
 }
 
 device::device(clover::platform &platform, pipe_loader_device *ldev) :
-   platform(platform), ldev(ldev) {
+   platform(platform), ldev(ldev), cache(NULL) {
    pipe = pipe_loader_create_screen(ldev);
    if (pipe && pipe->get_param(pipe, PIPE_CAP_COMPUTE)) {
-      if (supports_ir(PIPE_SHADER_IR_NATIVE))
+      if (supports_ir(PIPE_SHADER_IR_NATIVE)) {
+         cache = create_program_cache(pipe);
          return;
+      }
 #ifdef HAVE_CLOVER_SPIRV
-      if (supports_ir(PIPE_SHADER_IR_NIR_SERIALIZED))
+      if (supports_ir(PIPE_SHADER_IR_NIR_SERIALIZED)) {
+         cache = create_program_cache(pipe);
          return;
+      }
 #endif
    }
    if (pipe)
@@ -60,6 +98,8 @@ device::device(clover::platform &platform, pipe_loader_device *ldev) :
 }
 
 device::~device() {
+   if (cache)
+      disk_cache_destroy(cache);
    if (pipe)
       pipe->destroy(pipe);
    if (ldev)
@@ -308,3 +348,8 @@ const void *
 device::get_compiler_options(enum pipe_shader_ir ir) const {
    return pipe->get_compiler_options(pipe, ir, PIPE_SHADER_COMPUTE);
 }
+
+::disk_cache *
+device::program_cache() const {
+   return cache;
+}
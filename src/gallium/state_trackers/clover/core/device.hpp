@@ -30,6 +30,8 @@
 #include "core/format.hpp"
 #include "pipe-loader/pipe_loader.h"
 
+struct disk_cache;
+
 namespace clover {
    class platform;
    class root_resource;
@@ -92,11 +94,17 @@ namespace clover {
       supported_formats(const context &, cl_mem_object_type);
       const void *get_compiler_options(enum pipe_shader_ir ir) const;
 
+      ///
+      /// On-disk cache of compiled programs, or NULL if it's disabled.
+      ///
+      ::disk_cache *program_cache() const;
+
       clover::platform &platform;
 
    private:
       pipe_screen *pipe;
       pipe_loader_device *ldev;
+      ::disk_cache *cache;
    };
 }
 
@@ -102,9 +102,9 @@ namespace clover {
    ///
    /// Similar to a normal clover::event.  In addition it's associated
    /// with a given command queue \a q and a given OpenCL \a command.
-   /// hard_event instances created for the same queue are implicitly
-   /// ordered with respect to each other, and they are implicitly
-   /// triggered on construction.
+   /// hard_event instances created for the same in-order queue are
+   /// implicitly ordered with respect to each other, and they are
+   /// implicitly triggered on construction.
    ///
    /// A hard_event is considered complete when the associated
    /// hardware task finishes execution.
@@ -135,6 +135,7 @@ namespace clover {
    private:
       virtual void fence(pipe_fence_handle *fence);
       action profile(command_queue &q, const action &action) const;
+      action serialize(command_queue &q, const action &action) const;
 
       const intrusive_ref<command_queue> _queue;
       cl_command_type _command;
@@ -68,18 +68,33 @@ command_queue::flush() {
    pipe_screen *screen = device().pipe;
    pipe_fence_handle *fence = NULL;
 
+   std::unique_lock<std::recursive_mutex> pipe_lock(pipe_mutex,
+                                                    std::defer_lock);
+   if (out_of_order())
+      pipe_lock.lock();
+
    std::lock_guard<std::mutex> lock(queued_events_mutex);
    if (!queued_events.empty()) {
       pipe->flush(pipe, &fence, 0);
 
-      while (!queued_events.empty() &&
-             queued_events.front()().signalled()) {
-         queued_events.front()().fence(fence);
-         queued_events.pop_front();
+      // The events of an out-of-order queue aren't necessarily
+      // signalled in the order they were queued.
+      for (auto it = queued_events.begin(); it != queued_events.end();) {
+         if ((*it)().signalled()) {
+            (*it)().fence(fence);
+            it = queued_events.erase(it);
+         } else if (out_of_order()) {
+            ++it;
+         } else {
+            break;
+         }
       }
 
       screen->fence_reference(screen, &fence, NULL);
    }
+
+   if (last_barrier && last_barrier->signalled())
+      last_barrier = NULL;
 }
 
 cl_command_queue_properties
@@ -92,11 +107,37 @@ command_queue::profiling_enabled() const {
    return props & CL_QUEUE_PROFILING_ENABLE;
 }
 
+bool
+command_queue::out_of_order() const {
+   return props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+}
+
 void
 command_queue::sequence(hard_event &ev) {
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty())
-      queued_events.back()().chain(ev);
+
+   if (!out_of_order()) {
+      if (!queued_events.empty())
+         queued_events.back()().chain(ev);
+
+   } else {
+      const bool barrier = ev.command() == CL_COMMAND_BARRIER;
+
+      // A marker or barrier without a wait list waits for every
+      // previous command.  Commands no longer in the pending list
+      // have been signalled already.
+      if ((barrier || ev.command() == CL_COMMAND_MARKER) &&
+          ev.deps.empty()) {
+         for (hard_event &prev : queued_events)
+            prev.chain(ev);
+
+      } else if (last_barrier) {
+         last_barrier->chain(ev);
+      }
+
+      if (barrier)
+         last_barrier = &ev;
+   }
 
    queued_events.push_back(ev);
 }
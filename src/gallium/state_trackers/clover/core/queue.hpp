@@ -50,6 +50,7 @@ namespace clover {
 
       cl_command_queue_properties properties() const;
       bool profiling_enabled() const;
+      bool out_of_order() const;
 
       const intrusive_ref<clover::context> context;
       const intrusive_ref<clover::device> device;
@@ -65,13 +66,20 @@ namespace clover {
 
    private:
       /// Serialize a hardware event with respect to the previous ones,
-      /// and push it to the pending list.
+      /// and push it to the pending list.  In an out-of-order queue
+      /// only markers and barriers wait for the previous events, and
+      /// every other event only waits for the last barrier.
       void sequence(hard_event &ev);
 
       cl_command_queue_properties props;
       pipe_context *pipe;
       std::mutex queued_events_mutex;
       std::deque<intrusive_ref<hard_event>> queued_events;
+      intrusive_ptr<hard_event> last_barrier;
+
+      /// Held while the pipe context is in use by an out-of-order
+      /// queue, whose events can be triggered from any thread.
+      std::recursive_mutex pipe_mutex;
    };
 }
 
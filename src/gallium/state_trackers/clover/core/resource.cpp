@@ -141,7 +141,8 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
 
    if (obj.flags() & CL_MEM_USE_HOST_PTR && user_ptr_support) {
       // Page alignment is normally required for this, just try, hope for the
-      // best and fall back if it fails.
+      // best and fall back if it fails.  On CPU drivers the resource is the
+      // host memory itself, so mapping it later doesn't copy anything.
       pipe = dev.pipe->resource_from_user_memory(dev.pipe, &info, obj.host_ptr());
       if (pipe)
          return;
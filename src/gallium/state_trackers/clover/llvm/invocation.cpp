@@ -40,6 +40,8 @@
 #include <clang/Frontend/TextDiagnosticPrinter.h>
 #include <clang/Basic/TargetInfo.h>
 
+#include <sys/stat.h>
+
 // We need to include internal headers last, because the internal headers
 // include CL headers which have #define's like:
 //
@@ -330,6 +332,25 @@ clover::llvm::compile_program(const std::string &source,
    return build_module_library(*mod, module::section::text_intermediate);
 }
 
+std::string
+clover::llvm::libclc_identity(const device &dev) {
+   std::string id;
+
+   for (const std::string &path : {
+           std::string(LIBCLC_INCLUDEDIR) + "clc/clc.h",
+           LIBCLC_LIBEXECDIR + dev.ir_target() + ".bc" }) {
+      struct stat st;
+
+      id += path;
+      if (!stat(path.c_str(), &st))
+         id += ":" + std::to_string(st.st_size) +
+               ":" + std::to_string(st.st_mtime);
+      id += '\n';
+   }
+
+   return id;
+}
+
 namespace {
    void
    optimize(Module &mod, unsigned optimization_level,
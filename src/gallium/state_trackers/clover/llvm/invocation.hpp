@@ -36,6 +36,12 @@ namespace clover {
                              const std::string &opts,
                              std::string &r_log);
 
+      ///
+      /// Identify the libclc headers and bitcode read by compile_program()
+      /// for \a device, by their paths, sizes and modification times.
+      ///
+      std::string libclc_identity(const device &device);
+
       module link_program(const std::vector<module> &modules,
                           const device &device,
                           const std::string &opts,
@@ -166,3 +166,14 @@ module clover::nir::spirv_to_nir(const module &mod, const device &dev, std::stri
    throw error(CL_LINKER_NOT_AVAILABLE);
 }
 #endif
+
+std::string clover::nir::compiler_options_id(const device &dev)
+{
+   const void *co = dev.get_compiler_options(PIPE_SHADER_IR_NIR);
+
+   if (!co)
+      return "";
+
+   return std::string(static_cast<const char *>(co),
+                      sizeof(nir_shader_compiler_options));
+}
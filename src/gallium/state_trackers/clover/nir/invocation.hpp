@@ -30,6 +30,10 @@ namespace clover {
    namespace nir {
       // converts a given spirv module to nir
       module spirv_to_nir(const module &mod, const device &dev, std::string &r_log);
+
+      // returns the raw nir compiler options of the device, which
+      // spirv_to_nir depends on
+      std::string compiler_options_id(const device &dev);
    }
 }
 
@@ -0,0 +1,129 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ *  Test case for the eviction of cso_cache.
+ *
+ *  Bound states can't be deleted, and must stay in the cache even if there
+ *  are more of them than its maximum size, without eviction looping over
+ *  them forever.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cso_cache/cso_cache.h"
+#include "util/u_memory.h"
+
+
+#define NUM_BOUND 6
+#define NUM_UNBOUND 10
+
+static unsigned deleted;
+
+
+#define CHECK(_cond) \
+   if (!(_cond)) { \
+      fprintf(stderr, "%s:%u: `%s` failed\n", __FILE__, __LINE__, #_cond); \
+      exit(EXIT_FAILURE); \
+   }
+
+
+/* Samplers with a non-NULL data pointer are bound. */
+static boolean
+delete_sampler(void *state, enum cso_cache_type type, void *user_data)
+{
+   struct cso_sampler *cso = (struct cso_sampler *)state;
+
+   CHECK(type == CSO_SAMPLER);
+   if (cso->data)
+      return FALSE;
+
+   deleted++;
+   FREE(cso);
+   return TRUE;
+}
+
+static void
+insert_sampler(struct cso_cache *sc, unsigned key, bool bound)
+{
+   struct cso_sampler *cso = CALLOC_STRUCT(cso_sampler);
+
+   CHECK(cso);
+   cso->data = bound ? cso : NULL;
+   cso_insert_state(sc, key, CSO_SAMPLER, cso);
+}
+
+static unsigned
+count_samplers(struct cso_cache *sc)
+{
+   unsigned count = 0;
+
+   for (unsigned key = 0; key < NUM_BOUND + NUM_UNBOUND; key++) {
+      if (!cso_hash_iter_is_null(cso_find_state(sc, key, CSO_SAMPLER)))
+         count++;
+   }
+   return count;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct cso_cache *sc = cso_cache_create();
+   struct cso_cache_stats stats;
+
+   CHECK(sc);
+   cso_cache_set_delete_callback(sc, delete_sampler, NULL);
+   cso_set_maximum_cache_size(sc, 4);
+
+   for (unsigned key = 0; key < NUM_BOUND; key++)
+      insert_sampler(sc, key, true);
+   CHECK(deleted == 0);
+   CHECK(count_samplers(sc) == NUM_BOUND);
+
+   /* Every insertion has to evict unbound samplers behind bound ones. */
+   for (unsigned key = NUM_BOUND; key < NUM_BOUND + NUM_UNBOUND; key++)
+      insert_sampler(sc, key, false);
+   CHECK(deleted > 0);
+   for (unsigned key = 0; key < NUM_BOUND; key++)
+      CHECK(!cso_hash_iter_is_null(cso_find_state(sc, key, CSO_SAMPLER)));
+
+   /* Nothing but bound samplers left after shrinking the cache. */
+   cso_set_maximum_cache_size(sc, 2);
+   CHECK(count_samplers(sc) == NUM_BOUND);
+   CHECK(deleted == NUM_UNBOUND);
+
+   cso_cache_get_stats(sc, CSO_SAMPLER, &stats);
+   CHECK(stats.evictions == NUM_UNBOUND);
+
+   cso_cache_delete(sc);
+
+   printf("Success!\n");
+   return 0;
+}
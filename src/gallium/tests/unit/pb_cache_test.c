@@ -0,0 +1,131 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ *  Test case for the pb_cache trimmer thread.
+ *
+ *  Buffers of increasing size classes are added to a cache whose trimmer
+ *  budget is smaller than their total size.  The trimmer must release the
+ *  largest buffers, and only those, long before any buffer expires.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipebuffer/pb_cache.h"
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_memory.h"
+#include "util/u_thread.h"
+
+
+#define NUM_BUFFERS 10
+#define EXPIRY_USECS 4000000
+#define BUDGET (1024 * 1024)
+
+struct test_buffer {
+   struct pb_buffer base;
+   struct pb_cache_entry cache_entry;
+};
+
+static unsigned destroyed;
+static unsigned destroyed_pages;
+
+
+#define CHECK(_cond) \
+   if (!(_cond)) { \
+      fprintf(stderr, "%s:%u: `%s` failed\n", __FILE__, __LINE__, #_cond); \
+      _exit(EXIT_FAILURE); \
+   }
+
+
+static void
+destroy_buffer(struct pb_buffer *buf)
+{
+   struct test_buffer *tbuf = (struct test_buffer *)buf;
+
+   p_atomic_inc(&destroyed);
+   p_atomic_add(&destroyed_pages, buf->size / 4096);
+   FREE(tbuf);
+}
+
+static bool
+can_reclaim(struct pb_buffer *buf)
+{
+   return true;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pb_cache cache;
+   uint64_t total = 0;
+   int64_t start;
+
+   pb_cache_init(&cache, 1, EXPIRY_USECS, 1.0f, 0, 1ull << 32,
+                 destroy_buffer, can_reclaim);
+   pb_cache_start_trimmer(&cache, BUDGET);
+   start = os_time_get();
+
+   /* 4 KB, 8 KB, ..., 2 MB: one buffer per size class. */
+   for (unsigned i = 0; i < NUM_BUFFERS; i++) {
+      struct test_buffer *buf = CALLOC_STRUCT(test_buffer);
+
+      CHECK(buf);
+      buf->base.size = 4096ull << i;
+      buf->base.alignment = 4096;
+      pb_cache_init_entry(&cache, &buf->cache_entry, &buf->base, 0);
+      pb_cache_add_buffer(&buf->cache_entry);
+      total += buf->base.size;
+   }
+   CHECK(cache.cache_size == total);
+   CHECK(total > BUDGET);
+
+   while (p_atomic_read(&cache.cache_size) > BUDGET) {
+      CHECK(os_time_get() - start < EXPIRY_USECS);
+      os_time_sleep(10000);
+   }
+
+   /* Wait for the trimmer to finish with the heap. */
+   mtx_lock(&cache.heaps[0].mutex);
+   mtx_unlock(&cache.heaps[0].mutex);
+   CHECK(os_time_get() - start < EXPIRY_USECS);
+
+   /* Only the 1 MB and 2 MB buffers are gone. */
+   CHECK(destroyed == 2);
+   CHECK(destroyed_pages == 256 + 512);
+   CHECK(cache.num_buffers == NUM_BUFFERS - 2);
+   CHECK(cache.cache_size == total - (3 << 20));
+
+   pb_cache_deinit(&cache);
+   CHECK(destroyed == NUM_BUFFERS);
+
+   printf("Success!\n");
+   return 0;
+}
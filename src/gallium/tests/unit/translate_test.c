@@ -54,7 +54,7 @@ int main(int argc, char** argv)
    unsigned output_format;
    unsigned input_format;
    unsigned buffer_size = 4096;
-   unsigned char* buffer[5];
+   unsigned char* buffer[6];
    unsigned char* byte_buffer;
    float* float_buffer;
    double* double_buffer;
@@ -246,7 +246,7 @@ int main(int argc, char** argv)
                continue;
          }
 
-         for(i = 1; i < 5; ++i)
+         for(i = 1; i < ARRAY_SIZE(buffer); ++i)
             memset(buffer[i], 0xcd - (0x22 * i), 4096);
 
          if(input_is_float && input_format_desc->channel[0].size == 32)
@@ -269,6 +269,12 @@ int main(int argc, char** argv)
          translate[1]->set_buffer(translate[1], 0, buffer[3], output_format_size, count - 1);
          translate[1]->run_elts(translate[1], elts, count, 0, 0, buffer[4]);
 
+         /* run() must give the same results as run_elts() */
+         translate[0]->set_buffer(translate[0], 0, buffer[0], input_format_size, count - 1);
+         translate[0]->run(translate[0], 0, count, 0, 0, buffer[5]);
+         if (memcmp(buffer[1], buffer[5], count * output_format_size))
+            fail = 1;
+
          for (i = 0; i < count; ++i)
          {
             float a[4];
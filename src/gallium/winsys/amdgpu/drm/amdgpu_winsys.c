@@ -416,6 +416,8 @@ amdgpu_winsys_create(int fd, const struct pipe_screen_config *config,
                     500000, aws->check_vm ? 1.0f : 2.0f, 0,
                     (aws->info.vram_size + aws->info.gart_size) / 8,
                     amdgpu_bo_destroy, amdgpu_bo_can_reclaim);
+      /* Release expired buffers even while nothing is allocated. */
+      pb_cache_start_trimmer(&aws->bo_cache, aws->bo_cache.max_cache_size);
 
       unsigned min_slab_order = 9;  /* 512 bytes */
       unsigned max_slab_order = 18; /* 256 KB - higher numbers increase memory usage */
@@ -866,6 +866,8 @@ radeon_drm_winsys_create(int fd, const struct pipe_screen_config *config,
                   MIN2(ws->info.vram_size, ws->info.gart_size),
                   radeon_bo_destroy,
                   radeon_bo_can_reclaim);
+    /* Release expired buffers even while nothing is allocated. */
+    pb_cache_start_trimmer(&ws->bo_cache, ws->bo_cache.max_cache_size);
 
     if (ws->info.r600_has_virtual_memory) {
         /* There is no fundamental obstacle to using slab buffer allocation
@@ -58,7 +58,7 @@ class PrintCode(gl_XML.gl_print_base):
         print('{')
         for func in api.functionIterateAll():
             flavor = func.marshal_flavor()
-            if flavor in ('skip', 'sync'):
+            if flavor in ('skip', 'sync', 'custom_sync'):
                 continue
             print('   DISPATCH_CMD_{0},'.format(func.name))
         print('};')
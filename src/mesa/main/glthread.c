@@ -37,6 +37,7 @@
 #include "main/marshal.h"
 #include "main/marshal_generated.h"
 #include "util/u_atomic.h"
+#include "util/u_math.h"
 #include "util/u_thread.h"
 
 
@@ -49,13 +50,96 @@ glthread_unmarshal_batch(void *job, int thread_index)
 
    _glapi_set_dispatch(ctx->CurrentServerDispatch);
 
-   while (pos < batch->used)
-      pos += _mesa_unmarshal_dispatch_cmd(ctx, &batch->buffer[pos]);
+   while (pos < batch->used) {
+      size_t cmd_size = _mesa_unmarshal_dispatch_cmd(ctx, &batch->buffer[pos]);
+
+      /* Large commands fill their batch and don't record their size. */
+      pos += cmd_size ? cmd_size : batch->used - pos;
+   }
 
    assert(pos == batch->used);
    batch->used = 0;
 }
 
+/**
+ * Give the buffer of a large command back to the pool once its batch has
+ * been executed, and switch the batch back to its inline buffer.
+ */
+static void
+glthread_recycle_batch(struct glthread_state *glthread,
+                       struct glthread_batch *batch)
+{
+   if (batch->buffer == batch->inline_buffer)
+      return;
+
+   util_queue_fence_wait(&batch->fence);
+   assert(!batch->used);
+
+   /* Keep the largest buffers. */
+   struct glthread_spare_buffer *smallest = &glthread->spare_buffers[0];
+   for (unsigned i = 1; i < MARSHAL_MAX_BATCHES; i++) {
+      if (glthread->spare_buffers[i].size < smallest->size)
+         smallest = &glthread->spare_buffers[i];
+   }
+
+   if (smallest->size < batch->size) {
+      free(smallest->buffer);
+      smallest->buffer = batch->buffer;
+      smallest->size = batch->size;
+   } else {
+      free(batch->buffer);
+   }
+
+   batch->buffer = batch->inline_buffer;
+   batch->size = sizeof(batch->inline_buffer);
+}
+
+/**
+ * Reserve the next batch for a command larger than MARSHAL_MAX_CMD_SIZE, so
+ * that the following _mesa_glthread_allocate_command() returns the whole
+ * batch.  Returns false if the command can't be queued.
+ */
+bool
+_mesa_glthread_reserve_large_command(struct gl_context *ctx, size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (size > MARSHAL_MAX_LARGE_CMD_SIZE)
+      return false;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   struct glthread_batch *next = &glthread->batches[glthread->next];
+   assert(!next->used && next->buffer == next->inline_buffer);
+
+   /* Take the smallest spare buffer that is large enough. */
+   struct glthread_spare_buffer *best = NULL;
+   for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++) {
+      struct glthread_spare_buffer *spare = &glthread->spare_buffers[i];
+
+      if (spare->size >= size && (!best || spare->size < best->size))
+         best = spare;
+   }
+
+   if (best) {
+      next->buffer = best->buffer;
+      next->size = best->size;
+      best->buffer = NULL;
+      best->size = 0;
+      return true;
+   }
+
+   /* Round up, so that similar sizes share buffers. */
+   size_t alloc_size = util_next_power_of_two(size);
+   uint8_t *buffer = malloc(alloc_size);
+   if (!buffer)
+      return false;
+
+   next->buffer = buffer;
+   next->size = alloc_size;
+   return true;
+}
+
 static void
 glthread_thread_initialization(void *job, int thread_index)
 {
@@ -88,6 +172,8 @@ _mesa_glthread_init(struct gl_context *ctx)
 
    for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++) {
       glthread->batches[i].ctx = ctx;
+      glthread->batches[i].buffer = glthread->batches[i].inline_buffer;
+      glthread->batches[i].size = MARSHAL_MAX_CMD_SIZE;
       util_queue_fence_init(&glthread->batches[i].fence);
    }
 
@@ -115,8 +201,13 @@ _mesa_glthread_destroy(struct gl_context *ctx)
    _mesa_glthread_finish(ctx);
    util_queue_destroy(&glthread->queue);
 
-   for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++)
+   for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++) {
+      glthread_recycle_batch(glthread, &glthread->batches[i]);
       util_queue_fence_destroy(&glthread->batches[i].fence);
+   }
+
+   for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++)
+      free(glthread->spare_buffers[i].buffer);
 
    free(glthread);
    ctx->GLThread = NULL;
@@ -161,6 +252,7 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
    if (false) {
       glthread_unmarshal_batch(next, 0);
       _glapi_set_dispatch(ctx->CurrentClientDispatch);
+      glthread_recycle_batch(glthread, next);
       return;
    }
 
@@ -170,6 +262,11 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
                       glthread_unmarshal_batch, NULL, 0);
    glthread->last = glthread->next;
    glthread->next = (glthread->next + 1) % MARSHAL_MAX_BATCHES;
+
+   /* The batch we are about to fill has been executed, because the queue
+    * only has room for the batches in between.
+    */
+   glthread_recycle_batch(glthread, &glthread->batches[glthread->next]);
 }
 
 /**
@@ -211,6 +308,7 @@ _mesa_glthread_finish(struct gl_context *ctx)
       struct _glapi_table *dispatch = _glapi_get_dispatch();
       glthread_unmarshal_batch(next, 0);
       _glapi_set_dispatch(dispatch);
+      glthread_recycle_batch(glthread, next);
 
       /* It's not a sync because we don't enqueue partial batches, but
        * it would be a sync if we did. So count it anyway.
@@ -24,7 +24,8 @@
 #ifndef _GLTHREAD_H
 #define _GLTHREAD_H
 
-/* The size of one batch and the maximum size of one call.
+/* The size of one batch and the maximum size of one call that shares a
+ * batch with other calls.
  *
  * This should be as low as possible, so that:
  * - multiple synchronizations within a frame don't slow us down much
@@ -35,6 +36,15 @@
  */
 #define MARSHAL_MAX_CMD_SIZE (8 * 1024)
 
+/* The maximum size of one call.
+ *
+ * Larger calls get a batch of their own, with a buffer from a pool of
+ * recycled buffers (see _mesa_glthread_reserve_large_command()).  Beyond
+ * this size, copying the data costs more than synchronizing, and the pool
+ * would hold on to too much memory.
+ */
+#define MARSHAL_MAX_LARGE_CMD_SIZE (4 * 1024 * 1024)
+
 /* The number of batch slots in memory.
  *
  * One batch is being executed, one batch is being filled, the rest are
@@ -46,6 +56,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include "util/u_queue.h"
+#include "compiler/shader_enums.h"
 
 enum marshal_dispatch_cmd_id;
 struct gl_context;
@@ -62,8 +73,60 @@ struct glthread_batch
    /** Amount of data used by batch commands, in bytes. */
    size_t used;
 
-   /** Data contained in the command buffer. */
-   uint8_t buffer[MARSHAL_MAX_CMD_SIZE];
+   /** Size of the command buffer, in bytes. */
+   size_t size;
+
+   /**
+    * Data contained in the command buffer.  This is inline_buffer, unless
+    * the batch holds a single large command.
+    */
+   uint8_t *buffer;
+
+   uint8_t inline_buffer[MARSHAL_MAX_CMD_SIZE];
+};
+
+/** A buffer for large commands that isn't used by any batch. */
+struct glthread_spare_buffer
+{
+   uint8_t *buffer;
+   size_t size;
+};
+
+/**
+ * Pieces of GL state mirrored on the main thread, so that querying them
+ * doesn't need to synchronize with the worker thread.
+ */
+enum glthread_shadow
+{
+   GLTHREAD_SHADOW_ACTIVE_TEXTURE,
+   GLTHREAD_SHADOW_MATRIX_MODE,
+   GLTHREAD_SHADOW_ARRAY_BUFFER,
+   GLTHREAD_SHADOW_VIEWPORT,
+   GLTHREAD_SHADOW_BLEND,
+   GLTHREAD_SHADOW_CULL_FACE,
+   GLTHREAD_SHADOW_DEPTH_TEST,
+   GLTHREAD_SHADOW_SCISSOR_TEST,
+   GLTHREAD_SHADOW_STENCIL_TEST,
+   GLTHREAD_SHADOW_PRIMITIVE_RESTART,
+   GLTHREAD_SHADOW_COUNT,
+};
+
+#define GLTHREAD_SHADOW_ALL ((1u << GLTHREAD_SHADOW_COUNT) - 1)
+
+/**
+ * Main-thread view of one vertex array of the default vertex array object,
+ * used to copy client memory at draw time.
+ */
+struct glthread_attrib
+{
+   /** Client memory, or an offset if a VBO is bound. */
+   const void *Pointer;
+
+   /** Distance between elements in bytes, never 0. */
+   unsigned Stride;
+
+   /** Size of one element in bytes. */
+   unsigned ElementSize;
 };
 
 struct glthread_state
@@ -83,6 +146,13 @@ struct glthread_state
    /** Index of the batch being filled and about to be submitted. */
    unsigned next;
 
+   /**
+    * Recycled buffers for large commands, so that a stream of them doesn't
+    * allocate and fault in new memory every time.  Only the main thread
+    * touches this.  Unused entries have a NULL buffer.
+    */
+   struct glthread_spare_buffer spare_buffers[MARSHAL_MAX_BATCHES];
+
    /**
     * Tracks on the main thread side whether the current vertex array binding
     * is in a VBO.
@@ -94,6 +164,61 @@ struct glthread_state
     * buffer) binding is in a VBO.
     */
    bool element_array_is_vbo;
+
+   /**
+    * Whether a glBegin() has been marshalled without a matching glEnd().
+    * Nearly everything generates GL_INVALID_OPERATION in there, so queries
+    * always go to the worker thread and setters invalidate the shadow state.
+    */
+   bool inside_begin_end;
+
+   /**
+    * Bitmask of (1 << GLTHREAD_SHADOW_*) for the shadow state below that
+    * matches what the worker thread will see once the queue drains.
+    *
+    * Everything starts out invalid.  Setters that we can mirror exactly
+    * update the value, anything else clears the bit, and the next query of
+    * an invalid value synchronizes and reloads all of it from the context.
+    */
+   unsigned shadow_valid;
+
+   /** Shadow state, see shadow_valid. */
+   unsigned ActiveTexture;        /**< Texture unit index, not GL_TEXTUREn */
+   unsigned MatrixMode;           /**< GLenum */
+   unsigned ArrayBufferBinding;
+   float Viewport[4];             /**< x, y, width, height of viewport 0 */
+   unsigned EnabledCaps;          /**< Bitmask of GLTHREAD_SHADOW_<cap> */
+   bool PrimitiveRestart;
+   bool PrimitiveRestartFixedIndex;
+   unsigned RestartIndex;
+
+   /**
+    * Whether the vertex array state below matches the default VAO, as seen
+    * by the worker thread once the queue drains.  Only used outside of core
+    * profiles, which don't have client arrays.
+    *
+    * Setters that aren't mirrored clear this, and the next draw call
+    * synchronizes and reloads everything from the VAO.
+    */
+   bool arrays_valid;
+
+   /** The texture unit selected by glClientActiveTexture(). */
+   unsigned ClientActiveTexture;
+
+   /** VERT_BIT_* masks of enabled arrays and of arrays in client memory. */
+   uint32_t EnabledArrays;
+   uint32_t UserArrays;
+
+   /**
+    * Arrays that glthread doesn't copy on its own: instanced arrays (indexed
+    * by the binding, which is also the attrib's default binding), and arrays
+    * using other ARB_vertex_attrib_binding bindings.  Draws using any of
+    * them in client memory are executed synchronously.
+    */
+   uint32_t InstancedArrays;
+   uint32_t RemappedArrays;
+
+   struct glthread_attrib Attribs[VERT_ATTRIB_MAX];
 };
 
 void _mesa_glthread_init(struct gl_context *ctx);
@@ -101,6 +226,8 @@ void _mesa_glthread_destroy(struct gl_context *ctx);
 
 void _mesa_glthread_restore_dispatch(struct gl_context *ctx, const char *func);
 void _mesa_glthread_flush_batch(struct gl_context *ctx);
+bool _mesa_glthread_reserve_large_command(struct gl_context *ctx,
+                                          size_t size);
 void _mesa_glthread_finish(struct gl_context *ctx);
 
 #endif /* _GLTHREAD_H*/
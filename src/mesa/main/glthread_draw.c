@@ -0,0 +1,532 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** \file glthread_draw.c
+ *
+ * Marshalling of the common draw calls with vertex arrays and indices in
+ * client memory.
+ *
+ * The application may change client memory as soon as the draw call
+ * returns, so the main thread computes the range of vertices the draw uses
+ * (scanning the indices if needed), and copies that range of each enabled
+ * client array, as well as the indices, into the command.  The worker
+ * thread then temporarily points the arrays at the copies.
+ *
+ * Anything we can't copy (instanced arrays, indices in a buffer object
+ * without a known range, ...) still executes the draw synchronously, but
+ * unlike before, glthread stays enabled.
+ */
+
+#include "main/glthread.h"
+#include "main/marshal.h"
+#include "main/dispatch.h"
+#include "main/bufferobj.h"
+#include "main/varray.h"
+#include "main/marshal_generated.h"
+#include "util/bitscan.h"
+
+/** One client array copied by the main thread. */
+struct glthread_upload
+{
+   /** The array pointer set by the application. */
+   const void *original;
+
+   /** The pointer the worker thread uses instead, pointing at the copy. */
+   const void *pointer;
+
+   gl_vert_attrib attrib;
+};
+
+/** Shared by all draw calls marshalled in this file. */
+struct marshal_cmd_Draw
+{
+   struct marshal_cmd_base cmd_base;
+   GLenum mode;
+   GLenum type;
+   GLint first;
+   GLsizei count;
+   GLuint start;
+   GLuint end;
+   GLint basevertex;
+   const GLvoid *indices;
+   unsigned num_uploads;
+   /* Followed by struct glthread_upload uploads[num_uploads], then the
+    * copies.
+    */
+};
+
+static void
+execute_draw(struct gl_context *ctx, const struct marshal_cmd_Draw *draw)
+{
+   const GLenum mode = draw->mode;
+   const GLenum type = draw->type;
+   const GLsizei count = draw->count;
+   const GLvoid *indices = draw->indices;
+
+   switch (draw->cmd_base.cmd_id) {
+   case DISPATCH_CMD_DrawArrays:
+      CALL_DrawArrays(ctx->CurrentServerDispatch,
+                      (mode, draw->first, count));
+      break;
+   case DISPATCH_CMD_DrawElements:
+      CALL_DrawElements(ctx->CurrentServerDispatch,
+                        (mode, count, type, indices));
+      break;
+   case DISPATCH_CMD_DrawRangeElements:
+      CALL_DrawRangeElements(ctx->CurrentServerDispatch,
+                             (mode, draw->start, draw->end, count, type,
+                              indices));
+      break;
+   case DISPATCH_CMD_DrawElementsBaseVertex:
+      CALL_DrawElementsBaseVertex(ctx->CurrentServerDispatch,
+                                  (mode, count, type, indices,
+                                   draw->basevertex));
+      break;
+   case DISPATCH_CMD_DrawRangeElementsBaseVertex:
+      CALL_DrawRangeElementsBaseVertex(ctx->CurrentServerDispatch,
+                                       (mode, draw->start, draw->end, count,
+                                        type, indices, draw->basevertex));
+      break;
+   default:
+      unreachable("not a draw command");
+   }
+}
+
+/**
+ * Drain the queue and reload everything the main thread tracks, so that the
+ * following draw calls don't have to synchronize again.
+ */
+static void
+sync_and_reload(struct gl_context *ctx)
+{
+   _mesa_glthread_finish(ctx);
+   _mesa_glthread_reload_arrays(ctx);
+   if (!ctx->GLThread->inside_begin_end)
+      _mesa_glthread_reload_shadow(ctx);
+}
+
+/**
+ * Whether a draw call that glthread doesn't copy client memory for must be
+ * executed synchronously.
+ */
+bool
+_mesa_glthread_draw_needs_sync(struct gl_context *ctx, bool indexed)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (ctx->API == API_OPENGL_CORE)
+      return false;
+
+   if (!glthread->arrays_valid)
+      sync_and_reload(ctx);
+
+   return (glthread->EnabledArrays & glthread->UserArrays) ||
+          (indexed && _mesa_glthread_is_non_vbo_draw_elements(ctx));
+}
+
+static unsigned
+get_index_size(GLenum type)
+{
+   switch (type) {
+   case GL_UNSIGNED_BYTE:
+      return 1;
+   case GL_UNSIGNED_SHORT:
+      return 2;
+   case GL_UNSIGNED_INT:
+      return 4;
+   default:
+      return 0;
+   }
+}
+
+#define MINMAX_INDEX(T)                                              \
+   do {                                                              \
+      const T *ind = (const T *) indices;                            \
+      for (unsigned i = 0; i < count; i++) {                         \
+         if (restart && ind[i] == restart_index)                     \
+            continue;                                                \
+         *min_index = MIN2(*min_index, ind[i]);                      \
+         *max_index = MAX2(*max_index, ind[i]);                      \
+      }                                                              \
+   } while (0)
+
+/**
+ * Compute the range of client memory indices refer to, ignoring the
+ * primitive restart index.  If all indices are restart indices,
+ * \p min_index ends up greater than \p max_index.
+ */
+static void
+get_minmax_index(const struct glthread_state *glthread,
+                 const GLvoid *indices, unsigned count, unsigned index_size,
+                 unsigned *min_index, unsigned *max_index)
+{
+   const bool restart = glthread->PrimitiveRestart ||
+                        glthread->PrimitiveRestartFixedIndex;
+   const unsigned restart_index = glthread->PrimitiveRestartFixedIndex ?
+      0xffffffffu >> 8 * (4 - index_size) : glthread->RestartIndex;
+
+   *min_index = ~0u;
+   *max_index = 0;
+
+   switch (index_size) {
+   case 1:
+      MINMAX_INDEX(GLubyte);
+      break;
+   case 2:
+      MINMAX_INDEX(GLushort);
+      break;
+   case 4:
+      MINMAX_INDEX(GLuint);
+      break;
+   default:
+      unreachable("invalid index size");
+   }
+}
+
+#undef MINMAX_INDEX
+
+static void
+draw_sync(struct gl_context *ctx, const struct marshal_cmd_Draw *draw)
+{
+   sync_and_reload(ctx);
+   debug_print_sync_fallback("Draw");
+   execute_draw(ctx, draw);
+}
+
+/**
+ * Queue \p draw, copying the client memory it uses.  The caller only fills
+ * in the draw parameters.
+ */
+static void
+marshal_draw(struct gl_context *ctx, const struct marshal_cmd_Draw *draw)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const unsigned cmd_id = draw->cmd_base.cmd_id;
+   const bool indexed = cmd_id != DISPATCH_CMD_DrawArrays;
+   const bool has_range = cmd_id == DISPATCH_CMD_DrawRangeElements ||
+                          cmd_id == DISPATCH_CMD_DrawRangeElementsBaseVertex;
+   const unsigned index_size = indexed ? get_index_size(draw->type) : 0;
+   uint32_t user_arrays = 0;
+   bool user_indices = false;
+
+   /* Only compatibility and ES contexts have client memory.  Draw calls
+    * that generate errors don't read any memory either.
+    */
+   if (ctx->API != API_OPENGL_CORE && draw->count > 0 &&
+       !glthread->inside_begin_end && (!indexed || index_size)) {
+      if (!glthread->arrays_valid)
+         sync_and_reload(ctx);
+
+      user_arrays = glthread->EnabledArrays & glthread->UserArrays;
+      user_indices = indexed && !glthread->element_array_is_vbo;
+   }
+
+   /* Arrays that were never set have a NULL pointer and can't be read. */
+   uint32_t mask = user_arrays;
+   while (mask) {
+      const int i = u_bit_scan(&mask);
+
+      if (!glthread->Attribs[i].Pointer)
+         user_arrays &= ~VERT_BIT(i);
+   }
+
+   /* Find the range of vertices to copy. */
+   int64_t start_vertex = 0;
+   uint64_t num_vertices = 0;
+
+   if (user_arrays) {
+      if (user_arrays & (glthread->InstancedArrays |
+                         glthread->RemappedArrays)) {
+         draw_sync(ctx, draw);
+         return;
+      }
+
+      if (!indexed) {
+         start_vertex = draw->first;
+         num_vertices = draw->count;
+      } else {
+         unsigned min_index, max_index;
+
+         if (user_indices) {
+            if (!(glthread->shadow_valid &
+                  (1u << GLTHREAD_SHADOW_PRIMITIVE_RESTART)))
+               sync_and_reload(ctx);
+
+            get_minmax_index(glthread, draw->indices, draw->count,
+                             index_size, &min_index, &max_index);
+         } else if (has_range) {
+            min_index = draw->start;
+            max_index = draw->end;
+         } else {
+            /* We can't look at indices in a buffer object. */
+            draw_sync(ctx, draw);
+            return;
+         }
+
+         start_vertex = (int64_t) min_index + draw->basevertex;
+         if (min_index <= max_index)
+            num_vertices = (uint64_t) max_index - min_index + 1;
+      }
+
+      if (!num_vertices || start_vertex < 0) {
+         /* Nothing is read, or this is an error. */
+         user_arrays = 0;
+      }
+   }
+
+   /* Compute the size of the copies. */
+   unsigned num_uploads = 0;
+   uint64_t upload_size = 0;
+
+   mask = user_arrays;
+   while (mask) {
+      const struct glthread_attrib *attrib =
+         &glthread->Attribs[u_bit_scan(&mask)];
+
+      upload_size += ALIGN((num_vertices - 1) * attrib->Stride +
+                           attrib->ElementSize, 8);
+      num_uploads++;
+   }
+   if (user_indices)
+      upload_size += ALIGN((uint64_t) draw->count * index_size, 8);
+
+   /* Copying this much costs more than synchronizing. */
+   if (upload_size > MARSHAL_MAX_LARGE_CMD_SIZE) {
+      draw_sync(ctx, draw);
+      return;
+   }
+
+   const size_t cmd_size = sizeof(struct marshal_cmd_Draw) +
+                           num_uploads * sizeof(struct glthread_upload) +
+                           upload_size;
+
+   if (!_mesa_glthread_reserve_command(ctx, cmd_size)) {
+      draw_sync(ctx, draw);
+      return;
+   }
+
+   struct marshal_cmd_Draw *cmd =
+      _mesa_glthread_allocate_command(ctx, cmd_id, cmd_size);
+   struct glthread_upload *uploads = (struct glthread_upload *) (cmd + 1);
+   uint8_t *data = (uint8_t *) (uploads + num_uploads);
+
+   memcpy((uint8_t *) cmd + sizeof(cmd->cmd_base),
+          (const uint8_t *) draw + sizeof(draw->cmd_base),
+          sizeof(*cmd) - sizeof(cmd->cmd_base));
+   cmd->num_uploads = num_uploads;
+
+   mask = user_arrays;
+   while (mask) {
+      const gl_vert_attrib i = u_bit_scan(&mask);
+      const struct glthread_attrib *attrib = &glthread->Attribs[i];
+      const size_t offset = start_vertex * attrib->Stride;
+      const size_t size = (num_vertices - 1) * attrib->Stride +
+                          attrib->ElementSize;
+
+      memcpy(data, (const uint8_t *) attrib->Pointer + offset, size);
+      uploads->original = attrib->Pointer;
+      uploads->pointer = (const void *) ((uintptr_t) data - offset);
+      uploads->attrib = i;
+      uploads++;
+      data += ALIGN(size, 8);
+   }
+
+   if (user_indices) {
+      memcpy(data, draw->indices, (size_t) draw->count * index_size);
+      cmd->indices = data;
+   }
+
+   _mesa_post_marshal_hook(ctx);
+}
+
+static void
+set_user_array(struct gl_context *ctx, struct gl_vertex_array_object *vao,
+               gl_vert_attrib attrib, const void *pointer)
+{
+   vao->VertexAttrib[attrib].Ptr = pointer;
+   _mesa_bind_vertex_buffer(ctx, vao, attrib, ctx->Shared->NullBufferObj,
+                            (GLintptr) pointer,
+                            vao->BufferBinding[attrib].Stride);
+}
+
+static void
+unmarshal_draw(struct gl_context *ctx, const struct marshal_cmd_Draw *cmd)
+{
+   const struct glthread_upload *uploads =
+      (const struct glthread_upload *) (cmd + 1);
+   struct gl_vertex_array_object *vao = ctx->Array.VAO;
+   GLbitfield redirected = 0;
+
+   /* Skip arrays that the GL state doesn't agree about, which happens when
+    * a pointer setter generated an error that the main thread didn't see
+    * coming.
+    */
+   for (unsigned i = 0; i < cmd->num_uploads; i++) {
+      const gl_vert_attrib attrib = uploads[i].attrib;
+      const struct gl_array_attributes *array = &vao->VertexAttrib[attrib];
+
+      if (vao != ctx->Array.DefaultVAO ||
+          array->BufferBindingIndex != attrib ||
+          _mesa_is_bufferobj(vao->BufferBinding[attrib].BufferObj) ||
+          array->Ptr != uploads[i].original)
+         continue;
+
+      set_user_array(ctx, vao, attrib, uploads[i].pointer);
+      redirected |= 1u << i;
+   }
+
+   execute_draw(ctx, cmd);
+
+   while (redirected) {
+      const int i = u_bit_scan(&redirected);
+
+      set_user_array(ctx, vao, uploads[i].attrib, uploads[i].original);
+   }
+}
+
+void
+_mesa_unmarshal_DrawArrays(struct gl_context *ctx,
+                           const struct marshal_cmd_DrawArrays *cmd)
+{
+   unmarshal_draw(ctx, cmd);
+}
+
+void
+_mesa_unmarshal_DrawElements(struct gl_context *ctx,
+                             const struct marshal_cmd_DrawElements *cmd)
+{
+   unmarshal_draw(ctx, cmd);
+}
+
+void
+_mesa_unmarshal_DrawRangeElements(struct gl_context *ctx,
+                                  const struct marshal_cmd_DrawRangeElements *cmd)
+{
+   unmarshal_draw(ctx, cmd);
+}
+
+void
+_mesa_unmarshal_DrawElementsBaseVertex(struct gl_context *ctx,
+                                       const struct marshal_cmd_DrawElementsBaseVertex *cmd)
+{
+   unmarshal_draw(ctx, cmd);
+}
+
+void
+_mesa_unmarshal_DrawRangeElementsBaseVertex(struct gl_context *ctx,
+                                            const struct marshal_cmd_DrawRangeElementsBaseVertex *cmd)
+{
+   unmarshal_draw(ctx, cmd);
+}
+
+void GLAPIENTRY
+_mesa_marshal_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct marshal_cmd_Draw draw = {
+      .cmd_base.cmd_id = DISPATCH_CMD_DrawArrays,
+      .mode = mode,
+      .first = first,
+      .count = count,
+   };
+
+   debug_print_marshal("DrawArrays");
+   marshal_draw(ctx, &draw);
+}
+
+void GLAPIENTRY
+_mesa_marshal_DrawElements(GLenum mode, GLsizei count, GLenum type,
+                           const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct marshal_cmd_Draw draw = {
+      .cmd_base.cmd_id = DISPATCH_CMD_DrawElements,
+      .mode = mode,
+      .count = count,
+      .type = type,
+      .indices = indices,
+   };
+
+   debug_print_marshal("DrawElements");
+   marshal_draw(ctx, &draw);
+}
+
+void GLAPIENTRY
+_mesa_marshal_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                                GLsizei count, GLenum type,
+                                const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct marshal_cmd_Draw draw = {
+      .cmd_base.cmd_id = DISPATCH_CMD_DrawRangeElements,
+      .mode = mode,
+      .start = start,
+      .end = end,
+      .count = count,
+      .type = type,
+      .indices = indices,
+   };
+
+   debug_print_marshal("DrawRangeElements");
+   marshal_draw(ctx, &draw);
+}
+
+void GLAPIENTRY
+_mesa_marshal_DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                     const GLvoid *indices, GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct marshal_cmd_Draw draw = {
+      .cmd_base.cmd_id = DISPATCH_CMD_DrawElementsBaseVertex,
+      .mode = mode,
+      .count = count,
+      .type = type,
+      .indices = indices,
+      .basevertex = basevertex,
+   };
+
+   debug_print_marshal("DrawElementsBaseVertex");
+   marshal_draw(ctx, &draw);
+}
+
+void GLAPIENTRY
+_mesa_marshal_DrawRangeElementsBaseVertex(GLenum mode, GLuint start,
+                                          GLuint end, GLsizei count,
+                                          GLenum type, const GLvoid *indices,
+                                          GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct marshal_cmd_Draw draw = {
+      .cmd_base.cmd_id = DISPATCH_CMD_DrawRangeElementsBaseVertex,
+      .mode = mode,
+      .start = start,
+      .end = end,
+      .count = count,
+      .type = type,
+      .indices = indices,
+      .basevertex = basevertex,
+   };
+
+   debug_print_marshal("DrawRangeElementsBaseVertex");
+   marshal_draw(ctx, &draw);
+}
@@ -0,0 +1,453 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** \file glthread_get.c
+ *
+ * Answering glGet*() and glIsEnabled() on the main thread.
+ *
+ * Middleware and engines like to query state they have just set, and every
+ * such query used to drain the whole glthread queue.  For a handful of
+ * commonly queried values, the marshalling side of the setters mirrors the
+ * new value into glthread_state, and the queries below return it without
+ * synchronizing.  Everything else, and any value that isn't known exactly
+ * (see glthread_state::shadow_valid), still takes the synchronous path.
+ *
+ * glGetError() is deliberately not handled here: errors are generated by the
+ * worker thread, including GL_OUT_OF_MEMORY which no main-thread validation
+ * can predict, so it always has to synchronize.
+ */
+
+#include "main/glthread.h"
+#include "main/marshal.h"
+#include "main/dispatch.h"
+#include "main/texstate.h"
+
+static unsigned
+cap_to_shadow(GLenum cap)
+{
+   switch (cap) {
+   case GL_BLEND:
+      return GLTHREAD_SHADOW_BLEND;
+   case GL_CULL_FACE:
+      return GLTHREAD_SHADOW_CULL_FACE;
+   case GL_DEPTH_TEST:
+      return GLTHREAD_SHADOW_DEPTH_TEST;
+   case GL_SCISSOR_TEST:
+      return GLTHREAD_SHADOW_SCISSOR_TEST;
+   case GL_STENCIL_TEST:
+      return GLTHREAD_SHADOW_STENCIL_TEST;
+   default:
+      return GLTHREAD_SHADOW_COUNT;
+   }
+}
+
+static inline bool
+shadow_is_valid(const struct glthread_state *glthread, unsigned shadow)
+{
+   return !glthread->inside_begin_end &&
+          (glthread->shadow_valid & (1u << shadow));
+}
+
+static inline void
+shadow_set_valid(struct glthread_state *glthread, unsigned shadow)
+{
+   glthread->shadow_valid |= 1u << shadow;
+}
+
+static inline void
+shadow_invalidate(struct glthread_state *glthread, unsigned shadow)
+{
+   glthread->shadow_valid &= ~(1u << shadow);
+}
+
+/**
+ * Reload all shadow state from the context.  Only valid right after
+ * _mesa_glthread_finish(), when the worker thread is idle.
+ */
+void
+_mesa_glthread_reload_shadow(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   glthread->ActiveTexture = ctx->Texture.CurrentUnit;
+   glthread->MatrixMode = ctx->Transform.MatrixMode;
+   glthread->ArrayBufferBinding = ctx->Array.ArrayBufferObj->Name;
+   glthread->Viewport[0] = ctx->ViewportArray[0].X;
+   glthread->Viewport[1] = ctx->ViewportArray[0].Y;
+   glthread->Viewport[2] = ctx->ViewportArray[0].Width;
+   glthread->Viewport[3] = ctx->ViewportArray[0].Height;
+
+   glthread->EnabledCaps = 0;
+   if (ctx->Color.BlendEnabled & 1)
+      glthread->EnabledCaps |= 1u << GLTHREAD_SHADOW_BLEND;
+   if (ctx->Polygon.CullFlag)
+      glthread->EnabledCaps |= 1u << GLTHREAD_SHADOW_CULL_FACE;
+   if (ctx->Depth.Test)
+      glthread->EnabledCaps |= 1u << GLTHREAD_SHADOW_DEPTH_TEST;
+   if (ctx->Scissor.EnableFlags & 1)
+      glthread->EnabledCaps |= 1u << GLTHREAD_SHADOW_SCISSOR_TEST;
+   if (ctx->Stencil.Enabled)
+      glthread->EnabledCaps |= 1u << GLTHREAD_SHADOW_STENCIL_TEST;
+
+   glthread->PrimitiveRestart = ctx->Array.PrimitiveRestart;
+   glthread->PrimitiveRestartFixedIndex = ctx->Array.PrimitiveRestartFixedIndex;
+   glthread->RestartIndex = ctx->Array.RestartIndex;
+
+   glthread->shadow_valid = GLTHREAD_SHADOW_ALL;
+}
+
+/** Synchronize with the worker thread before running a query there. */
+static void
+sync_for_query(struct gl_context *ctx, const char *func)
+{
+   _mesa_glthread_finish(ctx);
+   debug_print_sync(func);
+
+   /* The queue is empty now, so take the opportunity to make the next
+    * queries cheap.  Inside glBegin/glEnd, the query itself will fail and
+    * the shadow state isn't used anyway.
+    */
+   if (!ctx->GLThread->inside_begin_end)
+      _mesa_glthread_reload_shadow(ctx);
+}
+
+/* Setters, called by the marshalling code after queueing the command. */
+
+void
+_mesa_glthread_invalidate_shadow(struct gl_context *ctx)
+{
+   ctx->GLThread->shadow_valid = 0;
+}
+
+void
+_mesa_glthread_Begin(struct gl_context *ctx)
+{
+   ctx->GLThread->inside_begin_end = true;
+}
+
+void
+_mesa_glthread_End(struct gl_context *ctx)
+{
+   ctx->GLThread->inside_begin_end = false;
+}
+
+void
+_mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const GLuint unit = texture - GL_TEXTURE0;
+
+   if (glthread->inside_begin_end) {
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_ACTIVE_TEXTURE);
+      return;
+   }
+
+   /* An invalid unit generates an error and doesn't change anything. */
+   if (unit < _mesa_max_tex_unit(ctx)) {
+      glthread->ActiveTexture = unit;
+      shadow_set_valid(glthread, GLTHREAD_SHADOW_ACTIVE_TEXTURE);
+   }
+}
+
+void
+_mesa_glthread_MatrixMode(struct gl_context *ctx, GLenum mode)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* glMatrixMode() doesn't exist in the other APIs and is a no-op there. */
+   if (ctx->API != API_OPENGL_COMPAT && ctx->API != API_OPENGLES)
+      return;
+
+   /* Only the modes that are always valid are tracked.  The others depend
+    * on extensions and texture unit limits.
+    */
+   if (!glthread->inside_begin_end &&
+       (mode == GL_MODELVIEW || mode == GL_PROJECTION || mode == GL_TEXTURE)) {
+      glthread->MatrixMode = mode;
+      shadow_set_valid(glthread, GLTHREAD_SHADOW_MATRIX_MODE);
+   } else {
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_MATRIX_MODE);
+   }
+}
+
+void
+_mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                        GLsizei width, GLsizei height)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread->inside_begin_end) {
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_VIEWPORT);
+      return;
+   }
+
+   /* Negative sizes generate an error and don't change anything. */
+   if (width < 0 || height < 0)
+      return;
+
+   /* This must match clamp_viewport() in viewport.c. */
+   float fx = x, fy = y;
+   float fw = MIN2((float) width, (float) ctx->Const.MaxViewportWidth);
+   float fh = MIN2((float) height, (float) ctx->Const.MaxViewportHeight);
+
+   if (_mesa_has_ARB_viewport_array(ctx) ||
+       _mesa_has_OES_viewport_array(ctx)) {
+      fx = CLAMP(fx, ctx->Const.ViewportBounds.Min,
+                 ctx->Const.ViewportBounds.Max);
+      fy = CLAMP(fy, ctx->Const.ViewportBounds.Min,
+                 ctx->Const.ViewportBounds.Max);
+   }
+
+   glthread->Viewport[0] = fx;
+   glthread->Viewport[1] = fy;
+   glthread->Viewport[2] = fw;
+   glthread->Viewport[3] = fh;
+   shadow_set_valid(glthread, GLTHREAD_SHADOW_VIEWPORT);
+}
+
+void
+_mesa_glthread_ViewportIndexed(struct gl_context *ctx, GLuint first)
+{
+   /* Only viewport 0 is mirrored, and the indexed setters aren't worth
+    * validating on this side.
+    */
+   shadow_invalidate(ctx->GLThread, GLTHREAD_SHADOW_VIEWPORT);
+}
+
+void
+_mesa_glthread_Enable(struct gl_context *ctx, GLenum cap, bool state)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const unsigned shadow = cap_to_shadow(cap);
+
+   if (cap == GL_PRIMITIVE_RESTART ||
+       cap == GL_PRIMITIVE_RESTART_FIXED_INDEX) {
+      /* Which of these exist depends on the API version. */
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_PRIMITIVE_RESTART);
+      return;
+   }
+
+   if (shadow == GLTHREAD_SHADOW_COUNT)
+      return;
+
+   if (glthread->inside_begin_end) {
+      shadow_invalidate(glthread, shadow);
+      return;
+   }
+
+   if (state)
+      glthread->EnabledCaps |= 1u << shadow;
+   else
+      glthread->EnabledCaps &= ~(1u << shadow);
+   shadow_set_valid(glthread, shadow);
+}
+
+void
+_mesa_glthread_Enablei(struct gl_context *ctx, GLenum cap)
+{
+   const unsigned shadow = cap_to_shadow(cap);
+
+   /* glIsEnabled() returns the state of index 0, which may have changed. */
+   if (shadow != GLTHREAD_SHADOW_COUNT)
+      shadow_invalidate(ctx->GLThread, shadow);
+}
+
+void
+_mesa_glthread_PrimitiveRestartIndex(struct gl_context *ctx, GLuint index)
+{
+   /* This doesn't exist in all APIs, so don't try to mirror it.  Apps
+    * rarely change it anyway.
+    */
+   shadow_invalidate(ctx->GLThread, GLTHREAD_SHADOW_PRIMITIVE_RESTART);
+}
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (target != GL_ARRAY_BUFFER)
+      return;
+
+   /* In core profiles, binding a name that wasn't returned by glGenBuffers()
+    * is an error, which we can't detect here.  The other APIs create the
+    * buffer object on the fly.
+    */
+   if (glthread->inside_begin_end ||
+       (ctx->API == API_OPENGL_CORE && buffer != 0)) {
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_ARRAY_BUFFER);
+      return;
+   }
+
+   glthread->ArrayBufferBinding = buffer;
+   shadow_set_valid(glthread, GLTHREAD_SHADOW_ARRAY_BUFFER);
+}
+
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread->inside_begin_end) {
+      shadow_invalidate(glthread, GLTHREAD_SHADOW_ARRAY_BUFFER);
+      return;
+   }
+
+   /* Deleting a bound buffer resets the binding to 0. */
+   for (GLsizei i = 0; i < n; i++) {
+      if (buffers[i] && buffers[i] == glthread->ArrayBufferBinding)
+         glthread->ArrayBufferBinding = 0;
+   }
+}
+
+/* Queries. */
+
+/**
+ * Look up \p pname in the shadow state.
+ *
+ * Returns the number of values written to \p ints or \p floats (whichever
+ * matches the type of the state), or 0 if the query must be synchronous.
+ */
+static unsigned
+get_shadow(struct gl_context *ctx, GLenum pname, GLint *ints, GLfloat *floats)
+{
+   const struct glthread_state *glthread = ctx->GLThread;
+
+   switch (pname) {
+   case GL_ACTIVE_TEXTURE:
+      if (!shadow_is_valid(glthread, GLTHREAD_SHADOW_ACTIVE_TEXTURE))
+         return 0;
+      ints[0] = GL_TEXTURE0 + glthread->ActiveTexture;
+      return 1;
+
+   case GL_MATRIX_MODE:
+      /* Not a valid query in core profiles and GLES2; let the real
+       * glGetIntegerv() raise the error.
+       */
+      if ((ctx->API != API_OPENGL_COMPAT && ctx->API != API_OPENGLES) ||
+          !shadow_is_valid(glthread, GLTHREAD_SHADOW_MATRIX_MODE))
+         return 0;
+      ints[0] = glthread->MatrixMode;
+      return 1;
+
+   case GL_ARRAY_BUFFER_BINDING:
+      if (!shadow_is_valid(glthread, GLTHREAD_SHADOW_ARRAY_BUFFER))
+         return 0;
+      ints[0] = glthread->ArrayBufferBinding;
+      return 1;
+
+   case GL_VIEWPORT:
+      if (!shadow_is_valid(glthread, GLTHREAD_SHADOW_VIEWPORT))
+         return 0;
+      memcpy(floats, glthread->Viewport, sizeof(glthread->Viewport));
+      return 4;
+
+   default: {
+      const unsigned shadow = cap_to_shadow(pname);
+
+      if (shadow == GLTHREAD_SHADOW_COUNT ||
+          !shadow_is_valid(glthread, shadow))
+         return 0;
+      ints[0] = !!(glthread->EnabledCaps & (1u << shadow));
+      return 1;
+   }
+   }
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetBooleanv(GLenum pname, GLboolean *params)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   GLint ints[1];
+   GLfloat floats[4];
+   unsigned count = get_shadow(ctx, pname, ints, floats);
+
+   if (count == 1) {
+      params[0] = ints[0] ? GL_TRUE : GL_FALSE;
+      return;
+   } else if (count) {
+      for (unsigned i = 0; i < count; i++)
+         params[i] = floats[i] ? GL_TRUE : GL_FALSE;
+      return;
+   }
+
+   sync_for_query(ctx, "GetBooleanv");
+   CALL_GetBooleanv(ctx->CurrentServerDispatch, (pname, params));
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetIntegerv(GLenum pname, GLint *params)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   GLint ints[1];
+   GLfloat floats[4];
+   unsigned count = get_shadow(ctx, pname, ints, floats);
+
+   if (count == 1) {
+      params[0] = ints[0];
+      return;
+   } else if (count) {
+      for (unsigned i = 0; i < count; i++)
+         params[i] = IROUND(floats[i]);
+      return;
+   }
+
+   sync_for_query(ctx, "GetIntegerv");
+   CALL_GetIntegerv(ctx->CurrentServerDispatch, (pname, params));
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetFloatv(GLenum pname, GLfloat *params)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   GLint ints[1];
+   GLfloat floats[4];
+   unsigned count = get_shadow(ctx, pname, ints, floats);
+
+   if (count == 1) {
+      params[0] = (GLfloat) ints[0];
+      return;
+   } else if (count) {
+      memcpy(params, floats, count * sizeof(GLfloat));
+      return;
+   }
+
+   sync_for_query(ctx, "GetFloatv");
+   CALL_GetFloatv(ctx->CurrentServerDispatch, (pname, params));
+}
+
+GLboolean GLAPIENTRY
+_mesa_marshal_IsEnabled(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct glthread_state *glthread = ctx->GLThread;
+   const unsigned shadow = cap_to_shadow(cap);
+
+   if (shadow != GLTHREAD_SHADOW_COUNT && shadow_is_valid(glthread, shadow))
+      return (glthread->EnabledCaps & (1u << shadow)) ? GL_TRUE : GL_FALSE;
+
+   sync_for_query(ctx, "IsEnabled");
+   return CALL_IsEnabled(ctx->CurrentServerDispatch, (cap));
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** \file glthread_varray.c
+ *
+ * Main-thread tracking of the vertex arrays of the default VAO.
+ *
+ * Draw calls that source vertices from client memory have to copy that
+ * memory before returning to the application.  To do that without
+ * synchronizing, glthread needs to know which arrays are enabled and where
+ * they point.  The common legacy setters are mirrored here exactly; all the
+ * others just invalidate the tracking, which makes the next draw call
+ * synchronize and reload it from the VAO.
+ *
+ * Core profiles have no client arrays and no default VAO, so nothing is
+ * tracked there.  Compatibility and ES contexts disable glthread when a VAO
+ * is bound (see _mesa_glthread_is_compat_bind_vertex_array()), so the
+ * default VAO is the only one we need to care about.
+ */
+
+#include "main/glthread.h"
+#include "main/marshal.h"
+#include "main/bufferobj.h"
+
+void
+_mesa_glthread_invalidate_arrays(struct gl_context *ctx)
+{
+   ctx->GLThread->arrays_valid = false;
+}
+
+/**
+ * Reload the tracked vertex arrays from the VAO.  Only valid right after
+ * _mesa_glthread_finish(), when the worker thread is idle.
+ */
+void
+_mesa_glthread_reload_arrays(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const struct gl_vertex_array_object *vao = ctx->Array.VAO;
+
+   glthread->ClientActiveTexture = ctx->Array.ActiveTexture;
+   glthread->EnabledArrays = vao->Enabled;
+   glthread->UserArrays = 0;
+   glthread->InstancedArrays = 0;
+   glthread->RemappedArrays = 0;
+
+   for (unsigned i = 0; i < VERT_ATTRIB_MAX; i++) {
+      const struct gl_array_attributes *array = &vao->VertexAttrib[i];
+      const struct gl_vertex_buffer_binding *binding =
+         &vao->BufferBinding[array->BufferBindingIndex];
+
+      glthread->Attribs[i].Pointer = array->Ptr;
+      glthread->Attribs[i].Stride = binding->Stride;
+      glthread->Attribs[i].ElementSize = array->Format._ElementSize;
+
+      if (!_mesa_is_bufferobj(binding->BufferObj))
+         glthread->UserArrays |= VERT_BIT(i);
+      if (vao->BufferBinding[i].InstanceDivisor)
+         glthread->InstancedArrays |= VERT_BIT(i);
+      if (array->BufferBindingIndex != i)
+         glthread->RemappedArrays |= VERT_BIT(i);
+   }
+
+   glthread->arrays_valid = vao == ctx->Array.DefaultVAO;
+}
+
+static unsigned
+element_size(GLint size, GLenum type)
+{
+   /* GL_BGRA is only allowed with 4-component types. */
+   if (size == GL_BGRA)
+      size = 4;
+   else if (size < 1 || size > 4)
+      return 0;
+
+   switch (type) {
+   case GL_BYTE:
+   case GL_UNSIGNED_BYTE:
+      return size;
+   case GL_SHORT:
+   case GL_UNSIGNED_SHORT:
+   case GL_HALF_FLOAT:
+   case GL_HALF_FLOAT_OES:
+      return size * 2;
+   case GL_INT:
+   case GL_UNSIGNED_INT:
+   case GL_FLOAT:
+   case GL_FIXED:
+      return size * 4;
+   case GL_DOUBLE:
+      return size * 8;
+   case GL_INT_2_10_10_10_REV:
+   case GL_UNSIGNED_INT_2_10_10_10_REV:
+   case GL_UNSIGNED_INT_10F_11F_11F_REV:
+      return 4;
+   default:
+      return 0;
+   }
+}
+
+/**
+ * Mirror a gl*Pointer() call that set \p attrib.
+ *
+ * The GL implementation validates a lot more than we do here.  If it rejects
+ * a call we accepted, the worker thread notices that the pointer we copied
+ * from isn't the current one and leaves the array alone.
+ */
+void
+_mesa_glthread_AttribPointer(struct gl_context *ctx, gl_vert_attrib attrib,
+                             GLint size, GLenum type, GLsizei stride,
+                             const GLvoid *pointer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const unsigned elem_size = element_size(size, type);
+
+   if (ctx->API == API_OPENGL_CORE)
+      return;
+
+   if (glthread->inside_begin_end || !elem_size) {
+      glthread->arrays_valid = false;
+      return;
+   }
+
+   /* A negative stride is an error and doesn't change anything. */
+   if (stride < 0)
+      return;
+
+   glthread->Attribs[attrib].Pointer = pointer;
+   glthread->Attribs[attrib].Stride = stride ? stride : elem_size;
+   glthread->Attribs[attrib].ElementSize = elem_size;
+
+   /* This also resets the attrib to its own binding. */
+   glthread->RemappedArrays &= ~VERT_BIT(attrib);
+   if (glthread->vertex_array_is_vbo)
+      glthread->UserArrays &= ~VERT_BIT(attrib);
+   else
+      glthread->UserArrays |= VERT_BIT(attrib);
+}
+
+void
+_mesa_glthread_TexCoordPointer(struct gl_context *ctx, GLint size,
+                               GLenum type, GLsizei stride,
+                               const GLvoid *pointer)
+{
+   _mesa_glthread_AttribPointer(ctx,
+                                VERT_ATTRIB_TEX(ctx->GLThread->ClientActiveTexture),
+                                size, type, stride, pointer);
+}
+
+void
+_mesa_glthread_VertexAttribPointer(struct gl_context *ctx, GLuint index,
+                                   GLint size, GLenum type, GLsizei stride,
+                                   const GLvoid *pointer)
+{
+   /* An invalid index is an error and doesn't change anything. */
+   if (index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs)
+      return;
+
+   _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_GENERIC(index),
+                                size, type, stride, pointer);
+}
+
+static void
+set_array_enabled(struct gl_context *ctx, gl_vert_attrib attrib, bool state)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread->inside_begin_end) {
+      glthread->arrays_valid = false;
+      return;
+   }
+
+   if (state)
+      glthread->EnabledArrays |= VERT_BIT(attrib);
+   else
+      glthread->EnabledArrays &= ~VERT_BIT(attrib);
+}
+
+void
+_mesa_glthread_ClientState(struct gl_context *ctx, GLenum cap, bool state)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (ctx->API == API_OPENGL_CORE)
+      return;
+
+   switch (cap) {
+   case GL_VERTEX_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_POS, state);
+      break;
+   case GL_NORMAL_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_NORMAL, state);
+      break;
+   case GL_COLOR_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_COLOR0, state);
+      break;
+   case GL_INDEX_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_COLOR_INDEX, state);
+      break;
+   case GL_TEXTURE_COORD_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_TEX(glthread->ClientActiveTexture),
+                        state);
+      break;
+   case GL_EDGE_FLAG_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_EDGEFLAG, state);
+      break;
+   case GL_FOG_COORDINATE_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_FOG, state);
+      break;
+   case GL_SECONDARY_COLOR_ARRAY:
+      set_array_enabled(ctx, VERT_ATTRIB_COLOR1, state);
+      break;
+   case GL_POINT_SIZE_ARRAY_OES:
+      set_array_enabled(ctx, VERT_ATTRIB_POINT_SIZE, state);
+      break;
+   case GL_PRIMITIVE_RESTART_NV:
+      _mesa_glthread_Enable(ctx, GL_PRIMITIVE_RESTART, state);
+      break;
+   default:
+      /* An invalid enum doesn't change anything. */
+      break;
+   }
+}
+
+void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const GLuint unit = texture - GL_TEXTURE0;
+
+   if (ctx->API == API_OPENGL_CORE)
+      return;
+
+   if (glthread->inside_begin_end) {
+      glthread->arrays_valid = false;
+      return;
+   }
+
+   /* An invalid unit is an error and doesn't change anything. */
+   if (unit < ctx->Const.MaxTextureCoordUnits)
+      glthread->ClientActiveTexture = unit;
+}
+
+void
+_mesa_glthread_VertexAttribArray(struct gl_context *ctx, GLuint index,
+                                 bool state)
+{
+   if (ctx->API == API_OPENGL_CORE ||
+       index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs)
+      return;
+
+   set_array_enabled(ctx, VERT_ATTRIB_GENERIC(index), state);
+}
+
+void
+_mesa_glthread_VertexAttribDivisor(struct gl_context *ctx, GLuint index,
+                                   GLuint divisor)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const gl_vert_attrib attrib = VERT_ATTRIB_GENERIC(index);
+
+   if (ctx->API == API_OPENGL_CORE ||
+       index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs)
+      return;
+
+   if (glthread->inside_begin_end) {
+      glthread->arrays_valid = false;
+      return;
+   }
+
+   /* This also resets the attrib to its own binding. */
+   glthread->RemappedArrays &= ~VERT_BIT(attrib);
+   if (divisor)
+      glthread->InstancedArrays |= VERT_BIT(attrib);
+   else
+      glthread->InstancedArrays &= ~VERT_BIT(attrib);
+}
@@ -94,6 +94,7 @@ _mesa_marshal_Enable(GLenum cap)
       cmd = _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_Enable,
                                             sizeof(*cmd));
       cmd->cap = cap;
+      _mesa_glthread_Enable(ctx, cap, true);
       _mesa_post_marshal_hook(ctx);
       return;
    }
@@ -170,7 +171,7 @@ _mesa_marshal_ShaderSource(GLuint shader, GLsizei count,
       measure_ShaderSource_strings(count, string, length, length_tmp);
    size_t total_cmd_size = fixed_cmd_size + length_size + total_string_length;
 
-   if (total_cmd_size <= MARSHAL_MAX_CMD_SIZE) {
+   if (_mesa_glthread_reserve_command(ctx, total_cmd_size)) {
       struct marshal_cmd_ShaderSource *cmd =
          _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_ShaderSource,
                                          total_cmd_size);
@@ -275,6 +276,7 @@ _mesa_marshal_BindBuffer(GLenum target, GLuint buffer)
    debug_print_marshal("BindBuffer");
 
    track_vbo_binding(ctx, target, buffer);
+   _mesa_glthread_BindBuffer(ctx, target, buffer);
 
    if (cmd_size <= MARSHAL_MAX_CMD_SIZE) {
       cmd = _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_BindBuffer,
@@ -332,7 +334,7 @@ _mesa_marshal_BufferData(GLenum target, GLsizeiptr size, const GLvoid * data,
    }
 
    if (target != GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD &&
-       cmd_size <= MARSHAL_MAX_CMD_SIZE) {
+       _mesa_glthread_reserve_command(ctx, cmd_size)) {
       struct marshal_cmd_BufferData *cmd =
          _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_BufferData,
                                          cmd_size);
@@ -391,7 +393,7 @@ _mesa_marshal_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
    }
 
    if (target != GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD &&
-       cmd_size <= MARSHAL_MAX_CMD_SIZE) {
+       _mesa_glthread_reserve_command(ctx, cmd_size)) {
       struct marshal_cmd_BufferSubData *cmd =
          _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_BufferSubData,
                                          cmd_size);
@@ -451,7 +453,7 @@ _mesa_marshal_NamedBufferData(GLuint buffer, GLsizeiptr size,
       return;
    }
 
-   if (buffer > 0 && cmd_size <= MARSHAL_MAX_CMD_SIZE) {
+   if (buffer > 0 && _mesa_glthread_reserve_command(ctx, cmd_size)) {
       struct marshal_cmd_NamedBufferData *cmd =
          _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_NamedBufferData,
                                          cmd_size);
@@ -508,7 +510,7 @@ _mesa_marshal_NamedBufferSubData(GLuint buffer, GLintptr offset,
       return;
    }
 
-   if (buffer > 0 && cmd_size <= MARSHAL_MAX_CMD_SIZE) {
+   if (buffer > 0 && _mesa_glthread_reserve_command(ctx, cmd_size)) {
       struct marshal_cmd_NamedBufferSubData *cmd =
          _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_NamedBufferSubData,
                                          cmd_size);
@@ -42,11 +42,26 @@ struct marshal_cmd_base
    uint16_t cmd_id;
 
    /**
-    * Size of command, in multiples of 4 bytes, including cmd_base.
+    * Size of command in bytes, including cmd_base, or 0 for a large command
+    * that fills the rest of its batch.
     */
    uint16_t cmd_size;
 };
 
+/**
+ * Make sure that a command of \p size bytes can be allocated.
+ *
+ * Commands larger than MARSHAL_MAX_CMD_SIZE are queued in a batch of their
+ * own.  If this returns false, the command is too large or memory couldn't
+ * be allocated, and the caller should execute it synchronously.
+ */
+static inline bool
+_mesa_glthread_reserve_command(struct gl_context *ctx, size_t size)
+{
+   return size <= MARSHAL_MAX_CMD_SIZE ||
+          _mesa_glthread_reserve_large_command(ctx, size);
+}
+
 static inline void *
 _mesa_glthread_allocate_command(struct gl_context *ctx,
                                 uint16_t cmd_id,
@@ -57,34 +72,28 @@ _mesa_glthread_allocate_command(struct gl_context *ctx,
    struct marshal_cmd_base *cmd_base;
    const size_t aligned_size = ALIGN(size, 8);
 
-   if (unlikely(next->used + size > MARSHAL_MAX_CMD_SIZE)) {
+   if (unlikely(next->used + size > next->size)) {
       _mesa_glthread_flush_batch(ctx);
       next = &glthread->batches[glthread->next];
    }
 
    cmd_base = (struct marshal_cmd_base *)&next->buffer[next->used];
-   next->used += aligned_size;
    cmd_base->cmd_id = cmd_id;
-   cmd_base->cmd_size = aligned_size;
-   return cmd_base;
-}
 
-/**
- * Instead of conditionally handling marshaling previously-bound user vertex
- * array data in draw calls (deprecated and removed in GL core), we just
- * disable threading at the point where the user sets a user vertex array.
- */
-static inline bool
-_mesa_glthread_is_non_vbo_vertex_attrib_pointer(const struct gl_context *ctx)
-{
-   struct glthread_state *glthread = ctx->GLThread;
-
-   return ctx->API != API_OPENGL_CORE && !glthread->vertex_array_is_vbo;
+   if (unlikely(size > MARSHAL_MAX_CMD_SIZE)) {
+      /* Nothing else goes into the batch reserved for a large command. */
+      assert(next->used == 0 && size <= next->size);
+      next->used = next->size;
+      cmd_base->cmd_size = 0;
+   } else {
+      next->used += aligned_size;
+      cmd_base->cmd_size = aligned_size;
+   }
+   return cmd_base;
 }
 
 /**
- * Instead of conditionally handling marshaling immediate index data in draw
- * calls (deprecated and removed in GL core), we just disable threading.
+ * Whether glDrawElements-like calls read their indices from client memory.
  */
 static inline bool
 _mesa_glthread_is_non_vbo_draw_elements(const struct gl_context *ctx)
@@ -174,6 +183,46 @@ _mesa_glthread_is_compat_bind_vertex_array(const struct gl_context *ctx)
    return ctx->API != API_OPENGL_CORE;
 }
 
+void _mesa_glthread_invalidate_shadow(struct gl_context *ctx);
+void _mesa_glthread_Begin(struct gl_context *ctx);
+void _mesa_glthread_End(struct gl_context *ctx);
+void _mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture);
+void _mesa_glthread_MatrixMode(struct gl_context *ctx, GLenum mode);
+void _mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                             GLsizei width, GLsizei height);
+void _mesa_glthread_ViewportIndexed(struct gl_context *ctx, GLuint first);
+void _mesa_glthread_Enable(struct gl_context *ctx, GLenum cap, bool state);
+void _mesa_glthread_Enablei(struct gl_context *ctx, GLenum cap);
+void _mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                               GLuint buffer);
+void _mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *buffers);
+void _mesa_glthread_PrimitiveRestartIndex(struct gl_context *ctx,
+                                          GLuint index);
+void _mesa_glthread_reload_shadow(struct gl_context *ctx);
+
+void _mesa_glthread_invalidate_arrays(struct gl_context *ctx);
+void _mesa_glthread_reload_arrays(struct gl_context *ctx);
+void _mesa_glthread_AttribPointer(struct gl_context *ctx,
+                                  gl_vert_attrib attrib, GLint size,
+                                  GLenum type, GLsizei stride,
+                                  const GLvoid *pointer);
+void _mesa_glthread_TexCoordPointer(struct gl_context *ctx, GLint size,
+                                    GLenum type, GLsizei stride,
+                                    const GLvoid *pointer);
+void _mesa_glthread_VertexAttribPointer(struct gl_context *ctx, GLuint index,
+                                        GLint size, GLenum type,
+                                        GLsizei stride, const GLvoid *pointer);
+void _mesa_glthread_ClientState(struct gl_context *ctx, GLenum cap,
+                                bool state);
+void _mesa_glthread_ClientActiveTexture(struct gl_context *ctx,
+                                        GLenum texture);
+void _mesa_glthread_VertexAttribArray(struct gl_context *ctx, GLuint index,
+                                      bool state);
+void _mesa_glthread_VertexAttribDivisor(struct gl_context *ctx, GLuint index,
+                                        GLuint divisor);
+bool _mesa_glthread_draw_needs_sync(struct gl_context *ctx, bool indexed);
+
 struct marshal_cmd_Enable;
 struct marshal_cmd_ShaderSource;
 struct marshal_cmd_Flush;
@@ -187,6 +236,12 @@ struct marshal_cmd_ClearBuffer;
 #define marshal_cmd_ClearBufferiv   marshal_cmd_ClearBuffer
 #define marshal_cmd_ClearBufferuiv  marshal_cmd_ClearBuffer
 #define marshal_cmd_ClearBufferfi   marshal_cmd_ClearBuffer
+struct marshal_cmd_Draw;
+#define marshal_cmd_DrawArrays                   marshal_cmd_Draw
+#define marshal_cmd_DrawElements                 marshal_cmd_Draw
+#define marshal_cmd_DrawRangeElements            marshal_cmd_Draw
+#define marshal_cmd_DrawElementsBaseVertex       marshal_cmd_Draw
+#define marshal_cmd_DrawRangeElementsBaseVertex  marshal_cmd_Draw
 
 void
 _mesa_unmarshal_Enable(struct gl_context *ctx,
@@ -195,6 +250,60 @@ _mesa_unmarshal_Enable(struct gl_context *ctx,
 void GLAPIENTRY
 _mesa_marshal_Enable(GLenum cap);
 
+void GLAPIENTRY
+_mesa_marshal_GetBooleanv(GLenum pname, GLboolean *params);
+
+void GLAPIENTRY
+_mesa_marshal_GetIntegerv(GLenum pname, GLint *params);
+
+void GLAPIENTRY
+_mesa_marshal_GetFloatv(GLenum pname, GLfloat *params);
+
+GLboolean GLAPIENTRY
+_mesa_marshal_IsEnabled(GLenum cap);
+
+void GLAPIENTRY
+_mesa_marshal_DrawArrays(GLenum mode, GLint first, GLsizei count);
+
+void
+_mesa_unmarshal_DrawArrays(struct gl_context *ctx,
+                           const struct marshal_cmd_DrawArrays *cmd);
+
+void GLAPIENTRY
+_mesa_marshal_DrawElements(GLenum mode, GLsizei count, GLenum type,
+                           const GLvoid *indices);
+
+void
+_mesa_unmarshal_DrawElements(struct gl_context *ctx,
+                             const struct marshal_cmd_DrawElements *cmd);
+
+void GLAPIENTRY
+_mesa_marshal_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                                GLsizei count, GLenum type,
+                                const GLvoid *indices);
+
+void
+_mesa_unmarshal_DrawRangeElements(struct gl_context *ctx,
+                                  const struct marshal_cmd_DrawRangeElements *cmd);
+
+void GLAPIENTRY
+_mesa_marshal_DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                     const GLvoid *indices, GLint basevertex);
+
+void
+_mesa_unmarshal_DrawElementsBaseVertex(struct gl_context *ctx,
+                                       const struct marshal_cmd_DrawElementsBaseVertex *cmd);
+
+void GLAPIENTRY
+_mesa_marshal_DrawRangeElementsBaseVertex(GLenum mode, GLuint start,
+                                          GLuint end, GLsizei count,
+                                          GLenum type, const GLvoid *indices,
+                                          GLint basevertex);
+
+void
+_mesa_unmarshal_DrawRangeElementsBaseVertex(struct gl_context *ctx,
+                                            const struct marshal_cmd_DrawRangeElementsBaseVertex *cmd);
+
 void GLAPIENTRY
 _mesa_marshal_ShaderSource(GLuint shader, GLsizei count,
                            const GLchar * const *string, const GLint *length);
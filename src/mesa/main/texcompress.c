@@ -42,6 +42,9 @@
 #include "texcompress_s3tc.h"
 #include "texcompress_etc.h"
 #include "texcompress_bptc.h"
+#include "util/debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 
 
 /**
@@ -961,3 +964,99 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
       }
    }
 }
+
+
+/** Don't hand less work than this to another thread. */
+#define TEXCOMPRESS_MIN_BLOCKS_PER_JOB 1024
+
+#define TEXCOMPRESS_MAX_JOBS 16
+
+struct texcompress_job {
+   texcompress_rows_func func;
+   void *data;
+   unsigned first_row;
+   unsigned num_rows;
+   struct util_queue_fence fence;
+};
+
+static struct util_queue texcompress_queue;
+static once_flag texcompress_queue_once = ONCE_FLAG_INIT;
+
+static void
+texcompress_queue_init(void)
+{
+   util_cpu_detect();
+
+   /* The calling thread always takes one job itself. */
+   unsigned num_threads =
+      MIN2(util_cpu_caps.nr_cpus, TEXCOMPRESS_MAX_JOBS) - 1;
+   num_threads = MIN2(num_threads,
+                      env_var_as_unsigned("MESA_TEXCOMPRESS_THREADS",
+                                          num_threads));
+   if (num_threads == 0)
+      return;
+
+   /* A failed init leaves the queue uninitialized and we fall back to
+    * processing the image on the calling thread.
+    */
+   util_queue_init(&texcompress_queue, "texcompress", TEXCOMPRESS_MAX_JOBS,
+                   num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+static void
+texcompress_job_execute(void *job, int thread_index)
+{
+   struct texcompress_job *j = (struct texcompress_job *) job;
+
+   j->func(j->data, j->first_row, j->num_rows);
+}
+
+/**
+ * Run \p func over \p num_rows rows of blocks, splitting large images into
+ * ranges of rows that are processed concurrently.
+ *
+ * Used by the software decoders and encoders of compressed formats, which
+ * handle every block independently.  \p func must be safe to call from
+ * several threads at the same time for disjoint ranges.
+ *
+ * \param blocks_per_row  only used to decide whether threads are worth it
+ */
+void
+_mesa_texcompress_run_rows(unsigned num_rows, unsigned blocks_per_row,
+                           texcompress_rows_func func, void *data)
+{
+   uint64_t num_blocks = (uint64_t) num_rows * blocks_per_row;
+   unsigned num_jobs =
+      MIN3(num_blocks / TEXCOMPRESS_MIN_BLOCKS_PER_JOB, num_rows,
+           TEXCOMPRESS_MAX_JOBS);
+
+   if (num_jobs > 1)
+      call_once(&texcompress_queue_once, texcompress_queue_init);
+
+   if (num_jobs <= 1 || !util_queue_is_initialized(&texcompress_queue)) {
+      func(data, 0, num_rows);
+      return;
+   }
+
+   num_jobs = MIN2(num_jobs, texcompress_queue.num_threads + 1);
+
+   struct texcompress_job jobs[TEXCOMPRESS_MAX_JOBS];
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      jobs[i].func = func;
+      jobs[i].data = data;
+      jobs[i].first_row = (uint64_t) num_rows * i / num_jobs;
+      jobs[i].num_rows =
+         (uint64_t) num_rows * (i + 1) / num_jobs - jobs[i].first_row;
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&texcompress_queue, &jobs[i], &jobs[i].fence,
+                         texcompress_job_execute, NULL, 0);
+   }
+
+   func(data, 0, num_rows / num_jobs);
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
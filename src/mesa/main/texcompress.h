@@ -28,6 +28,10 @@
 #include "formats.h"
 #include "glheader.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 
 extern GLenum
@@ -63,4 +67,17 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
                        GLfloat *dest);
 
+
+/** Process \p num_rows rows of blocks, starting at \p first_row. */
+typedef void (*texcompress_rows_func)(void *data, unsigned first_row,
+                                      unsigned num_rows);
+
+extern void
+_mesa_texcompress_run_rows(unsigned num_rows, unsigned blocks_per_row,
+                           texcompress_rows_func func, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* TEXCOMPRESS_H */
@@ -36,6 +36,7 @@
 #include "texcompress_astc.h"
 #include "macros.h"
 #include "util/half_float.h"
+#include "c11/threads.h"
 #include <stdio.h>
 
 static bool VERBOSE_DECODE = false;
@@ -47,6 +48,21 @@ uint16_div_64k_to_half_to_unorm8(uint16_t v)
    return _mesa_half_to_unorm8(_mesa_uint16_div_64k_to_half(v));
 }
 
+/* The conversion above goes through two rounding steps that are expensive
+ * to do per channel, so the LDR decoder looks it up in this table instead.
+ * The interpolated value 65535 is 1.0 and maps to 0xff.
+ */
+static uint8_t unorm16_to_unorm8[1 << 16];
+static once_flag unorm16_to_unorm8_once = ONCE_FLAG_INIT;
+
+static void
+init_unorm16_to_unorm8(void)
+{
+   for (unsigned v = 0; v < 65535; v++)
+      unorm16_to_unorm8[v] = uint16_div_64k_to_half_to_unorm8(v);
+   unorm16_to_unorm8[65535] = 0xff;
+}
+
 class decode_error
 {
 public:
@@ -1611,31 +1627,51 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
    assert(!decoder.srgb || decoder.output_unorm8);
 
    if (is_void_extent) {
-      for (int idx = 0; idx < decoder.block_w*decoder.block_h*decoder.block_d; ++idx) {
-         if (decoder.output_unorm8) {
-            if (decoder.srgb) {
-               output[idx*4+0] = void_extent_colour_r >> 8;
-               output[idx*4+1] = void_extent_colour_g >> 8;
-               output[idx*4+2] = void_extent_colour_b >> 8;
-            } else {
-               output[idx*4+0] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_r);
-               output[idx*4+1] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_g);
-               output[idx*4+2] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_b);
-            }
-            output[idx*4+3] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_a);
+      /* The whole block has the same color, convert it once. */
+      uint16_t colour[4];
+      if (decoder.output_unorm8) {
+         if (decoder.srgb) {
+            colour[0] = void_extent_colour_r >> 8;
+            colour[1] = void_extent_colour_g >> 8;
+            colour[2] = void_extent_colour_b >> 8;
          } else {
-            /* Store the color as FP16. */
-            output[idx*4+0] = _mesa_uint16_div_64k_to_half(void_extent_colour_r);
-            output[idx*4+1] = _mesa_uint16_div_64k_to_half(void_extent_colour_g);
-            output[idx*4+2] = _mesa_uint16_div_64k_to_half(void_extent_colour_b);
-            output[idx*4+3] = _mesa_uint16_div_64k_to_half(void_extent_colour_a);
+            colour[0] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_r);
+            colour[1] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_g);
+            colour[2] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_b);
          }
+         colour[3] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_a);
+      } else {
+         /* Store the color as FP16. */
+         colour[0] = _mesa_uint16_div_64k_to_half(void_extent_colour_r);
+         colour[1] = _mesa_uint16_div_64k_to_half(void_extent_colour_g);
+         colour[2] = _mesa_uint16_div_64k_to_half(void_extent_colour_b);
+         colour[3] = _mesa_uint16_div_64k_to_half(void_extent_colour_a);
       }
+
+      for (int idx = 0; idx < decoder.block_w*decoder.block_h*decoder.block_d; ++idx)
+         memcpy(&output[idx * 4], colour, sizeof(colour));
       return;
    }
 
    int small_block = (decoder.block_w * decoder.block_h * decoder.block_d) < 31;
 
+   /* Expand the endpoints of every partition to 16 bits up front. */
+   uint16_t c0[4][4], c1[4][4];
+   for (int part = 0; part < num_parts; ++part) {
+      for (int i = 0; i < 4; ++i) {
+         const uint16_t e0 = endpoints_decoded[0][part].v[i];
+         const uint16_t e1 = endpoints_decoded[1][part].v[i];
+
+         if (decoder.srgb) {
+            c0[part][i] = (uint16_t)((e0 << 8) | 0x80);
+            c1[part][i] = (uint16_t)((e1 << 8) | 0x80);
+         } else {
+            c0[part][i] = (uint16_t)((e0 << 8) | e0);
+            c1[part][i] = (uint16_t)((e1 << 8) | e1);
+         }
+      }
+   }
+
    int idx = 0;
    for (int z = 0; z < decoder.block_d; ++z) {
       for (int y = 0; y < decoder.block_h; ++y) {
@@ -1651,69 +1687,36 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
 
             /* TODO: HDR */
 
-            uint8x4_t e0 = endpoints_decoded[0][partition];
-            uint8x4_t e1 = endpoints_decoded[1][partition];
-            uint16_t c0[4], c1[4];
-
-            /* Expand to 16 bits. */
-            if (decoder.srgb) {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | 0x80);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | 0x80);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | 0x80);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | 0x80);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | 0x80);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | 0x80);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | 0x80);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | 0x80);
-            } else {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | e0.v[0]);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | e0.v[1]);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | e0.v[2]);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | e0.v[3]);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | e1.v[0]);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | e1.v[1]);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | e1.v[2]);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | e1.v[3]);
-            }
-
             int w[4];
-            if (dual_plane) {
-               int w0 = infill_weights[0][idx];
-               int w1 = infill_weights[1][idx];
-               w[0] = w[1] = w[2] = w[3] = w0;
-               w[colour_component_selector] = w1;
-            } else {
-               int w0 = infill_weights[0][idx];
-               w[0] = w[1] = w[2] = w[3] = w0;
+            w[0] = w[1] = w[2] = w[3] = infill_weights[0][idx];
+            if (dual_plane)
+               w[colour_component_selector] = infill_weights[1][idx];
+
+            /* Interpolate to produce UNORM16, applying weights.  The channels
+             * are independent, which lets the compiler vectorize this.
+             */
+            uint16_t c[4];
+            for (int i = 0; i < 4; ++i) {
+               c[i] = (uint16_t)((c0[partition][i] * (64 - w[i]) +
+                                  c1[partition][i] * w[i] + 32) >> 6);
             }
 
-            /* Interpolate to produce UNORM16, applying weights. */
-            uint16_t c[4] = {
-               (uint16_t)((c0[0] * (64 - w[0]) + c1[0] * w[0] + 32) >> 6),
-               (uint16_t)((c0[1] * (64 - w[1]) + c1[1] * w[1] + 32) >> 6),
-               (uint16_t)((c0[2] * (64 - w[2]) + c1[2] * w[2] + 32) >> 6),
-               (uint16_t)((c0[3] * (64 - w[3]) + c1[3] * w[3] + 32) >> 6),
-            };
-
+            uint16_t *out = &output[idx * 4];
             if (decoder.output_unorm8) {
                if (decoder.srgb) {
-                  output[idx*4+0] = c[0] >> 8;
-                  output[idx*4+1] = c[1] >> 8;
-                  output[idx*4+2] = c[2] >> 8;
+                  out[0] = c[0] >> 8;
+                  out[1] = c[1] >> 8;
+                  out[2] = c[2] >> 8;
                } else {
-                  output[idx*4+0] = c[0] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[0]);
-                  output[idx*4+1] = c[1] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[1]);
-                  output[idx*4+2] = c[2] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[2]);
+                  out[0] = unorm16_to_unorm8[c[0]];
+                  out[1] = unorm16_to_unorm8[c[1]];
+                  out[2] = unorm16_to_unorm8[c[2]];
                }
-               output[idx*4+3] = c[3] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[3]);
+               out[3] = unorm16_to_unorm8[c[3]];
             } else {
                /* Store the color as FP16. */
-               output[idx*4+0] = c[0] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[0]);
-               output[idx*4+1] = c[1] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[1]);
-               output[idx*4+2] = c[2] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[2]);
-               output[idx*4+3] = c[3] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[3]);
+               for (int i = 0; i < 4; ++i)
+                  out[i] = c[i] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[i]);
             }
 
             idx++;
@@ -1813,35 +1816,36 @@ decode_error::type Block::calculate_colour_endpoints_size()
    return decode_error::invalid_colour_endpoints_size;
 }
 
-/**
- * Decode ASTC 2D LDR texture data.
- *
- * \param src_width in pixels
- * \param src_height in pixels
- * \param dst_stride in bytes
- */
-extern "C" void
-_mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
-                         unsigned dst_stride,
-                         const uint8_t *src_row,
-                         unsigned src_stride,
-                         unsigned src_width,
-                         unsigned src_height,
-                         mesa_format format)
+/** Parameters of a decode split by _mesa_texcompress_run_rows(). */
+struct astc_unpack_job
 {
-   assert(_mesa_is_format_astc_2d(format));
-   bool srgb = _mesa_is_format_srgb(format);
-
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   unsigned src_height;
    unsigned blk_w, blk_h;
-   _mesa_get_format_block_size(format, &blk_w, &blk_h);
+   bool srgb;
+};
 
+static void
+unpack_astc_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const astc_unpack_job *job = (const astc_unpack_job *) data;
+   const unsigned blk_w = job->blk_w, blk_h = job->blk_h;
    const unsigned block_size = 16;
-   unsigned x_blocks = (src_width + blk_w - 1) / blk_w;
-   unsigned y_blocks = (src_height + blk_h - 1) / blk_h;
+   const unsigned x_blocks = (job->src_width + blk_w - 1) / blk_w;
+
+   const uint8_t *src_row = job->src_row + first_row * job->src_stride;
+   uint8_t *dst_row = job->dst_row + first_row * blk_h * job->dst_stride;
+   const unsigned dst_stride = job->dst_stride;
+   const unsigned src_width = job->src_width;
+   const unsigned src_height = job->src_height;
 
-   Decoder dec(blk_w, blk_h, 1, srgb, true);
+   Decoder dec(blk_w, blk_h, 1, job->srgb, true);
 
-   for (unsigned y = 0; y < y_blocks; ++y) {
+   for (unsigned y = first_row; y < first_row + num_rows; ++y) {
       for (unsigned x = 0; x < x_blocks; ++x) {
          /* Same size as the largest block. */
          uint16_t block_out[12 * 12 * 4];
@@ -1865,7 +1869,44 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
             }
          }
       }
-      src_row += src_stride;
+      src_row += job->src_stride;
       dst_row += dst_stride * blk_h;
    }
 }
+
+/**
+ * Decode ASTC 2D LDR texture data.
+ *
+ * Large images are decoded by several threads.
+ *
+ * \param src_width in pixels
+ * \param src_height in pixels
+ * \param dst_stride in bytes
+ */
+extern "C" void
+_mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
+                         unsigned dst_stride,
+                         const uint8_t *src_row,
+                         unsigned src_stride,
+                         unsigned src_width,
+                         unsigned src_height,
+                         mesa_format format)
+{
+   assert(_mesa_is_format_astc_2d(format));
+
+   astc_unpack_job job;
+   job.dst_row = dst_row;
+   job.dst_stride = dst_stride;
+   job.src_row = src_row;
+   job.src_stride = src_stride;
+   job.src_width = src_width;
+   job.src_height = src_height;
+   job.srgb = _mesa_is_format_srgb(format);
+   _mesa_get_format_block_size(format, &job.blk_w, &job.blk_h);
+
+   call_once(&unorm16_to_unorm8_once, init_unorm16_to_unorm8);
+
+   _mesa_texcompress_run_rows((src_height + job.blk_h - 1) / job.blk_h,
+                              (src_width + job.blk_w - 1) / job.blk_w,
+                              unpack_astc_rows, &job);
+}
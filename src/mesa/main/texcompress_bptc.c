@@ -122,6 +122,80 @@ _mesa_get_bptc_fetch_func(mesa_format format)
    }
 }
 
+/** Parameters of an encode split by _mesa_texcompress_run_rows(). */
+struct bptc_compress_job
+{
+   int width;
+   int height;
+   const GLubyte *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   bool is_signed;
+};
+
+/**
+ * Return the start of block row \p row in the destination, following the
+ * handling of dst_rowstride in compress_rgba_unorm() and compress_rgb_float().
+ */
+static uint8_t *
+bptc_dst_row(const struct bptc_compress_job *job, unsigned row)
+{
+   int row_size = ((job->width + 3) & ~3) * 4;
+
+   if (job->dst_rowstride >= job->width * 4)
+      row_size = job->dst_rowstride;
+
+   return job->dst + (size_t) row * row_size;
+}
+
+static void
+compress_rgba_unorm_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct bptc_compress_job *job = data;
+   const int y = first_row * BLOCK_SIZE;
+
+   compress_rgba_unorm(job->width,
+                       MIN2((int) num_rows * BLOCK_SIZE, job->height - y),
+                       job->src + y * job->src_rowstride, job->src_rowstride,
+                       bptc_dst_row(job, first_row), job->dst_rowstride);
+}
+
+static void
+compress_rgb_float_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct bptc_compress_job *job = data;
+   const int y = first_row * BLOCK_SIZE;
+
+   compress_rgb_float(job->width,
+                      MIN2((int) num_rows * BLOCK_SIZE, job->height - y),
+                      (const float *) (job->src + y * job->src_rowstride),
+                      job->src_rowstride,
+                      bptc_dst_row(job, first_row), job->dst_rowstride,
+                      job->is_signed);
+}
+
+/** Compress the image, using several threads for large images. */
+static void
+compress_bptc(texcompress_rows_func func, int width, int height,
+              const void *src, int src_rowstride,
+              uint8_t *dst, int dst_rowstride, bool is_signed)
+{
+   struct bptc_compress_job job = {
+      .width = width,
+      .height = height,
+      .src = src,
+      .src_rowstride = src_rowstride,
+      .dst = dst,
+      .dst_rowstride = dst_rowstride,
+      .is_signed = is_signed,
+   };
+
+   _mesa_texcompress_run_rows(DIV_ROUND_UP(height, BLOCK_SIZE),
+                              DIV_ROUND_UP(width, BLOCK_SIZE),
+                              func, &job);
+}
+
 GLboolean
 _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
 {
@@ -161,9 +235,9 @@ _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
                                          srcFormat, srcType);
    }
 
-   compress_rgba_unorm(srcWidth, srcHeight,
-                       pixels, rowstride,
-                       dstSlices[0], dstRowStride);
+   compress_bptc(compress_rgba_unorm_rows, srcWidth, srcHeight,
+                 pixels, rowstride,
+                 dstSlices[0], dstRowStride, false);
 
    free((void *) tempImage);
 
@@ -206,10 +280,9 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
                                          srcFormat, srcType);
    }
 
-   compress_rgb_float(srcWidth, srcHeight,
-                      pixels, rowstride,
-                      dstSlices[0], dstRowStride,
-                      is_signed);
+   compress_bptc(compress_rgb_float_rows, srcWidth, srcHeight,
+                 pixels, rowstride,
+                 dstSlices[0], dstRowStride, is_signed);
 
    free((void *) tempImage);
 
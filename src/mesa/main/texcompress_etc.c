@@ -115,6 +115,31 @@ _mesa_texstore_etc1_rgb8(UNUSED_TEXSTORE_PARAMS)
 }
 
 
+/** Parameters of a decode split by _mesa_texcompress_run_rows(). */
+struct etc_unpack_job
+{
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   unsigned src_height;
+   mesa_format format;
+   bool bgra;
+};
+
+static void
+etc1_unpack_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct etc_unpack_job *job = data;
+   const unsigned y = first_row * 4;
+
+   etc1_unpack_rgba8888(job->dst_row + y * job->dst_stride, job->dst_stride,
+                        job->src_row + first_row * job->src_stride,
+                        job->src_stride, job->src_width,
+                        MIN2(num_rows * 4, job->src_height - y));
+}
+
 /**
  * Decode texture data in format `MESA_FORMAT_ETC1_RGB8` to
  * `MESA_FORMAT_ABGR8888`.
@@ -142,9 +167,18 @@ _mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
                            unsigned src_width,
                            unsigned src_height)
 {
-   etc1_unpack_rgba8888(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+   struct etc_unpack_job job = {
+      .dst_row = dst_row,
+      .dst_stride = dst_stride,
+      .src_row = src_row,
+      .src_stride = src_stride,
+      .src_width = src_width,
+      .src_height = src_height,
+   };
+
+   _mesa_texcompress_run_rows(DIV_ROUND_UP(src_height, 4),
+                              DIV_ROUND_UP(src_width, 4),
+                              etc1_unpack_rows, &job);
 }
 
 static uint8_t
@@ -1191,36 +1225,15 @@ _mesa_texstore_etc2_srgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
 }
 
 
-/**
- * Decode texture data in any one of following formats:
- * `MESA_FORMAT_ETC2_RGB8`
- * `MESA_FORMAT_ETC2_SRGB8`
- * `MESA_FORMAT_ETC2_RGBA8_EAC`
- * `MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC`
- * `MESA_FORMAT_ETC2_R11_EAC`
- * `MESA_FORMAT_ETC2_RG11_EAC`
- * `MESA_FORMAT_ETC2_SIGNED_R11_EAC`
- * `MESA_FORMAT_ETC2_SIGNED_RG11_EAC`
- * `MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1`
- * `MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1`
- *
- * The size of the source data must be a multiple of the ETC2 block size
- * even if the texture image's dimensions are not aligned to 4.
- *
- * \param src_width in pixels
- * \param src_height in pixels
- * \param dst_stride in bytes
- */
-
-void
-_mesa_unpack_etc2_format(uint8_t *dst_row,
-                         unsigned dst_stride,
-                         const uint8_t *src_row,
-                         unsigned src_stride,
-                         unsigned src_width,
-                         unsigned src_height,
-			 mesa_format format,
-			 bool bgra)
+static void
+etc2_unpack_format(uint8_t *dst_row,
+                   unsigned dst_stride,
+                   const uint8_t *src_row,
+                   unsigned src_stride,
+                   unsigned src_width,
+                   unsigned src_height,
+                   mesa_format format,
+                   bool bgra)
 {
    if (format == MESA_FORMAT_ETC2_RGB8)
       etc2_unpack_rgb8(dst_row, dst_stride,
@@ -1264,6 +1277,66 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 					    src_width, src_height, bgra);
 }
 
+static void
+etc2_unpack_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct etc_unpack_job *job = data;
+   const unsigned y = first_row * 4;
+
+   etc2_unpack_format(job->dst_row + y * job->dst_stride, job->dst_stride,
+                      job->src_row + first_row * job->src_stride,
+                      job->src_stride, job->src_width,
+                      MIN2(num_rows * 4, job->src_height - y),
+                      job->format, job->bgra);
+}
+
+/**
+ * Decode texture data in any one of following formats:
+ * `MESA_FORMAT_ETC2_RGB8`
+ * `MESA_FORMAT_ETC2_SRGB8`
+ * `MESA_FORMAT_ETC2_RGBA8_EAC`
+ * `MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC`
+ * `MESA_FORMAT_ETC2_R11_EAC`
+ * `MESA_FORMAT_ETC2_RG11_EAC`
+ * `MESA_FORMAT_ETC2_SIGNED_R11_EAC`
+ * `MESA_FORMAT_ETC2_SIGNED_RG11_EAC`
+ * `MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1`
+ * `MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1`
+ *
+ * The size of the source data must be a multiple of the ETC2 block size
+ * even if the texture image's dimensions are not aligned to 4.
+ *
+ * \param src_width in pixels
+ * \param src_height in pixels
+ * \param dst_stride in bytes
+ */
+
+void
+_mesa_unpack_etc2_format(uint8_t *dst_row,
+                         unsigned dst_stride,
+                         const uint8_t *src_row,
+                         unsigned src_stride,
+                         unsigned src_width,
+                         unsigned src_height,
+			 mesa_format format,
+			 bool bgra)
+{
+   struct etc_unpack_job job = {
+      .dst_row = dst_row,
+      .dst_stride = dst_stride,
+      .src_row = src_row,
+      .src_stride = src_stride,
+      .src_width = src_width,
+      .src_height = src_height,
+      .format = format,
+      .bgra = bgra,
+   };
+
+   _mesa_texcompress_run_rows(DIV_ROUND_UP(src_height, 4),
+                              DIV_ROUND_UP(src_width, 4),
+                              etc2_unpack_rows, &job);
+}
+
 
 
 static void
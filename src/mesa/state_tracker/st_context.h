@@ -172,6 +172,9 @@ struct st_context
     */
    boolean shader_has_one_variant[MESA_SHADER_STAGES];
 
+   /** Set while creating the variants recorded in the disk cache. */
+   boolean prewarming_variants;
+
    boolean needs_texcoord_semantic;
    boolean apply_texture_swizzle_to_border_color;
 
@@ -59,6 +59,7 @@ static const struct debug_named_value st_debug_flags[] = {
    { "precompile",  DEBUG_PRECOMPILE, NULL },
    { "gremedy",  DEBUG_GREMEDY, "Enable GREMEDY debug extensions" },
    { "noreadpixcache", DEBUG_NOREADPIXCACHE, NULL },
+   { "prewarm",  DEBUG_PREWARM, "Precompile the shader variants used by previous runs" },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -50,6 +50,7 @@
 #include "compiler/glsl/gl_nir_linker.h"
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_optimization.h"
+#include "compiler/glsl/linker_util.h"
 #include "compiler/glsl/string_to_uint_map.h"
 
 static int
@@ -242,49 +243,62 @@ st_nir_assign_uniform_locations(struct gl_context *ctx,
 
 void
 st_nir_opts(nir_shader *nir)
+{
+   nir_opt_loop loop;
+
+   nir_opt_loop_init(&loop, nir);
+   st_nir_opts_loop(nir, &loop);
+}
+
+/* The optimization loop of st_nir_opts(), with the caller's nir_opt_loop so
+ * that tests can check which passes were skipped.
+ */
+void
+st_nir_opts_loop(nir_shader *nir, nir_opt_loop *loop)
 {
    bool progress;
 
    do {
       progress = false;
 
-      NIR_PASS_V(nir, nir_lower_vars_to_ssa);
+      NIR_LOOP_PASS_V(loop, nir, nir_lower_vars_to_ssa);
       
       /* Linking deals with unused inputs/outputs, but here we can remove
        * things local to the shader in the hopes that we can cleanup other
        * things. This pass will also remove variables with only stores, so we
        * might be able to make progress after it.
        */
-      NIR_PASS(progress, nir, nir_remove_dead_variables,
-               (nir_variable_mode)(nir_var_function_temp |
-                                   nir_var_shader_temp |
-                                   nir_var_mem_shared));
+      NIR_LOOP_PASS(progress, loop, nir, nir_remove_dead_variables,
+                    (nir_variable_mode)(nir_var_function_temp |
+                                        nir_var_shader_temp |
+                                        nir_var_mem_shared));
 
-      NIR_PASS(progress, nir, nir_opt_copy_prop_vars);
-      NIR_PASS(progress, nir, nir_opt_dead_write_vars);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_copy_prop_vars);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_dead_write_vars);
 
       if (nir->options->lower_to_scalar) {
-         NIR_PASS_V(nir, nir_lower_alu_to_scalar, NULL, NULL);
-         NIR_PASS_V(nir, nir_lower_phis_to_scalar);
+         NIR_LOOP_PASS_V(loop, nir, nir_lower_alu_to_scalar, NULL, NULL);
+         NIR_LOOP_PASS_V(loop, nir, nir_lower_phis_to_scalar);
       }
 
-      NIR_PASS_V(nir, nir_lower_alu);
-      NIR_PASS_V(nir, nir_lower_pack);
-      NIR_PASS(progress, nir, nir_copy_prop);
-      NIR_PASS(progress, nir, nir_opt_remove_phis);
-      NIR_PASS(progress, nir, nir_opt_dce);
+      NIR_LOOP_PASS_V(loop, nir, nir_lower_alu);
+      NIR_LOOP_PASS_V(loop, nir, nir_lower_pack);
+      NIR_LOOP_PASS(progress, loop, nir, nir_copy_prop);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_remove_phis);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_dce);
       if (nir_opt_trivial_continues(nir)) {
          progress = true;
-         NIR_PASS(progress, nir, nir_copy_prop);
-         NIR_PASS(progress, nir, nir_opt_dce);
+         NIR_LOOP_PASS(progress, loop, nir, nir_copy_prop);
+         NIR_LOOP_PASS(progress, loop, nir, nir_opt_dce);
       }
-      NIR_PASS(progress, nir, nir_opt_if, false);
-      NIR_PASS(progress, nir, nir_opt_dead_cf);
-      NIR_PASS(progress, nir, nir_opt_cse);
-      NIR_PASS(progress, nir, nir_opt_peephole_select, 8, true, true);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_if, false);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_dead_cf);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_cse);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_peephole_select,
+                    8, true, true);
 
-      NIR_PASS(progress, nir, nir_opt_algebraic);
-      NIR_PASS(progress, nir, nir_opt_constant_folding);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_algebraic);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_constant_folding);
 
       if (!nir->info.flrp_lowered) {
          unsigned lower_flrp =
@@ -312,10 +326,11 @@ st_nir_opts(nir_shader *nir)
          nir->info.flrp_lowered = true;
       }
 
-      NIR_PASS(progress, nir, nir_opt_undef);
-      NIR_PASS(progress, nir, nir_opt_conditional_discard);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_undef);
+      NIR_LOOP_PASS(progress, loop, nir, nir_opt_conditional_discard);
       if (nir->options->max_unroll_iterations) {
-         NIR_PASS(progress, nir, nir_opt_loop_unroll, (nir_variable_mode)0);
+         NIR_LOOP_PASS(progress, loop, nir, nir_opt_loop_unroll,
+                       (nir_variable_mode)0);
       }
    } while (progress);
 }
@@ -635,6 +650,51 @@ st_nir_lower_wpos_ytransform(struct nir_shader *nir,
    }
 }
 
+struct st_link_stage_state {
+   struct st_context *st;
+   struct gl_shader_program *shader_program;
+};
+
+static void
+st_link_nir_lower_stage(void *data, unsigned stage)
+{
+   struct st_link_stage_state *state = (struct st_link_stage_state *) data;
+   struct gl_shader_program *shader_program = state->shader_program;
+   struct gl_linked_shader *shader = shader_program->_LinkedShaders[stage];
+   nir_shader *nir = shader->Program->nir;
+
+   /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
+    * that the buffer indices are constants in nir where they where
+    * constants in GLSL. */
+   NIR_PASS_V(nir, gl_nir_lower_buffers, shader_program);
+
+   /* Remap the locations to slots so those requiring two slots will occupy
+    * two locations. For instance, if we have in the IR code a dvec3 attr0 in
+    * location 0 and vec4 attr1 in location 1, in NIR attr0 will use
+    * locations/slots 0 and 1, and attr1 will use location/slot 2
+    */
+   if (nir->info.stage == MESA_SHADER_VERTEX && !shader_program->data->spirv)
+      nir_remap_dual_slot_attributes(nir, &shader->Program->DualSlotInputs);
+
+   NIR_PASS_V(nir, st_nir_lower_wpos_ytransform, shader->Program,
+              state->st->pipe->screen);
+
+   NIR_PASS_V(nir, nir_lower_system_values);
+   NIR_PASS_V(nir, nir_lower_clip_cull_distance_arrays);
+
+   nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
+   shader->Program->info = nir->info;
+   if (shader->Stage == MESA_SHADER_VERTEX) {
+      /* NIR expands dual-slot inputs out to two locations.  We need to
+       * compact things back down GL-style single-slot inputs to avoid
+       * confusing the state tracker.
+       */
+      shader->Program->info.inputs_read =
+         nir_get_single_slot_attribs_mask(nir->info.inputs_read,
+                                          shader->Program->DualSlotInputs);
+   }
+}
+
 bool
 st_link_nir(struct gl_context *ctx,
             struct gl_shader_program *shader_program)
@@ -741,41 +801,17 @@ st_link_nir(struct gl_context *ctx,
       nir_build_program_resource_list(ctx, shader_program, false);
    }
 
+   /* The lowering below only touches the shader it runs on, so the stages
+    * can be processed concurrently.
+    */
+   struct st_link_stage_state state = { st, shader_program };
+   link_util_run_per_stage(shader_program->data->linked_stages,
+                           st_link_nir_lower_stage, &state);
+
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
       nir_shader *nir = shader->Program->nir;
 
-      /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
-       * that the buffer indices are constants in nir where they where
-       * constants in GLSL. */
-      NIR_PASS_V(nir, gl_nir_lower_buffers, shader_program);
-
-      /* Remap the locations to slots so those requiring two slots will occupy
-       * two locations. For instance, if we have in the IR code a dvec3 attr0 in
-       * location 0 and vec4 attr1 in location 1, in NIR attr0 will use
-       * locations/slots 0 and 1, and attr1 will use location/slot 2
-       */
-      if (nir->info.stage == MESA_SHADER_VERTEX && !shader_program->data->spirv)
-         nir_remap_dual_slot_attributes(nir, &shader->Program->DualSlotInputs);
-
-      NIR_PASS_V(nir, st_nir_lower_wpos_ytransform, shader->Program,
-                 st->pipe->screen);
-
-      NIR_PASS_V(nir, nir_lower_system_values);
-      NIR_PASS_V(nir, nir_lower_clip_cull_distance_arrays);
-
-      nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
-      shader->Program->info = nir->info;
-      if (shader->Stage == MESA_SHADER_VERTEX) {
-         /* NIR expands dual-slot inputs out to two locations.  We need to
-          * compact things back down GL-style single-slot inputs to avoid
-          * confusing the state tracker.
-          */
-         shader->Program->info.inputs_read =
-            nir_get_single_slot_attribs_mask(nir->info.inputs_read,
-                                             shader->Program->DualSlotInputs);
-      }
-
       if (i >= 1) {
          struct gl_program *prev_shader = linked_shader[i - 1]->Program;
 
@@ -32,6 +32,7 @@ extern "C" {
 #endif
 
 struct nir_shader;
+struct nir_opt_loop;
 
 void st_nir_lower_builtin(struct nir_shader *shader);
 void st_nir_lower_tex_src_plane(struct nir_shader *shader, unsigned free_slots,
@@ -46,6 +47,7 @@ void st_finalize_nir(struct st_context *st, struct gl_program *prog,
                      struct nir_shader *nir, bool finalize_by_driver);
 
 void st_nir_opts(struct nir_shader *nir);
+void st_nir_opts_loop(struct nir_shader *nir, struct nir_opt_loop *loop);
 
 bool
 st_link_nir(struct gl_context *ctx,
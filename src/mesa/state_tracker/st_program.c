@@ -738,6 +738,9 @@ st_get_vp_variant(struct st_context *st,
          /* insert into list */
          vpv->base.next = stp->variants;
          stp->variants = &vpv->base;
+
+         if (ST_DEBUG & DEBUG_PREWARM)
+            st_store_variant_keys_in_disk_cache(st, stp);
       }
    }
 
@@ -1454,6 +1457,9 @@ st_get_fp_variant(struct st_context *st,
             /* insert into list */
             fpv->base.next = stfp->variants;
             stfp->variants = &fpv->base;
+
+            if (ST_DEBUG & DEBUG_PREWARM)
+               st_store_variant_keys_in_disk_cache(st, stfp);
          }
       }
    }
@@ -1751,6 +1757,9 @@ st_get_common_variant(struct st_context *st,
          /* insert into list */
          v->next = prog->variants;
          prog->variants = v;
+
+         if (ST_DEBUG & DEBUG_PREWARM)
+            st_store_variant_keys_in_disk_cache(st, prog);
       }
    }
 
@@ -1925,4 +1934,8 @@ st_finalize_program(struct st_context *st, struct gl_program *prog)
    if (ST_DEBUG & DEBUG_PRECOMPILE ||
        st->shader_has_one_variant[prog->info.stage])
       st_precompile_shader_variant(st, prog);
+
+   /* Also create the variants that previous runs needed. */
+   if (ST_DEBUG & DEBUG_PREWARM)
+      st_load_variant_keys_from_disk_cache(st, (struct st_program *)prog);
 }
@@ -22,6 +22,7 @@
  */
 
 #include <stdio.h>
+#include "st_context.h"
 #include "st_debug.h"
 #include "st_program.h"
 #include "st_shader_cache.h"
@@ -140,6 +141,146 @@ st_store_ir_in_disk_cache(struct st_context *st, struct gl_program *prog,
    }
 }
 
+/**
+ * Compute the disk cache key of the variant keys recorded for a GLSL
+ * program.  Returns false if there's no cache key for the program.
+ */
+static bool
+get_variant_keys_cache_key(struct st_context *st, struct gl_program *prog,
+                           cache_key key)
+{
+   static const char zero[sizeof(prog->sh.data->sha1)] = {0};
+   static const char prefix[] = "st variant keys";
+   uint8_t data[sizeof(prefix) + sizeof(prog->sh.data->sha1) + 1];
+
+   if (!st->ctx->Cache || prog->is_arb_asm || !prog->sh.data ||
+       memcmp(prog->sh.data->sha1, zero, sizeof(zero)) == 0)
+      return false;
+
+   memcpy(data, prefix, sizeof(prefix));
+   memcpy(data + sizeof(prefix), prog->sh.data->sha1,
+          sizeof(prog->sh.data->sha1));
+   data[sizeof(data) - 1] = prog->info.stage;
+
+   disk_cache_compute_key(st->ctx->Cache, data, sizeof(data), key);
+   return true;
+}
+
+/**
+ * Record the keys of all the variants of a program in the disk cache, so
+ * that the next run can create them before they are needed for drawing.
+ * glBitmap and glDrawPixels variants aren't recorded.
+ */
+void
+st_store_variant_keys_in_disk_cache(struct st_context *st,
+                                    struct st_program *stp)
+{
+   struct gl_program *prog = &stp->Base;
+   struct blob blob;
+   cache_key key;
+
+   if (st->prewarming_variants ||
+       !get_variant_keys_cache_key(st, prog, key))
+      return;
+
+   blob_init(&blob);
+
+   if (prog->info.stage == MESA_SHADER_FRAGMENT) {
+      blob_write_uint32(&blob, sizeof(struct st_fp_variant_key));
+
+      for (struct st_variant *v = stp->variants; v; v = v->next) {
+         struct st_fp_variant_key fp_key = st_fp_variant(v)->key;
+
+         if (fp_key.bitmap || fp_key.drawpixels)
+            continue;
+
+         fp_key.st = NULL;
+         blob_write_bytes(&blob, &fp_key, sizeof(fp_key));
+      }
+   } else {
+      blob_write_uint32(&blob, sizeof(struct st_common_variant_key));
+
+      for (struct st_variant *v = stp->variants; v; v = v->next) {
+         struct st_common_variant_key common_key = st_common_variant(v)->key;
+
+         common_key.st = NULL;
+         blob_write_bytes(&blob, &common_key, sizeof(common_key));
+      }
+   }
+
+   if (!blob.out_of_memory)
+      disk_cache_put(st->ctx->Cache, key, blob.data, blob.size, NULL);
+
+   blob_finish(&blob);
+}
+
+/**
+ * Create the variants of a program recorded in the disk cache by
+ * st_store_variant_keys_in_disk_cache().
+ */
+void
+st_load_variant_keys_from_disk_cache(struct st_context *st,
+                                     struct st_program *stp)
+{
+   struct gl_program *prog = &stp->Base;
+   struct blob_reader blob_reader;
+   cache_key key;
+   size_t size;
+   uint8_t *buffer;
+
+   if (!get_variant_keys_cache_key(st, prog, key))
+      return;
+
+   buffer = disk_cache_get(st->ctx->Cache, key, &size);
+   if (!buffer)
+      return;
+
+   blob_reader_init(&blob_reader, buffer, size);
+   st->prewarming_variants = true;
+
+   if (prog->info.stage == MESA_SHADER_FRAGMENT) {
+      struct st_fp_variant_key fp_key;
+
+      if (blob_read_uint32(&blob_reader) != sizeof(fp_key))
+         goto out;
+
+      while (blob_reader.current < blob_reader.end) {
+         blob_copy_bytes(&blob_reader, &fp_key, sizeof(fp_key));
+         if (blob_reader.overrun)
+            break;
+
+         fp_key.st = st->has_shareable_shaders ? NULL : st;
+         st_get_fp_variant(st, stp, &fp_key);
+      }
+   } else {
+      struct st_common_variant_key common_key;
+
+      if (blob_read_uint32(&blob_reader) != sizeof(common_key))
+         goto out;
+
+      while (blob_reader.current < blob_reader.end) {
+         blob_copy_bytes(&blob_reader, &common_key, sizeof(common_key));
+         if (blob_reader.overrun)
+            break;
+
+         common_key.st = st->has_shareable_shaders ? NULL : st;
+         if (prog->info.stage == MESA_SHADER_VERTEX)
+            st_get_vp_variant(st, stp, &common_key);
+         else
+            st_get_common_variant(st, stp, &common_key);
+      }
+   }
+
+   if (st->ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+      fprintf(stderr, "%s state tracker variants created from cache\n",
+              _mesa_shader_stage_to_string(prog->info.stage));
+   }
+
+out:
+   st->prewarming_variants = false;
+   free(buffer);
+}
+
 static void
 read_stream_out_from_cache(struct blob_reader *blob_reader,
                            struct pipe_shader_state *state)
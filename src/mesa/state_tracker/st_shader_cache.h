@@ -69,6 +69,14 @@ st_load_ir_from_disk_cache(struct gl_context *ctx,
                            struct gl_shader_program *prog,
                              bool nir);
 
+void
+st_store_variant_keys_in_disk_cache(struct st_context *st,
+                                    struct st_program *stp);
+
+void
+st_load_variant_keys_from_disk_cache(struct st_context *st,
+                                     struct st_program *stp);
+
 void
 st_store_ir_in_disk_cache(struct st_context *st, struct gl_program *prog,
                           bool nir);
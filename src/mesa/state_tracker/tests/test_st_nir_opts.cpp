@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "state_tracker/st_nir.h"
+
+namespace {
+
+class st_nir_opts_test : public ::testing::Test {
+protected:
+   st_nir_opts_test();
+   ~st_nir_opts_test();
+
+   void *mem_ctx;
+   nir_builder *b;
+   nir_shader_compiler_options options;
+};
+
+st_nir_opts_test::st_nir_opts_test()
+:  options()
+{
+   glsl_type_singleton_init_or_ref();
+
+   options.lower_to_scalar = true;
+   options.lower_flrp32 = true;
+   options.max_unroll_iterations = 32;
+
+   mem_ctx = ralloc_context(NULL);
+
+   b = rzalloc(mem_ctx, nir_builder);
+   nir_builder_init_simple_shader(b, mem_ctx, MESA_SHADER_COMPUTE, &options);
+}
+
+st_nir_opts_test::~st_nir_opts_test()
+{
+   if (HasFailure()) {
+      printf("\nShader from the failed test:\n\n");
+      nir_print_shader(b->shader, stdout);
+   }
+
+   ralloc_free(mem_ctx);
+
+   glsl_type_singleton_decref();
+}
+
+} // namespace
+
+TEST_F(st_nir_opts_test, skip_at_fixed_point)
+{
+   nir_variable *out = nir_variable_create(b->shader, nir_var_mem_ssbo,
+                                           glsl_vec4_type(), "out");
+   nir_variable *i = nir_local_variable_create(b->impl, glsl_int_type(), "i");
+   nir_variable *sum = nir_local_variable_create(b->impl, glsl_int_type(),
+                                                 "sum");
+
+   nir_store_var(b, i, nir_imm_int(b, 0), 0x1);
+   nir_store_var(b, sum, nir_imm_int(b, 0), 0x1);
+
+   /* for (i = 0; i < 4; i++) sum += i; */
+   nir_push_loop(b);
+   {
+      nir_ssa_def *iv = nir_load_var(b, i);
+      nir_push_if(b, nir_ige(b, iv, nir_imm_int(b, 4)));
+      nir_jump(b, nir_jump_break);
+      nir_pop_if(b, NULL);
+
+      nir_store_var(b, sum, nir_iadd(b, nir_load_var(b, sum), iv), 0x1);
+      nir_store_var(b, i, nir_iadd_imm(b, iv, 1), 0x1);
+   }
+   nir_pop_loop(b, NULL);
+
+   nir_ssa_def *x = nir_u2f32(b, nir_load_local_invocation_index(b));
+   nir_ssa_def *val = nir_vec4(b, nir_i2f32(b, nir_load_var(b, sum)), x,
+                               nir_flrp(b, x, nir_imm_float(b, 2.0),
+                                        nir_imm_float(b, 0.5)),
+                               nir_fadd(b, x, nir_imm_float(b, 0.0)));
+   nir_store_deref(b, nir_build_deref_var(b, out), val, 0xf);
+
+   nir_opt_loop loop;
+   nir_opt_loop_init(&loop, b->shader);
+
+   st_nir_opts_loop(b->shader, &loop);
+   nir_validate_shader(b->shader, "after st_nir_opts");
+
+   /* The loop was unrolled and folded away. */
+   ASSERT_TRUE(nir_cf_node_is_last(&nir_start_block(b->impl)->cf_node));
+
+   /* Confirming the fixed point doesn't rerun passes that already saw the
+    * final shader.
+    */
+   EXPECT_GT(loop.num_skipped, 0u);
+
+   /* Nothing changed since, so a second run doesn't run any pass at all,
+    * even though some of them throw away metadata without progress.
+    */
+   const unsigned num_run = loop.num_run;
+   st_nir_opts_loop(b->shader, &loop);
+   EXPECT_EQ(loop.num_run, num_run);
+}
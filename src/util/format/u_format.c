@@ -335,7 +335,7 @@ util_format_read_4f(enum pipe_format format,
    const uint8_t *src_row;
    float *dst_row;
 
-   format_desc = util_format_description(format);
+   format_desc = util_format_description_simd(format);
 
    assert(x % format_desc->block.width == 0);
    assert(y % format_desc->block.height == 0);
@@ -357,7 +357,7 @@ util_format_write_4f(enum pipe_format format,
    uint8_t *dst_row;
    const float *src_row;
 
-   format_desc = util_format_description(format);
+   format_desc = util_format_description_simd(format);
 
    assert(x % format_desc->block.width == 0);
    assert(y % format_desc->block.height == 0);
@@ -376,7 +376,7 @@ util_format_read_4ub(enum pipe_format format, uint8_t *dst, unsigned dst_stride,
    const uint8_t *src_row;
    uint8_t *dst_row;
 
-   format_desc = util_format_description(format);
+   format_desc = util_format_description_simd(format);
 
    assert(x % format_desc->block.width == 0);
    assert(y % format_desc->block.height == 0);
@@ -395,7 +395,7 @@ util_format_write_4ub(enum pipe_format format, const uint8_t *src, unsigned src_
    uint8_t *dst_row;
    const uint8_t *src_row;
 
-   format_desc = util_format_description(format);
+   format_desc = util_format_description_simd(format);
 
    assert(x % format_desc->block.width == 0);
    assert(y % format_desc->block.height == 0);
@@ -657,8 +657,8 @@ util_format_translate(enum pipe_format dst_format,
    unsigned dst_step;
    unsigned src_step;
 
-   dst_format_desc = util_format_description(dst_format);
-   src_format_desc = util_format_description(src_format);
+   dst_format_desc = util_format_description_simd(dst_format);
+   src_format_desc = util_format_description_simd(src_format);
 
    if (util_is_format_compatible(src_format_desc, dst_format_desc)) {
       /*
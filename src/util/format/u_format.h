@@ -428,6 +428,13 @@ struct util_format_description
 const struct util_format_description *
 util_format_description(enum pipe_format format);
 
+/**
+ * Like util_format_description(), but the row functions may be replaced by
+ * vectorized versions for the current CPU.  Use this for bulk conversions.
+ */
+const struct util_format_description *
+util_format_description_simd(enum pipe_format format);
+
 
 /*
  * Format query functions.
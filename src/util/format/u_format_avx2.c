@@ -0,0 +1,226 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * AVX2 pack/unpack row functions.  This file is built with -mavx2 and only
+ * called when util_cpu_caps.has_avx2 is set.
+ *
+ * Each 256-bit vector holds two RGBA pixels, so no transposes are needed,
+ * and the sRGB conversions can use gathers into the existing lookup tables.
+ */
+
+#include <immintrin.h>
+
+#include "util/format/u_format_simd.h"
+#include "util/format_srgb.h"
+
+
+static inline __m256
+ubyte_to_float_avx2(__m256i ub)
+{
+   return _mm256_mul_ps(_mm256_cvtepi32_ps(ub), _mm256_set1_ps(1.0f / 255.0f));
+}
+
+/* Vector version of float_to_ubyte(), see float_to_ubyte_sse2() */
+static inline __m256i
+float_to_ubyte_avx2(__m256 f)
+{
+   f = _mm256_max_ps(f, _mm256_setzero_ps());
+   f = _mm256_min_ps(f, _mm256_set1_ps(1.0f));
+   f = _mm256_add_ps(_mm256_mul_ps(f, _mm256_set1_ps(255.0f / 256.0f)),
+                     _mm256_set1_ps(32768.0f));
+   return _mm256_and_si256(_mm256_castps_si256(f), _mm256_set1_epi32(0xff));
+}
+
+/* Vector version of util_format_linear_float_to_srgb_8unorm() */
+static inline __m256i
+float_to_srgb_avx2(__m256 f)
+{
+   const __m256i minval = _mm256_set1_epi32((127 - 13) << 23);
+   __m256i bits, tab, bias, scale, t;
+
+   /* Same clamps as the scalar code, which also maps NaN to minval */
+   f = _mm256_max_ps(f, _mm256_castsi256_ps(minval));
+   f = _mm256_min_ps(f, _mm256_castsi256_ps(_mm256_set1_epi32(0x3f7fffff)));
+
+   bits = _mm256_castps_si256(f);
+   tab = _mm256_i32gather_epi32((const int *)util_format_linear_to_srgb_helper_table,
+                                _mm256_srli_epi32(_mm256_sub_epi32(bits, minval), 20),
+                                4);
+   bias = _mm256_slli_epi32(_mm256_srli_epi32(tab, 16), 9);
+   scale = _mm256_and_si256(tab, _mm256_set1_epi32(0xffff));
+   t = _mm256_and_si256(_mm256_srli_epi32(bits, 12), _mm256_set1_epi32(0xff));
+
+   return _mm256_srli_epi32(_mm256_add_epi32(bias, _mm256_mullo_epi32(scale, t)),
+                            16);
+}
+
+/* Swap the R and B channels of two float RGBA pixels */
+static inline __m256
+swap_rb_avx2(__m256 v)
+{
+   return _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+/**
+ * Pack four vectors of 32-bit lanes holding bytes into 32 bytes, keeping
+ * the lane order.
+ */
+static inline __m256i
+pack_ubytes_avx2(__m256i c0, __m256i c1, __m256i c2, __m256i c3)
+{
+   /* The packs interleave the 128-bit halves, undo that at the end */
+   const __m256i p = _mm256_packus_epi16(_mm256_packs_epi32(c0, c1),
+                                         _mm256_packs_epi32(c2, c3));
+   return _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5,
+                                                           2, 6, 3, 7));
+}
+
+/* 8 RGBA8/BGRA8 pixels to float, linear or sRGB */
+static inline void
+rgba8_to_float_avx2(uint8_t *dst, const uint8_t *src, bool swap, bool srgb)
+{
+   unsigned i;
+
+   for (i = 0; i < 4; i++) {
+      const __m256i ub =
+         _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + 8 * i)));
+      __m256 f = ubyte_to_float_avx2(ub);
+
+      if (srgb) {
+         const __m256 lin =
+            _mm256_i32gather_ps(util_format_srgb_8unorm_to_linear_float_table,
+                                ub, 4);
+         f = _mm256_blend_ps(lin, f, 0x88);
+      }
+      if (swap)
+         f = swap_rb_avx2(f);
+
+      _mm256_storeu_ps((float *)dst + 8 * i, f);
+   }
+}
+
+/* 8 float pixels to RGBA8/BGRA8, linear or sRGB */
+static inline void
+float_to_rgba8_avx2(uint8_t *dst, const uint8_t *src, bool swap, bool srgb)
+{
+   __m256i c[4];
+   unsigned i;
+
+   for (i = 0; i < 4; i++) {
+      __m256 f = _mm256_loadu_ps((const float *)src + 8 * i);
+
+      if (swap)
+         f = swap_rb_avx2(f);
+
+      c[i] = float_to_ubyte_avx2(f);
+      if (srgb)
+         c[i] = _mm256_blend_epi32(float_to_srgb_avx2(f), c[i], 0x88);
+   }
+
+   _mm256_storeu_si256((__m256i *)dst, pack_ubytes_avx2(c[0], c[1], c[2], c[3]));
+}
+
+#define RGBA8_BODIES(name, swap, srgb)                                        \
+static inline void                                                           \
+name##_unpack_float_avx2(uint8_t *dst, const uint8_t *src)                    \
+{                                                                            \
+   rgba8_to_float_avx2(dst, src, swap, srgb);                                 \
+}                                                                            \
+static inline void                                                           \
+name##_pack_float_avx2(uint8_t *dst, const uint8_t *src)                      \
+{                                                                            \
+   float_to_rgba8_avx2(dst, src, swap, srgb);                                 \
+}                                                                            \
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_##name##_unpack_rgba_float_avx2,        \
+                          float, 16, uint8_t, 4, 8,                          \
+                          name##_unpack_float_avx2)                          \
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_##name##_pack_rgba_float_avx2,          \
+                          uint8_t, 4, float, 16, 8,                          \
+                          name##_pack_float_avx2)
+
+RGBA8_BODIES(r8g8b8a8_unorm, false, false)
+RGBA8_BODIES(b8g8r8a8_unorm, true, false)
+RGBA8_BODIES(r8g8b8a8_srgb, false, true)
+RGBA8_BODIES(b8g8r8a8_srgb, true, true)
+
+/* 4 R16G16B16A16_FLOAT pixels to float, see half_to_float_sse2() */
+static inline void
+r16g16b16a16_float_unpack_float_avx2(uint8_t *dst, const uint8_t *src)
+{
+   unsigned i;
+
+   for (i = 0; i < 2; i++) {
+      const __m256i h =
+         _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)src + i));
+      const __m256i mag =
+         _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x7fff)), 13);
+      const __m256i sign =
+         _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16);
+      __m256 f = _mm256_mul_ps(_mm256_castsi256_ps(mag),
+                               _mm256_castsi256_ps(_mm256_set1_epi32(0xef << 23)));
+      const __m256 infnan = _mm256_cmp_ps(f, _mm256_set1_ps(65536.0f), _CMP_GE_OQ);
+
+      f = _mm256_or_ps(f, _mm256_and_ps(infnan,
+                                        _mm256_castsi256_ps(_mm256_set1_epi32(0xff << 23))));
+      f = _mm256_or_ps(f, _mm256_castsi256_ps(sign));
+      _mm256_storeu_ps((float *)dst + 8 * i, f);
+   }
+}
+
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r16g16b16a16_float_unpack_rgba_float_avx2,
+                          float, 16, uint8_t, 8, 4,
+                          r16g16b16a16_float_unpack_float_avx2)
+
+bool
+util_format_simd_install_avx2(struct util_format_description *desc)
+{
+   switch (desc->format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+      desc->unpack_rgba_float = util_format_r8g8b8a8_unorm_unpack_rgba_float_avx2;
+      desc->pack_rgba_float = util_format_r8g8b8a8_unorm_pack_rgba_float_avx2;
+      return true;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      desc->unpack_rgba_float = util_format_b8g8r8a8_unorm_unpack_rgba_float_avx2;
+      desc->pack_rgba_float = util_format_b8g8r8a8_unorm_pack_rgba_float_avx2;
+      return true;
+   case PIPE_FORMAT_R8G8B8A8_SRGB:
+      desc->unpack_rgba_float = util_format_r8g8b8a8_srgb_unpack_rgba_float_avx2;
+      desc->pack_rgba_float = util_format_r8g8b8a8_srgb_pack_rgba_float_avx2;
+      return true;
+   case PIPE_FORMAT_B8G8R8A8_SRGB:
+      desc->unpack_rgba_float = util_format_b8g8r8a8_srgb_unpack_rgba_float_avx2;
+      desc->pack_rgba_float = util_format_b8g8r8a8_srgb_pack_rgba_float_avx2;
+      return true;
+   case PIPE_FORMAT_R16G16B16A16_FLOAT:
+      desc->unpack_rgba_float = util_format_r16g16b16a16_float_unpack_rgba_float_avx2;
+      return true;
+   default:
+      return false;
+   }
+}
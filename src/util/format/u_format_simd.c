@@ -0,0 +1,655 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Vectorized pack/unpack row functions for the most common formats.
+ *
+ * util_format_description_simd() returns a copy of the format description
+ * whose row functions have been replaced by SSE2, AVX2 or NEON kernels where
+ * the CPU we are running on supports them.  The kernels match the generated
+ * scalar code bit for bit.
+ */
+
+#include "c11/threads.h"
+#include "util/format/u_format_simd.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_FORMAT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/* Only on AArch64, where NEON doesn't flush denormals, which the half-float
+ * conversion relies on.
+ */
+#include <arm_neon.h>
+#define HAVE_FORMAT_NEON 1
+#endif
+
+
+#ifdef HAVE_FORMAT_SSE2
+
+static inline __m128
+ubyte_to_float_sse2(__m128i ub)
+{
+   return _mm_mul_ps(_mm_cvtepi32_ps(ub), _mm_set1_ps(1.0f / 255.0f));
+}
+
+/**
+ * Vector version of float_to_ubyte().  The result is in the low byte of
+ * each 32-bit lane, the other bytes are zero.
+ */
+static inline __m128i
+float_to_ubyte_sse2(__m128 f)
+{
+   /* maxps returns the second operand if either is NaN, so NaN maps to 0 */
+   f = _mm_max_ps(f, _mm_setzero_ps());
+   f = _mm_min_ps(f, _mm_set1_ps(1.0f));
+   f = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f / 256.0f)),
+                  _mm_set1_ps(32768.0f));
+   return _mm_and_si128(_mm_castps_si128(f), _mm_set1_epi32(0xff));
+}
+
+/**
+ * Vector version of util_half_to_float(), for halfs in the low 16 bits of
+ * each 32-bit lane.
+ */
+static inline __m128
+half_to_float_sse2(__m128i h)
+{
+   const __m128i mag = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)),
+                                      13);
+   const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)),
+                                       16);
+   __m128 f = _mm_mul_ps(_mm_castsi128_ps(mag),
+                         _mm_castsi128_ps(_mm_set1_epi32(0xef << 23)));
+   const __m128 infnan = _mm_cmpge_ps(f, _mm_set1_ps(65536.0f));
+
+   f = _mm_or_ps(f, _mm_and_ps(infnan,
+                               _mm_castsi128_ps(_mm_set1_epi32(0xff << 23))));
+   return _mm_or_ps(f, _mm_castsi128_ps(sign));
+}
+
+/* Swap the first and third byte of each 32-bit lane, RGBA8 <-> BGRA8 */
+static inline __m128i
+swap_rb_sse2(__m128i v)
+{
+   const __m128i ga = _mm_and_si128(v, _mm_set1_epi32(0xff00ff00));
+   const __m128i rb = _mm_and_si128(v, _mm_set1_epi32(0x00ff00ff));
+   return _mm_or_si128(ga, _mm_or_si128(_mm_srli_epi32(rb, 16),
+                                        _mm_slli_epi32(rb, 16)));
+}
+
+/* 4 RGBA8/BGRA8 pixels to float */
+static inline void
+rgba8_unorm_to_float_sse2(uint8_t *dst, const uint8_t *src, bool swap)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i p = _mm_loadu_si128((const __m128i *)src);
+   __m128i lo, hi;
+   __m128 c[4];
+   unsigned i;
+
+   if (swap)
+      p = swap_rb_sse2(p);
+
+   lo = _mm_unpacklo_epi8(p, zero);
+   hi = _mm_unpackhi_epi8(p, zero);
+   c[0] = ubyte_to_float_sse2(_mm_unpacklo_epi16(lo, zero));
+   c[1] = ubyte_to_float_sse2(_mm_unpackhi_epi16(lo, zero));
+   c[2] = ubyte_to_float_sse2(_mm_unpacklo_epi16(hi, zero));
+   c[3] = ubyte_to_float_sse2(_mm_unpackhi_epi16(hi, zero));
+
+   for (i = 0; i < 4; i++)
+      _mm_storeu_ps((float *)dst + 4 * i, c[i]);
+}
+
+/* 4 float pixels to RGBA8/BGRA8 */
+static inline void
+float_to_rgba8_unorm_sse2(uint8_t *dst, const uint8_t *src, bool swap)
+{
+   const float *s = (const float *)src;
+   __m128i c[4], p;
+   unsigned i;
+
+   for (i = 0; i < 4; i++)
+      c[i] = float_to_ubyte_sse2(_mm_loadu_ps(s + 4 * i));
+
+   p = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]),
+                        _mm_packs_epi32(c[2], c[3]));
+   if (swap)
+      p = swap_rb_sse2(p);
+
+   _mm_storeu_si128((__m128i *)dst, p);
+}
+
+static inline void
+r8g8b8a8_unorm_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   rgba8_unorm_to_float_sse2(dst, src, false);
+}
+
+static inline void
+b8g8r8a8_unorm_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   rgba8_unorm_to_float_sse2(dst, src, true);
+}
+
+static inline void
+r8g8b8a8_unorm_pack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   float_to_rgba8_unorm_sse2(dst, src, false);
+}
+
+static inline void
+b8g8r8a8_unorm_pack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   float_to_rgba8_unorm_sse2(dst, src, true);
+}
+
+static inline void
+b8g8r8a8_unorm_swap_sse2(uint8_t *dst, const uint8_t *src)
+{
+   _mm_storeu_si128((__m128i *)dst,
+                    swap_rb_sse2(_mm_loadu_si128((const __m128i *)src)));
+}
+
+/**
+ * 8 B5G6R5 pixels to RGBA8.  x * 255 / 31 and x * 255 / 63 are computed
+ * exactly as multiplications by 2^20 / 31 and 2^20 / 63, rounded up.
+ */
+static inline void
+b5g6r5_unorm_unpack_8unorm_sse2(uint8_t *dst, const uint8_t *src)
+{
+   const __m128i v = _mm_loadu_si128((const __m128i *)src);
+   const __m128i c255 = _mm_set1_epi16(255);
+   __m128i r = _mm_srli_epi16(v, 11);
+   __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3f));
+   __m128i b = _mm_and_si128(v, _mm_set1_epi16(0x1f));
+   __m128i rg, ba;
+
+   r = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(r, c255),
+                                      _mm_set1_epi16((short)33826)), 4);
+   g = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(g, c255),
+                                      _mm_set1_epi16(16645)), 4);
+   b = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(b, c255),
+                                      _mm_set1_epi16((short)33826)), 4);
+
+   rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+   ba = _mm_or_si128(b, _mm_set1_epi16((short)0xff00));
+   _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));
+   _mm_storeu_si128((__m128i *)dst + 1, _mm_unpackhi_epi16(rg, ba));
+}
+
+/* 4 B5G6R5 pixels to float */
+static inline void
+b5g6r5_unorm_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   const __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src),
+                                        _mm_setzero_si128());
+   __m128 r = _mm_cvtepi32_ps(_mm_srli_epi32(v, 11));
+   __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 5),
+                                            _mm_set1_epi32(0x3f)));
+   __m128 b = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0x1f)));
+   __m128 a = _mm_set1_ps(1.0f);
+
+   r = _mm_mul_ps(r, _mm_set1_ps(1.0f / 0x1f));
+   g = _mm_mul_ps(g, _mm_set1_ps(1.0f / 0x3f));
+   b = _mm_mul_ps(b, _mm_set1_ps(1.0f / 0x1f));
+
+   _MM_TRANSPOSE4_PS(r, g, b, a);
+   _mm_storeu_ps((float *)dst + 0, r);
+   _mm_storeu_ps((float *)dst + 4, g);
+   _mm_storeu_ps((float *)dst + 8, b);
+   _mm_storeu_ps((float *)dst + 12, a);
+}
+
+/* 4 R10G10B10A2/B10G10R10A2 pixels to float */
+static inline void
+rgb10a2_unorm_to_float_sse2(uint8_t *dst, const uint8_t *src, bool swap)
+{
+   const __m128i v = _mm_loadu_si128((const __m128i *)src);
+   const __m128i mask = _mm_set1_epi32(0x3ff);
+   const __m128 scale = _mm_set1_ps(1.0f / 0x3ff);
+   __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), scale);
+   __m128 g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10),
+                                                       mask)), scale);
+   __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 20),
+                                                       mask)), scale);
+   __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 30)),
+                         _mm_set1_ps(1.0f / 0x3));
+
+   if (swap) {
+      _MM_TRANSPOSE4_PS(z, g, x, a);
+      _mm_storeu_ps((float *)dst + 0, z);
+      _mm_storeu_ps((float *)dst + 4, g);
+      _mm_storeu_ps((float *)dst + 8, x);
+   } else {
+      _MM_TRANSPOSE4_PS(x, g, z, a);
+      _mm_storeu_ps((float *)dst + 0, x);
+      _mm_storeu_ps((float *)dst + 4, g);
+      _mm_storeu_ps((float *)dst + 8, z);
+   }
+   _mm_storeu_ps((float *)dst + 12, a);
+}
+
+static inline void
+r10g10b10a2_unorm_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   rgb10a2_unorm_to_float_sse2(dst, src, false);
+}
+
+static inline void
+b10g10r10a2_unorm_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   rgb10a2_unorm_to_float_sse2(dst, src, true);
+}
+
+/* 4 R16G16B16A16_FLOAT pixels to float */
+static inline void
+r16g16b16a16_float_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i p0 = _mm_loadu_si128((const __m128i *)src);
+   const __m128i p1 = _mm_loadu_si128((const __m128i *)src + 1);
+   float *d = (float *)dst;
+
+   _mm_storeu_ps(d + 0, half_to_float_sse2(_mm_unpacklo_epi16(p0, zero)));
+   _mm_storeu_ps(d + 4, half_to_float_sse2(_mm_unpackhi_epi16(p0, zero)));
+   _mm_storeu_ps(d + 8, half_to_float_sse2(_mm_unpacklo_epi16(p1, zero)));
+   _mm_storeu_ps(d + 12, half_to_float_sse2(_mm_unpackhi_epi16(p1, zero)));
+}
+
+/**
+ * Vector version of uf11_to_f32()/uf10_to_f32().  Shifting the exponent
+ * into place turns these into halfs, except for NaNs, where the scalar code
+ * keeps the mantissa in the low bits.
+ */
+static inline __m128
+ufloat_to_float_sse2(__m128i v, unsigned mantissa_bits)
+{
+   const __m128i exp_mask = _mm_set1_epi32(0x1f << mantissa_bits);
+   const __m128i mantissa = _mm_and_si128(v, _mm_set1_epi32((1 << mantissa_bits) - 1));
+   const __m128i nan = _mm_cmpeq_epi32(_mm_and_si128(v, exp_mask), exp_mask);
+   const __m128 f = half_to_float_sse2(_mm_slli_epi32(v, 10 - mantissa_bits));
+   const __m128 inf = _mm_castsi128_ps(_mm_or_si128(mantissa,
+                                                    _mm_set1_epi32(0x7f800000)));
+
+   return _mm_or_ps(_mm_andnot_ps(_mm_castsi128_ps(nan), f),
+                    _mm_and_ps(_mm_castsi128_ps(nan), inf));
+}
+
+/* 4 R11G11B10_FLOAT pixels to float */
+static inline void
+r11g11b10_float_unpack_float_sse2(uint8_t *dst, const uint8_t *src)
+{
+   const __m128i v = _mm_loadu_si128((const __m128i *)src);
+   const __m128i mask = _mm_set1_epi32(0x7ff);
+   __m128 r = ufloat_to_float_sse2(_mm_and_si128(v, mask), 6);
+   __m128 g = ufloat_to_float_sse2(_mm_and_si128(_mm_srli_epi32(v, 11), mask), 6);
+   __m128 b = ufloat_to_float_sse2(_mm_srli_epi32(v, 22), 5);
+   __m128 a = _mm_set1_ps(1.0f);
+
+   _MM_TRANSPOSE4_PS(r, g, b, a);
+   _mm_storeu_ps((float *)dst + 0, r);
+   _mm_storeu_ps((float *)dst + 4, g);
+   _mm_storeu_ps((float *)dst + 8, b);
+   _mm_storeu_ps((float *)dst + 12, a);
+}
+
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 4, 4,
+                          r8g8b8a8_unorm_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 4, 4,
+                          b8g8r8a8_unorm_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r8g8b8a8_unorm_pack_rgba_float_sse2,
+                          uint8_t, 4, float, 16, 4,
+                          r8g8b8a8_unorm_pack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_pack_rgba_float_sse2,
+                          uint8_t, 4, float, 16, 4,
+                          b8g8r8a8_unorm_pack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_swap_rgba_8unorm_sse2,
+                          uint8_t, 4, uint8_t, 4, 4,
+                          b8g8r8a8_unorm_swap_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b5g6r5_unorm_unpack_rgba_8unorm_sse2,
+                          uint8_t, 4, uint8_t, 2, 8,
+                          b5g6r5_unorm_unpack_8unorm_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b5g6r5_unorm_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 2, 4,
+                          b5g6r5_unorm_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r10g10b10a2_unorm_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 4, 4,
+                          r10g10b10a2_unorm_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b10g10r10a2_unorm_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 4, 4,
+                          b10g10r10a2_unorm_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r16g16b16a16_float_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 8, 4,
+                          r16g16b16a16_float_unpack_float_sse2)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r11g11b10_float_unpack_rgba_float_sse2,
+                          float, 16, uint8_t, 4, 4,
+                          r11g11b10_float_unpack_float_sse2)
+
+static bool
+util_format_simd_install_sse2(struct util_format_description *desc)
+{
+   switch (desc->format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+      desc->unpack_rgba_float = util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2;
+      desc->pack_rgba_float = util_format_r8g8b8a8_unorm_pack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      desc->unpack_rgba_8unorm = util_format_b8g8r8a8_unorm_swap_rgba_8unorm_sse2;
+      desc->pack_rgba_8unorm = util_format_b8g8r8a8_unorm_swap_rgba_8unorm_sse2;
+      desc->unpack_rgba_float = util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2;
+      desc->pack_rgba_float = util_format_b8g8r8a8_unorm_pack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_B5G6R5_UNORM:
+      desc->unpack_rgba_8unorm = util_format_b5g6r5_unorm_unpack_rgba_8unorm_sse2;
+      desc->unpack_rgba_float = util_format_b5g6r5_unorm_unpack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_R10G10B10A2_UNORM:
+      desc->unpack_rgba_float = util_format_r10g10b10a2_unorm_unpack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_B10G10R10A2_UNORM:
+      desc->unpack_rgba_float = util_format_b10g10r10a2_unorm_unpack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_R16G16B16A16_FLOAT:
+      desc->unpack_rgba_float = util_format_r16g16b16a16_float_unpack_rgba_float_sse2;
+      return true;
+   case PIPE_FORMAT_R11G11B10_FLOAT:
+      desc->unpack_rgba_float = util_format_r11g11b10_float_unpack_rgba_float_sse2;
+      return true;
+   default:
+      return false;
+   }
+}
+
+#endif /* HAVE_FORMAT_SSE2 */
+
+
+#ifdef HAVE_FORMAT_NEON
+
+static inline float32x4_t
+ubyte_to_float_neon(uint16x4_t ub)
+{
+   return vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(ub)), 1.0f / 255.0f);
+}
+
+/* Vector version of float_to_ubyte(), see float_to_ubyte_sse2() */
+static inline uint16x4_t
+float_to_ubyte_neon(float32x4_t f)
+{
+   /* fmaxnm returns the number if the other operand is NaN */
+   f = vmaxnmq_f32(f, vdupq_n_f32(0.0f));
+   f = vminq_f32(f, vdupq_n_f32(1.0f));
+   f = vaddq_f32(vmulq_n_f32(f, 255.0f / 256.0f), vdupq_n_f32(32768.0f));
+   return vmovn_u32(vandq_u32(vreinterpretq_u32_f32(f), vdupq_n_u32(0xff)));
+}
+
+/* Vector version of util_half_to_float() */
+static inline float32x4_t
+half_to_float_neon(uint16x4_t h)
+{
+   const uint32x4_t v = vmovl_u16(h);
+   const uint32x4_t mag = vshlq_n_u32(vandq_u32(v, vdupq_n_u32(0x7fff)), 13);
+   const uint32x4_t sign = vshlq_n_u32(vandq_u32(v, vdupq_n_u32(0x8000)), 16);
+   uint32x4_t f = vreinterpretq_u32_f32(
+      vmulq_f32(vreinterpretq_f32_u32(mag),
+                vreinterpretq_f32_u32(vdupq_n_u32(0xef << 23))));
+   const uint32x4_t infnan = vcgeq_f32(vreinterpretq_f32_u32(f),
+                                       vdupq_n_f32(65536.0f));
+
+   f = vorrq_u32(f, vandq_u32(infnan, vdupq_n_u32(0xff << 23)));
+   return vreinterpretq_f32_u32(vorrq_u32(f, sign));
+}
+
+/* 16 RGBA8/BGRA8 pixels to float */
+static inline void
+rgba8_unorm_to_float_neon(uint8_t *dst, const uint8_t *src, bool swap)
+{
+   const uint8x16x4_t p = vld4q_u8(src);
+   uint16x8_t c[4];
+   float32x4x4_t out;
+   unsigned i, j;
+
+   for (j = 0; j < 4; j++)
+      c[j] = vmovl_u8(vget_low_u8(p.val[j]));
+
+   for (i = 0; i < 4; i++) {
+      if (i == 2) {
+         for (j = 0; j < 4; j++)
+            c[j] = vmovl_u8(vget_high_u8(p.val[j]));
+      }
+      for (j = 0; j < 4; j++) {
+         const uint16x4_t ub = (i & 1) ? vget_high_u16(c[j]) :
+                                         vget_low_u16(c[j]);
+         out.val[swap && j != 1 && j != 3 ? 2 - j : j] = ubyte_to_float_neon(ub);
+      }
+      vst4q_f32((float *)dst + 16 * i, out);
+   }
+}
+
+/* 8 float pixels to RGBA8/BGRA8 */
+static inline void
+float_to_rgba8_unorm_neon(uint8_t *dst, const uint8_t *src, bool swap)
+{
+   const float32x4x4_t lo = vld4q_f32((const float *)src);
+   const float32x4x4_t hi = vld4q_f32((const float *)src + 16);
+   uint8x8x4_t out;
+   unsigned j;
+
+   for (j = 0; j < 4; j++) {
+      const uint16x8_t c = vcombine_u16(float_to_ubyte_neon(lo.val[j]),
+                                        float_to_ubyte_neon(hi.val[j]));
+      out.val[swap && j != 1 && j != 3 ? 2 - j : j] = vmovn_u16(c);
+   }
+   vst4_u8(dst, out);
+}
+
+static inline void
+r8g8b8a8_unorm_unpack_float_neon(uint8_t *dst, const uint8_t *src)
+{
+   rgba8_unorm_to_float_neon(dst, src, false);
+}
+
+static inline void
+b8g8r8a8_unorm_unpack_float_neon(uint8_t *dst, const uint8_t *src)
+{
+   rgba8_unorm_to_float_neon(dst, src, true);
+}
+
+static inline void
+r8g8b8a8_unorm_pack_float_neon(uint8_t *dst, const uint8_t *src)
+{
+   float_to_rgba8_unorm_neon(dst, src, false);
+}
+
+static inline void
+b8g8r8a8_unorm_pack_float_neon(uint8_t *dst, const uint8_t *src)
+{
+   float_to_rgba8_unorm_neon(dst, src, true);
+}
+
+static inline void
+b8g8r8a8_unorm_swap_neon(uint8_t *dst, const uint8_t *src)
+{
+   uint8x16x4_t p = vld4q_u8(src);
+   const uint8x16_t tmp = p.val[0];
+
+   p.val[0] = p.val[2];
+   p.val[2] = tmp;
+   vst4q_u8(dst, p);
+}
+
+/* x * 255 / 31 or x * 255 / 63, see b5g6r5_unorm_unpack_8unorm_sse2() */
+static inline uint8x8_t
+unorm_to_ubyte_neon(uint16x8_t x, uint16_t recip)
+{
+   const uint16x8_t x255 = vmulq_n_u16(x, 255);
+   const uint16x4_t lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(x255), recip), 16);
+   const uint16x4_t hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(x255), recip), 16);
+   return vmovn_u16(vshrq_n_u16(vcombine_u16(lo, hi), 4));
+}
+
+/* 8 B5G6R5 pixels to RGBA8 */
+static inline void
+b5g6r5_unorm_unpack_8unorm_neon(uint8_t *dst, const uint8_t *src)
+{
+   const uint16x8_t v = vld1q_u16((const uint16_t *)src);
+   uint8x8x4_t out;
+
+   out.val[0] = unorm_to_ubyte_neon(vshrq_n_u16(v, 11), 33826);
+   out.val[1] = unorm_to_ubyte_neon(vandq_u16(vshrq_n_u16(v, 5),
+                                              vdupq_n_u16(0x3f)), 16645);
+   out.val[2] = unorm_to_ubyte_neon(vandq_u16(v, vdupq_n_u16(0x1f)), 33826);
+   out.val[3] = vdup_n_u8(255);
+   vst4_u8(dst, out);
+}
+
+/* 2 R16G16B16A16_FLOAT pixels to float */
+static inline void
+r16g16b16a16_float_unpack_float_neon(uint8_t *dst, const uint8_t *src)
+{
+   const uint16x8_t p = vld1q_u16((const uint16_t *)src);
+
+   vst1q_f32((float *)dst, half_to_float_neon(vget_low_u16(p)));
+   vst1q_f32((float *)dst + 4, half_to_float_neon(vget_high_u16(p)));
+}
+
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r8g8b8a8_unorm_unpack_rgba_float_neon,
+                          float, 16, uint8_t, 4, 16,
+                          r8g8b8a8_unorm_unpack_float_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_unpack_rgba_float_neon,
+                          float, 16, uint8_t, 4, 16,
+                          b8g8r8a8_unorm_unpack_float_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r8g8b8a8_unorm_pack_rgba_float_neon,
+                          uint8_t, 4, float, 16, 8,
+                          r8g8b8a8_unorm_pack_float_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_pack_rgba_float_neon,
+                          uint8_t, 4, float, 16, 8,
+                          b8g8r8a8_unorm_pack_float_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b8g8r8a8_unorm_swap_rgba_8unorm_neon,
+                          uint8_t, 4, uint8_t, 4, 16,
+                          b8g8r8a8_unorm_swap_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_b5g6r5_unorm_unpack_rgba_8unorm_neon,
+                          uint8_t, 4, uint8_t, 2, 8,
+                          b5g6r5_unorm_unpack_8unorm_neon)
+UTIL_FORMAT_SIMD_ROW_FUNC(util_format_r16g16b16a16_float_unpack_rgba_float_neon,
+                          float, 16, uint8_t, 8, 2,
+                          r16g16b16a16_float_unpack_float_neon)
+
+static bool
+util_format_simd_install_neon(struct util_format_description *desc)
+{
+   switch (desc->format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+      desc->unpack_rgba_float = util_format_r8g8b8a8_unorm_unpack_rgba_float_neon;
+      desc->pack_rgba_float = util_format_r8g8b8a8_unorm_pack_rgba_float_neon;
+      return true;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      desc->unpack_rgba_8unorm = util_format_b8g8r8a8_unorm_swap_rgba_8unorm_neon;
+      desc->pack_rgba_8unorm = util_format_b8g8r8a8_unorm_swap_rgba_8unorm_neon;
+      desc->unpack_rgba_float = util_format_b8g8r8a8_unorm_unpack_rgba_float_neon;
+      desc->pack_rgba_float = util_format_b8g8r8a8_unorm_pack_rgba_float_neon;
+      return true;
+   case PIPE_FORMAT_B5G6R5_UNORM:
+      desc->unpack_rgba_8unorm = util_format_b5g6r5_unorm_unpack_rgba_8unorm_neon;
+      return true;
+   case PIPE_FORMAT_R16G16B16A16_FLOAT:
+      desc->unpack_rgba_float = util_format_r16g16b16a16_float_unpack_rgba_float_neon;
+      return true;
+   default:
+      return false;
+   }
+}
+
+#endif /* HAVE_FORMAT_NEON */
+
+
+/* Plenty for the formats above */
+#define UTIL_FORMAT_SIMD_MAX_FORMATS 32
+
+static struct util_format_description
+simd_descriptions[UTIL_FORMAT_SIMD_MAX_FORMATS];
+
+static const struct util_format_description *
+simd_table[PIPE_FORMAT_COUNT];
+
+static once_flag simd_once_flag = ONCE_FLAG_INIT;
+
+static void
+util_format_simd_init(void)
+{
+   unsigned num_descriptions = 0;
+   unsigned format;
+
+   util_cpu_detect();
+
+   for (format = 0; format < PIPE_FORMAT_COUNT; format++) {
+      const struct util_format_description *desc =
+         util_format_description(format);
+      struct util_format_description tmp;
+      bool replaced = false;
+
+      simd_table[format] = desc;
+      if (!desc || num_descriptions == ARRAY_SIZE(simd_descriptions))
+         continue;
+
+      tmp = *desc;
+#ifdef HAVE_FORMAT_SSE2
+      if (util_cpu_caps.has_sse2)
+         replaced |= util_format_simd_install_sse2(&tmp);
+#endif
+#ifdef HAVE_FORMAT_NEON
+      if (util_cpu_caps.has_neon)
+         replaced |= util_format_simd_install_neon(&tmp);
+#endif
+#ifdef USE_AVX2
+      if (util_cpu_caps.has_avx2)
+         replaced |= util_format_simd_install_avx2(&tmp);
+#endif
+
+      if (replaced) {
+         simd_descriptions[num_descriptions] = tmp;
+         simd_table[format] = &simd_descriptions[num_descriptions++];
+      }
+   }
+}
+
+const struct util_format_description *
+util_format_description_simd(enum pipe_format format)
+{
+   if (format >= PIPE_FORMAT_COUNT)
+      return NULL;
+
+   call_once(&simd_once_flag, util_format_simd_init);
+
+   return simd_table[format];
+}
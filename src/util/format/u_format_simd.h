@@ -0,0 +1,86 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Internal helpers shared by the vectorized pack/unpack kernels.
+ *
+ * The kernels produce exactly the same bits as the generated scalar code in
+ * u_format_table.c, so which one gets used is never visible to callers.
+ */
+
+#ifndef U_FORMAT_SIMD_H_
+#define U_FORMAT_SIMD_H_
+
+#include <string.h>
+
+#include "util/format/u_format.h"
+
+
+/**
+ * Define a row function with the util_format_description signature around
+ * BODY, which converts exactly STEP pixels from SRC to DST.  The last partial
+ * step of a row goes through a zero-padded temporary so BODY never needs to
+ * handle a tail or read past the end of the source.
+ */
+#define UTIL_FORMAT_SIMD_ROW_FUNC(name, dst_type, dst_bpp, src_type, src_bpp, \
+                                  step, body)                               \
+static void                                                                  \
+name(dst_type *dst_row, unsigned dst_stride,                                 \
+     const src_type *src_row, unsigned src_stride,                           \
+     unsigned width, unsigned height)                                        \
+{                                                                            \
+   unsigned x, y;                                                            \
+   for (y = 0; y < height; y++) {                                            \
+      uint8_t *dst = (uint8_t *)dst_row;                                     \
+      const uint8_t *src = (const uint8_t *)src_row;                         \
+      for (x = 0; x + (step) <= width; x += (step)) {                        \
+         body(dst, src);                                                     \
+         dst += (step) * (dst_bpp);                                          \
+         src += (step) * (src_bpp);                                          \
+      }                                                                      \
+      if (x < width) {                                                       \
+         uint8_t tmp_src[(step) * (src_bpp)];                                \
+         uint8_t tmp_dst[(step) * (dst_bpp)];                                \
+         memset(tmp_src, 0, sizeof(tmp_src));                                \
+         memcpy(tmp_src, src, (width - x) * (src_bpp));                      \
+         body(tmp_dst, tmp_src);                                             \
+         memcpy(dst, tmp_dst, (width - x) * (dst_bpp));                      \
+      }                                                                      \
+      dst_row = (dst_type *)((uint8_t *)dst_row + dst_stride);               \
+      src_row = (const src_type *)((const uint8_t *)src_row + src_stride);   \
+   }                                                                         \
+}
+
+
+#ifdef USE_AVX2
+bool
+util_format_simd_install_avx2(struct util_format_description *desc);
+#endif
+
+
+#endif /* U_FORMAT_SIMD_H_ */
@@ -76,10 +76,17 @@
 #include "main/imports.h"
 #include "main/macros.h"
 #include "util/bitset.h"
+#include "util/blob.h"
 #include "register_allocate.h"
 
 #define NO_REG ~0U
 
+/* Header of serialized register sets.  Bump the version whenever the layout
+ * written by ra_set_serialize() changes.
+ */
+#define RA_SET_BLOB_MAGIC 0x52415345 /* "RASE" */
+#define RA_SET_BLOB_VERSION 1
+
 struct ra_reg {
    BITSET_WORD *conflicts;
    unsigned int *conflict_list;
@@ -441,6 +448,110 @@ ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
    }
 }
 
+/**
+ * Writes a finalized register set to a blob.
+ *
+ * Together with ra_set_deserialize(), this lets drivers skip the
+ * O(r^2*c^2) ra_set_finalize() step when they create the same register set
+ * over and over, e.g. by storing the blob in their shader cache or
+ * generating it at build time.
+ */
+void
+ra_set_serialize(const struct ra_regs *regs, struct blob *blob)
+{
+   const unsigned words = BITSET_WORDS(regs->count);
+
+   blob_write_uint32(blob, RA_SET_BLOB_MAGIC);
+   blob_write_uint32(blob, RA_SET_BLOB_VERSION);
+   blob_write_uint32(blob, regs->count);
+   blob_write_uint32(blob, regs->class_count);
+   blob_write_uint32(blob, regs->round_robin);
+
+   for (unsigned int r = 0; r < regs->count; r++) {
+      /* Conflict lists only exist until the set is finalized; the allocator
+       * itself only needs the bitsets.
+       */
+      assert(regs->regs[r].conflict_list == NULL);
+      blob_write_bytes(blob, regs->regs[r].conflicts,
+                       words * sizeof(BITSET_WORD));
+   }
+
+   for (unsigned int c = 0; c < regs->class_count; c++) {
+      const struct ra_class *class = regs->classes[c];
+      blob_write_bytes(blob, class->regs, words * sizeof(BITSET_WORD));
+      blob_write_uint32(blob, class->p);
+      blob_write_bytes(blob, class->q, regs->class_count * sizeof(*class->q));
+   }
+}
+
+/**
+ * Creates a finalized register set from a blob written by ra_set_serialize().
+ *
+ * Returns NULL if the blob is truncated or otherwise malformed.
+ */
+struct ra_regs *
+ra_set_deserialize(void *mem_ctx, struct blob_reader *blob)
+{
+   const uint32_t magic = blob_read_uint32(blob);
+   const uint32_t version = blob_read_uint32(blob);
+
+   /* Blobs written with a different layout can't be read back. */
+   if (blob->overrun || magic != RA_SET_BLOB_MAGIC ||
+       version != RA_SET_BLOB_VERSION)
+      return NULL;
+
+   const unsigned int reg_count = blob_read_uint32(blob);
+   const unsigned int class_count = blob_read_uint32(blob);
+   const bool round_robin = blob_read_uint32(blob) != 0;
+
+   if (blob->overrun)
+      return NULL;
+
+   /* Check the counts against what is left of the blob before allocating
+    * anything, so that a corrupt header can't make us allocate huge arrays.
+    */
+   const uint64_t words = BITSET_WORDS((uint64_t)reg_count);
+   const uint64_t remaining = blob->end - blob->current;
+   const uint64_t regs_size = reg_count * words * sizeof(BITSET_WORD);
+   const uint64_t class_size = words * sizeof(BITSET_WORD) + sizeof(uint32_t) +
+                               class_count * (uint64_t)sizeof(unsigned int);
+   if (regs_size > remaining ||
+       class_count > (remaining - regs_size) / class_size) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, reg_count, false);
+
+   regs->round_robin = round_robin;
+
+   for (unsigned int r = 0; r < reg_count; r++) {
+      blob_copy_bytes(blob, regs->regs[r].conflicts,
+                      words * sizeof(BITSET_WORD));
+   }
+
+   regs->classes = ralloc_array(regs->regs, struct ra_class *, class_count);
+   regs->class_count = class_count;
+
+   for (unsigned int c = 0; c < class_count; c++) {
+      struct ra_class *class = rzalloc(regs, struct ra_class);
+      regs->classes[c] = class;
+
+      class->regs = ralloc_array(class, BITSET_WORD, words);
+      blob_copy_bytes(blob, class->regs, words * sizeof(BITSET_WORD));
+      class->p = blob_read_uint32(blob);
+      class->q = ralloc_array(regs, unsigned int, class_count);
+      blob_copy_bytes(blob, class->q, class_count * sizeof(*class->q));
+   }
+
+   if (blob->overrun) {
+      ralloc_free(regs);
+      return NULL;
+   }
+
+   return regs;
+}
+
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
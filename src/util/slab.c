@@ -128,6 +128,90 @@ void slab_create_child(struct slab_child_pool *pool,
    pool->pages = NULL;
    pool->free = NULL;
    pool->migrated = NULL;
+   pool->magazine = NULL;
+   pool->num_magazine = 0;
+   pool->num_pages = 0;
+   pool->num_free = 0;
+}
+
+/* Push a chain of elements onto the migrated stack of their owner.
+ *
+ * Must be called with the parent mutex held, which guarantees that the owner
+ * is not destroyed concurrently. The owner itself may be popping the stack
+ * at the same time, hence the compare-and-swap loop.
+ */
+static void
+slab_push_migrated_locked(struct slab_child_pool *owner,
+                          struct slab_element_header *first,
+                          struct slab_element_header *last)
+{
+   struct slab_element_header *head = p_atomic_read(&owner->migrated);
+
+   for (;;) {
+      struct slab_element_header *old;
+
+      last->next = head;
+      old = p_atomic_cmpxchg(&owner->migrated, head, first);
+      if (old == head)
+         break;
+      head = old;
+   }
+}
+
+/**
+ * Return all objects collected in the magazine of the given child pool to
+ * the child pools that own them.
+ *
+ * This is done automatically when the magazine is full and when the pool is
+ * destroyed, but callers may want to flush earlier, e.g. before going idle,
+ * so that the owners can reuse the memory sooner.
+ */
+void
+slab_flush_magazine(struct slab_child_pool *pool)
+{
+   struct slab_element_header *orphaned = NULL;
+
+   if (!pool->magazine)
+      return;
+
+   mtx_lock(&pool->parent->mutex);
+
+   while (pool->magazine) {
+      struct slab_element_header *first = pool->magazine;
+      struct slab_element_header *last = first;
+      /* Note: we _must_ read elt->owner while holding the mutex because the
+       * owning child pool may have been destroyed by another thread in the
+       * meantime.
+       */
+      intptr_t owner_int = p_atomic_read(&first->owner);
+
+      if (owner_int & 1) {
+         pool->magazine = first->next;
+         first->next = orphaned;
+         orphaned = first;
+         continue;
+      }
+
+      /* Objects freed back-to-back usually come from the same owner, so
+       * push runs of them with a single compare-and-swap.
+       */
+      while (last->next && p_atomic_read(&last->next->owner) == owner_int)
+         last = last->next;
+
+      pool->magazine = last->next;
+      slab_push_migrated_locked((struct slab_child_pool *)owner_int,
+                                first, last);
+   }
+
+   pool->num_magazine = 0;
+
+   mtx_unlock(&pool->parent->mutex);
+
+   while (orphaned) {
+      struct slab_element_header *elt = orphaned;
+      orphaned = elt->next;
+      slab_free_orphaned(elt);
+   }
 }
 
 /**
@@ -138,9 +222,13 @@ void slab_create_child(struct slab_child_pool *pool,
  */
 void slab_destroy_child(struct slab_child_pool *pool)
 {
+   struct slab_element_header *migrated;
+
    if (!pool->parent)
       return; /* the slab probably wasn't even created */
 
+   slab_flush_magazine(pool);
+
    mtx_lock(&pool->parent->mutex);
 
    while (pool->pages) {
@@ -154,20 +242,28 @@ void slab_destroy_child(struct slab_child_pool *pool)
       }
    }
 
-   while (pool->migrated) {
-      struct slab_element_header *elt = pool->migrated;
-      pool->migrated = elt->next;
-      slab_free_orphaned(elt);
-   }
+   /* Nobody can push to the migrated list anymore once the mutex is
+    * released, because all elements are marked as orphaned now.
+    */
+   migrated = p_atomic_xchg(&pool->migrated, NULL);
 
    mtx_unlock(&pool->parent->mutex);
 
+   while (migrated) {
+      struct slab_element_header *elt = migrated;
+      migrated = elt->next;
+      slab_free_orphaned(elt);
+   }
+
    while (pool->free) {
       struct slab_element_header *elt = pool->free;
       pool->free = elt->next;
       slab_free_orphaned(elt);
    }
 
+   pool->num_pages = 0;
+   pool->num_free = 0;
+
    /* Guard against use-after-free. */
    pool->parent = NULL;
 }
@@ -193,6 +289,8 @@ slab_add_new_page(struct slab_child_pool *pool)
 
    page->u.next = pool->pages;
    pool->pages = page;
+   pool->num_pages++;
+   pool->num_free += pool->parent->num_elements;
 
    return true;
 }
@@ -209,12 +307,12 @@ slab_alloc(struct slab_child_pool *pool)
 
    if (!pool->free) {
       /* First, collect elements that belong to us but were freed from a
-       * different child pool.
+       * different child pool. We are the only consumer of the migrated
+       * stack, so taking it as a whole needs no lock.
        */
-      mtx_lock(&pool->parent->mutex);
-      pool->free = pool->migrated;
-      pool->migrated = NULL;
-      mtx_unlock(&pool->parent->mutex);
+      pool->free = p_atomic_xchg(&pool->migrated, NULL);
+      for (elt = pool->free; elt; elt = elt->next)
+         pool->num_free++;
 
       /* Now allocate a new page. */
       if (!pool->free && !slab_add_new_page(pool))
@@ -223,6 +321,7 @@ slab_alloc(struct slab_child_pool *pool)
 
    elt = pool->free;
    pool->free = elt->next;
+   pool->num_free--;
 
    CHECK_MAGIC(elt, SLAB_MAGIC_FREE);
    SET_MAGIC(elt, SLAB_MAGIC_ALLOCATED);
@@ -242,7 +341,6 @@ slab_alloc(struct slab_child_pool *pool)
 void slab_free(struct slab_child_pool *pool, void *ptr)
 {
    struct slab_element_header *elt = ((struct slab_element_header*)ptr - 1);
-   intptr_t owner_int;
 
    CHECK_MAGIC(elt, SLAB_MAGIC_ALLOCATED);
    SET_MAGIC(elt, SLAB_MAGIC_FREE);
@@ -253,27 +351,35 @@ void slab_free(struct slab_child_pool *pool, void *ptr)
        */
       elt->next = pool->free;
       pool->free = elt;
+      pool->num_free++;
       return;
    }
 
-   /* The slow case: migration or an orphaned page. */
-   mtx_lock(&pool->parent->mutex);
-
-   /* Note: we _must_ re-read elt->owner here because the owning child pool
-    * may have been destroyed by another thread in the meantime.
+   /* The slow case: migration or an orphaned page. Collect the element in
+    * the magazine, which is only accessed by this thread, and give it back
+    * to its owner later together with others. The owner may be destroyed
+    * in the meantime; slab_flush_magazine deals with that.
     */
-   owner_int = p_atomic_read(&elt->owner);
+   elt->next = pool->magazine;
+   pool->magazine = elt;
 
-   if (!(owner_int & 1)) {
-      struct slab_child_pool *owner = (struct slab_child_pool *)owner_int;
-      elt->next = owner->migrated;
-      owner->migrated = elt;
-      mtx_unlock(&pool->parent->mutex);
-   } else {
-      mtx_unlock(&pool->parent->mutex);
+   if (++pool->num_magazine >= SLAB_MAGAZINE_SIZE)
+      slab_flush_magazine(pool);
+}
 
-      slab_free_orphaned(elt);
-   }
+/**
+ * Return statistics for the given child pool. Must be called from the thread
+ * using the pool.
+ */
+void
+slab_get_child_stats(const struct slab_child_pool *pool,
+                     struct slab_child_stats *stats)
+{
+   stats->num_pages = pool->num_pages;
+   stats->num_free = pool->num_free;
+   stats->num_in_flight = pool->parent ?
+      pool->num_pages * pool->parent->num_elements - pool->num_free : 0;
+   stats->num_magazine = pool->num_magazine;
 }
 
 /**
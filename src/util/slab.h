@@ -33,7 +33,10 @@
  * Allocations obtained from one child pool should usually be freed in the
  * same child pool. Freeing an allocation in a different child pool associated
  * to the same parent is allowed (and requires no locking by the caller), but
- * it is discouraged because it implies a performance penalty.
+ * it is discouraged because it implies a performance penalty. Such foreign
+ * frees are collected in a small per-child magazine and handed back to their
+ * owners in batches, so the parent mutex is taken once per batch instead of
+ * once per object. Owners pick up returned objects without locking.
  *
  * For convenience and to ease the transition, there is also a set of wrapper
  * functions around a single parent-child pair.
@@ -47,6 +50,11 @@
 struct slab_element_header;
 struct slab_page_header;
 
+/* Number of foreign objects a child pool collects before returning them
+ * to their owners.
+ */
+#define SLAB_MAGAZINE_SIZE 32
+
 struct slab_parent_pool {
    mtx_t mutex;
    unsigned element_size;
@@ -64,9 +72,35 @@ struct slab_child_pool {
    /* Elements that are owned by this pool but were freed with a different
     * pool as the argument to slab_free.
     *
-    * This list is protected by the parent mutex.
+    * This is a lock-free stack with multiple producers (other child pools
+    * flushing their magazines while holding the parent mutex) and a single
+    * consumer (this pool, which takes the whole list at once without
+    * locking).
     */
    struct slab_element_header *migrated;
+
+   /* Elements owned by other child pools that were freed with this pool as
+    * the argument to slab_free. They are returned to their owners once
+    * SLAB_MAGAZINE_SIZE of them have accumulated.
+    */
+   struct slab_element_header *magazine;
+   unsigned num_magazine;
+
+   /* Statistics; only accessed by the thread using this pool. */
+   unsigned num_pages;
+   unsigned num_free;
+};
+
+struct slab_child_stats {
+   /* Objects allocated from pages of this pool that have not yet come back
+    * to its free list. Objects freed in a different child pool count as in
+    * flight until this pool picks them up again.
+    */
+   unsigned num_in_flight;
+   unsigned num_free;
+   unsigned num_pages;
+   /* Foreign objects waiting in this pool's magazine. */
+   unsigned num_magazine;
 };
 
 void slab_create_parent(struct slab_parent_pool *parent,
@@ -78,6 +112,9 @@ void slab_create_child(struct slab_child_pool *pool,
 void slab_destroy_child(struct slab_child_pool *pool);
 void *slab_alloc(struct slab_child_pool *pool);
 void slab_free(struct slab_child_pool *pool, void *ptr);
+void slab_flush_magazine(struct slab_child_pool *pool);
+void slab_get_child_stats(const struct slab_child_pool *pool,
+                          struct slab_child_stats *stats);
 
 struct slab_mempool {
    struct slab_parent_pool parent;
@@ -0,0 +1,253 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Checks that the vectorized row functions returned by
+ * util_format_description_simd() produce exactly the same bits as the
+ * generated scalar ones.
+ *
+ * Run with -b to also print how fast both versions are.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_math.h"
+
+
+#define MAX_WIDTH 67
+#define HEIGHT 3
+#define BENCH_SIZE 512
+
+
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t
+rand_u32(void)
+{
+   /* xorshift32, so the test is reproducible everywhere */
+   rand_state ^= rand_state << 13;
+   rand_state ^= rand_state >> 17;
+   rand_state ^= rand_state << 5;
+   return rand_state;
+}
+
+static void
+fill_bytes(uint8_t *data, unsigned size)
+{
+   unsigned i;
+
+   for (i = 0; i < size; i++)
+      data[i] = rand_u32();
+}
+
+static void
+fill_floats(float *data, unsigned count)
+{
+   static const float special[] = {
+      0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 1e-30f, 1.0f - 1e-7f,
+      1.0f / 255.0f, 254.5f / 255.0f, INFINITY, -INFINITY, NAN,
+   };
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      uint32_t r = rand_u32();
+
+      if (r % 8 == 0)
+         data[i] = special[(r >> 3) % ARRAY_SIZE(special)];
+      else
+         data[i] = (float)(r >> 8) / (1 << 24) * 1.5f - 0.25f;
+   }
+}
+
+static boolean
+check(const struct util_format_description *desc, const char *func,
+      unsigned width, const void *ref, const void *res, unsigned size)
+{
+   if (memcmp(ref, res, size) == 0)
+      return TRUE;
+
+   printf("FAILED: %s %s width %u\n", desc->short_name, func, width);
+   return FALSE;
+}
+
+static boolean
+test_format(const struct util_format_description *scalar,
+            const struct util_format_description *simd)
+{
+   const unsigned bpp = scalar->block.bits / 8;
+   const unsigned src_stride = MAX_WIDTH * 16 + 4;
+   union {
+      uint8_t ub[HEIGHT * (MAX_WIDTH * 16 + 4)];
+      float f[HEIGHT * (MAX_WIDTH * 4 + 1)];
+   } src;
+   union {
+      uint8_t ub[HEIGHT * MAX_WIDTH * 16];
+      float f[HEIGHT * MAX_WIDTH * 4];
+   } ref, res;
+   boolean success = TRUE;
+   unsigned width;
+
+   for (width = 1; width <= MAX_WIDTH; width++) {
+      if (simd->unpack_rgba_8unorm != scalar->unpack_rgba_8unorm) {
+         fill_bytes(src.ub, sizeof(src));
+         memset(&ref, 0, sizeof(ref));
+         memset(&res, 0, sizeof(res));
+         scalar->unpack_rgba_8unorm(ref.ub, width * 4, src.ub, src_stride,
+                                    width, HEIGHT);
+         simd->unpack_rgba_8unorm(res.ub, width * 4, src.ub, src_stride,
+                                  width, HEIGHT);
+         success &= check(scalar, "unpack_rgba_8unorm", width,
+                          &ref, &res, sizeof(ref));
+      }
+
+      if (simd->pack_rgba_8unorm != scalar->pack_rgba_8unorm) {
+         fill_bytes(src.ub, sizeof(src));
+         memset(&ref, 0, sizeof(ref));
+         memset(&res, 0, sizeof(res));
+         scalar->pack_rgba_8unorm(ref.ub, width * bpp, src.ub, src_stride,
+                                  width, HEIGHT);
+         simd->pack_rgba_8unorm(res.ub, width * bpp, src.ub, src_stride,
+                                width, HEIGHT);
+         success &= check(scalar, "pack_rgba_8unorm", width,
+                          &ref, &res, sizeof(ref));
+      }
+
+      if (simd->unpack_rgba_float != scalar->unpack_rgba_float) {
+         fill_bytes(src.ub, sizeof(src));
+         memset(&ref, 0, sizeof(ref));
+         memset(&res, 0, sizeof(res));
+         scalar->unpack_rgba_float(ref.f, width * 16, src.ub, src_stride,
+                                   width, HEIGHT);
+         simd->unpack_rgba_float(res.f, width * 16, src.ub, src_stride,
+                                 width, HEIGHT);
+         success &= check(scalar, "unpack_rgba_float", width,
+                          &ref, &res, sizeof(ref));
+      }
+
+      if (simd->pack_rgba_float != scalar->pack_rgba_float) {
+         fill_floats(src.f, ARRAY_SIZE(src.f));
+         memset(&ref, 0, sizeof(ref));
+         memset(&res, 0, sizeof(res));
+         scalar->pack_rgba_float(ref.ub, width * bpp, src.f,
+                                 src_stride, width, HEIGHT);
+         simd->pack_rgba_float(res.ub, width * bpp, src.f,
+                               src_stride, width, HEIGHT);
+         success &= check(scalar, "pack_rgba_float", width,
+                          &ref, &res, sizeof(ref));
+      }
+   }
+
+   return success;
+}
+
+static void
+bench_func(const struct util_format_description *desc, const char *name,
+           void (*scalar)(void), void (*simd)(void), void *dst,
+           unsigned dst_stride, const void *src, unsigned src_stride)
+{
+   typedef void (*row_func)(void *, unsigned, const void *, unsigned,
+                            unsigned, unsigned);
+   row_func funcs[2] = { (row_func)scalar, (row_func)simd };
+   int64_t times[2];
+   unsigned i, iter;
+
+   for (i = 0; i < 2; i++) {
+      int64_t start = os_time_get_nano();
+
+      for (iter = 0; iter < 16; iter++)
+         funcs[i](dst, dst_stride, src, src_stride, BENCH_SIZE, BENCH_SIZE);
+
+      times[i] = os_time_get_nano() - start;
+   }
+
+   printf("%-24s %-20s %8.1f -> %8.1f Mpix/s\n", desc->short_name, name,
+          16.0 * BENCH_SIZE * BENCH_SIZE * 1000.0 / MAX2(times[0], 1),
+          16.0 * BENCH_SIZE * BENCH_SIZE * 1000.0 / MAX2(times[1], 1));
+}
+
+static void
+bench_format(const struct util_format_description *scalar,
+             const struct util_format_description *simd,
+             void *pixels, float *floats)
+{
+   const unsigned bpp = scalar->block.bits / 8;
+
+#define BENCH(func, dst, dst_stride, src, src_stride)                     \
+   if (simd->func != scalar->func)                                        \
+      bench_func(scalar, #func, (void (*)(void))scalar->func,             \
+                 (void (*)(void))simd->func, dst, dst_stride,            \
+                 src, src_stride);
+
+   BENCH(unpack_rgba_8unorm, floats, BENCH_SIZE * 4, pixels, BENCH_SIZE * bpp)
+   BENCH(pack_rgba_8unorm, pixels, BENCH_SIZE * bpp, floats, BENCH_SIZE * 4)
+   BENCH(unpack_rgba_float, floats, BENCH_SIZE * 16, pixels, BENCH_SIZE * bpp)
+   BENCH(pack_rgba_float, pixels, BENCH_SIZE * bpp, floats, BENCH_SIZE * 16)
+
+#undef BENCH
+}
+
+int main(int argc, char **argv)
+{
+   const boolean bench = argc > 1 && strcmp(argv[1], "-b") == 0;
+   boolean success = TRUE;
+   void *pixels = NULL;
+   float *floats = NULL;
+   enum pipe_format format;
+
+   if (bench) {
+      pixels = calloc(BENCH_SIZE * BENCH_SIZE, 16);
+      floats = calloc(BENCH_SIZE * BENCH_SIZE, 16);
+      if (!pixels || !floats)
+         return 1;
+      fill_bytes(pixels, BENCH_SIZE * BENCH_SIZE * 16);
+      fill_floats(floats, BENCH_SIZE * BENCH_SIZE * 4);
+   }
+
+   for (format = 1; format < PIPE_FORMAT_COUNT; ++format) {
+      const struct util_format_description *scalar =
+         util_format_description(format);
+      const struct util_format_description *simd =
+         util_format_description_simd(format);
+
+      if (!scalar || simd == scalar)
+         continue;
+
+      success &= test_format(scalar, simd);
+
+      if (bench)
+         bench_format(scalar, simd, pixels, floats);
+   }
+
+   free(pixels);
+   free(floats);
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include <gtest/gtest.h>
+#include "util/blob.h"
+#include "util/ralloc.h"
+#include "util/register_allocate.h"
+
+/* A register file of 16 registers plus 8 aligned pairs aliasing them, in the
+ * style of most drivers.
+ */
+#define NUM_REGS 16
+#define NUM_PAIRS (NUM_REGS / 2)
+
+static struct ra_regs *
+create_reg_set(void *mem_ctx, unsigned *class_single, unsigned *class_pair)
+{
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, NUM_REGS + NUM_PAIRS,
+                                           true);
+
+   *class_single = ra_alloc_reg_class(regs);
+   *class_pair = ra_alloc_reg_class(regs);
+
+   for (unsigned i = 0; i < NUM_REGS; i++)
+      ra_class_add_reg(regs, *class_single, i);
+
+   for (unsigned i = 0; i < NUM_PAIRS; i++) {
+      unsigned pair = NUM_REGS + i;
+      ra_class_add_reg(regs, *class_pair, pair);
+      ra_add_reg_conflict(regs, pair, 2 * i);
+      ra_add_reg_conflict(regs, pair, 2 * i + 1);
+   }
+
+   ra_set_finalize(regs, NULL);
+   return regs;
+}
+
+/* Allocates a chain of overlapping live ranges alternating between single
+ * and pair registers and returns the assigned registers.
+ */
+static void
+allocate_chain(struct ra_regs *regs, unsigned class_single,
+               unsigned class_pair, unsigned *out, unsigned count)
+{
+   struct ra_graph *g = ra_alloc_interference_graph(regs, count);
+
+   for (unsigned i = 0; i < count; i++)
+      ra_set_node_class(g, i, (i % 3) ? class_single : class_pair);
+
+   for (unsigned i = 0; i < count; i++) {
+      for (unsigned j = i + 1; j < MIN2(i + 4, count); j++)
+         ra_add_node_interference(g, i, j);
+   }
+
+   ASSERT_TRUE(ra_allocate(g));
+
+   for (unsigned i = 0; i < count; i++)
+      out[i] = ra_get_node_reg(g, i);
+
+   ralloc_free(g);
+}
+
+TEST(register_allocate, serialize_round_trip)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned class_single, class_pair;
+   struct ra_regs *regs = create_reg_set(mem_ctx, &class_single, &class_pair);
+
+   struct blob blob;
+   blob_init(&blob);
+   ra_set_serialize(regs, &blob);
+   ASSERT_FALSE(blob.out_of_memory);
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   struct ra_regs *copy = ra_set_deserialize(mem_ctx, &reader);
+   ASSERT_TRUE(copy != NULL);
+   EXPECT_EQ(reader.current, reader.end);
+
+   /* A deserialized set serializes to exactly the same bytes. */
+   struct blob blob2;
+   blob_init(&blob2);
+   ra_set_serialize(copy, &blob2);
+   ASSERT_EQ(blob.size, blob2.size);
+   EXPECT_EQ(memcmp(blob.data, blob2.data, blob.size), 0);
+
+   unsigned a[24], b[24];
+   allocate_chain(regs, class_single, class_pair, a, ARRAY_SIZE(a));
+   allocate_chain(copy, class_single, class_pair, b, ARRAY_SIZE(b));
+   for (unsigned i = 0; i < ARRAY_SIZE(a); i++)
+      EXPECT_EQ(a[i], b[i]);
+
+   blob_finish(&blob);
+   blob_finish(&blob2);
+   ralloc_free(mem_ctx);
+}
+
+TEST(register_allocate, deserialize_truncated)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned class_single, class_pair;
+   struct ra_regs *regs = create_reg_set(mem_ctx, &class_single, &class_pair);
+
+   struct blob blob;
+   blob_init(&blob);
+   ra_set_serialize(regs, &blob);
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size - 1);
+   EXPECT_TRUE(ra_set_deserialize(mem_ctx, &reader) == NULL);
+
+   blob_finish(&blob);
+   ralloc_free(mem_ctx);
+}
+
+TEST(register_allocate, deserialize_bad_counts)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned class_single, class_pair;
+   struct ra_regs *regs = create_reg_set(mem_ctx, &class_single, &class_pair);
+
+   struct blob blob;
+   blob_init(&blob);
+   ra_set_serialize(regs, &blob);
+
+   /* Register and class counts that don't fit in the blob must be rejected
+    * before anything is allocated for them.
+    */
+   const uint32_t bad_counts[][2] = {
+      { UINT32_MAX, 2 },
+      { NUM_REGS + NUM_PAIRS, UINT32_MAX },
+      { NUM_REGS + NUM_PAIRS + 1, 2 },
+      { NUM_REGS + NUM_PAIRS, 3 },
+   };
+
+   for (unsigned i = 0; i < ARRAY_SIZE(bad_counts); i++) {
+      blob_overwrite_uint32(&blob, 2 * sizeof(uint32_t), bad_counts[i][0]);
+      blob_overwrite_uint32(&blob, 3 * sizeof(uint32_t), bad_counts[i][1]);
+
+      struct blob_reader reader;
+      blob_reader_init(&reader, blob.data, blob.size);
+      EXPECT_TRUE(ra_set_deserialize(mem_ctx, &reader) == NULL);
+      EXPECT_TRUE(reader.overrun);
+   }
+
+   blob_finish(&blob);
+   ralloc_free(mem_ctx);
+}
+
+TEST(register_allocate, deserialize_bad_header)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned class_single, class_pair;
+   struct ra_regs *regs = create_reg_set(mem_ctx, &class_single, &class_pair);
+
+   struct blob blob;
+   blob_init(&blob);
+   ra_set_serialize(regs, &blob);
+
+   /* A wrong magic number or layout version must be rejected. */
+   for (unsigned i = 0; i < 2; i++) {
+      uint32_t orig;
+      memcpy(&orig, blob.data + i * sizeof(uint32_t), sizeof(orig));
+      blob_overwrite_uint32(&blob, i * sizeof(uint32_t), orig + 1);
+
+      struct blob_reader reader;
+      blob_reader_init(&reader, blob.data, blob.size);
+      EXPECT_TRUE(ra_set_deserialize(mem_ctx, &reader) == NULL);
+
+      blob_overwrite_uint32(&blob, i * sizeof(uint32_t), orig);
+   }
+
+   blob_finish(&blob);
+   ralloc_free(mem_ctx);
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#undef NDEBUG
+
+#include "util/slab.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "c11/threads.h"
+
+#define NUM_THREADS 8
+#define NUM_RUNS 16
+#define NUM_OBJECTS (1 << 12)
+
+struct test_state {
+   struct slab_parent_pool *parent;
+   void **objects;
+   unsigned num_objects;
+};
+
+/* Each thread frees half of the objects of its neighbour through its own
+ * child pool and allocates new objects at the same time.
+ */
+static int
+test_thread(void *_state)
+{
+   struct test_state *state = _state;
+   struct slab_child_pool pool;
+   void *local[NUM_OBJECTS / 2];
+
+   slab_create_child(&pool, state->parent);
+
+   for (unsigned i = 0; i < state->num_objects; i++) {
+      uint32_t *obj = state->objects[i];
+      assert(*obj == i);
+      slab_free(&pool, obj);
+
+      if (i < NUM_OBJECTS / 2) {
+         local[i] = slab_alloc(&pool);
+         assert(local[i]);
+      }
+   }
+
+   for (unsigned i = 0; i < NUM_OBJECTS / 2; i++)
+      slab_free(&pool, local[i]);
+
+   struct slab_child_stats stats;
+   slab_get_child_stats(&pool, &stats);
+   assert(stats.num_in_flight == 0);
+
+   slab_destroy_child(&pool);
+   return 0;
+}
+
+static void
+run_test(unsigned run_idx)
+{
+   struct slab_parent_pool parent;
+   struct slab_child_pool owners[NUM_THREADS];
+   struct test_state states[NUM_THREADS];
+   void *objects[NUM_THREADS][NUM_OBJECTS];
+   thrd_t threads[NUM_THREADS];
+
+   slab_create_parent(&parent, sizeof(uint32_t), 1 + run_idx * 8);
+
+   for (unsigned t = 0; t < NUM_THREADS; t++) {
+      slab_create_child(&owners[t], &parent);
+      for (unsigned i = 0; i < NUM_OBJECTS; i++) {
+         uint32_t *obj = slab_alloc(&owners[t]);
+         assert(obj);
+         *obj = i;
+         objects[t][i] = obj;
+      }
+   }
+
+   for (unsigned t = 0; t < NUM_THREADS; t++) {
+      states[t].parent = &parent;
+      states[t].objects = objects[t];
+      states[t].num_objects = NUM_OBJECTS / 2;
+      int ret = thrd_create(&threads[t], test_thread, &states[t]);
+      assert(ret == thrd_success);
+   }
+
+   /* Destroy the owners of odd threads while the objects are still being
+    * freed by other threads; their pages must become orphans.
+    */
+   for (unsigned t = 1; t < NUM_THREADS; t += 2)
+      slab_destroy_child(&owners[t]);
+
+   for (unsigned t = 0; t < NUM_THREADS; t++) {
+      int ret = thrd_join(threads[t], NULL);
+      assert(ret == thrd_success);
+   }
+
+   /* The remaining owners reclaim the migrated objects without locking. */
+   for (unsigned t = 0; t < NUM_THREADS; t += 2) {
+      struct slab_child_stats stats;
+
+      for (unsigned i = NUM_OBJECTS / 2; i < NUM_OBJECTS; i++)
+         slab_free(&owners[t], objects[t][i]);
+
+      for (unsigned i = 0; i < NUM_OBJECTS; i++)
+         objects[t][i] = slab_alloc(&owners[t]);
+
+      slab_get_child_stats(&owners[t], &stats);
+      assert(stats.num_in_flight == NUM_OBJECTS);
+
+      for (unsigned i = 0; i < NUM_OBJECTS; i++)
+         slab_free(&owners[t], objects[t][i]);
+
+      slab_get_child_stats(&owners[t], &stats);
+      assert(stats.num_in_flight == 0);
+
+      slab_destroy_child(&owners[t]);
+   }
+
+   /* Remaining objects of destroyed owners. */
+   for (unsigned t = 1; t < NUM_THREADS; t += 2) {
+      struct slab_child_pool pool;
+
+      slab_create_child(&pool, &parent);
+      for (unsigned i = NUM_OBJECTS / 2; i < NUM_OBJECTS; i++)
+         slab_free(&pool, objects[t][i]);
+      slab_destroy_child(&pool);
+   }
+
+   slab_destroy_parent(&parent);
+}
+
+int
+main(int argc, char **argv)
+{
+   for (unsigned i = 0; i < NUM_RUNS; i++)
+      run_test(i);
+
+   return 0;
+}